@@ -51,6 +51,17 @@ void Fatal(const char* format , ...);
 #endif
 unsigned int LoadTexBMP(const char* file);
 unsigned int LoadTexBMP32(const char* file); // Loads bmp with alpha values 
+// One entry for LoadTexBatch: the texture name is stored in *tex
+typedef struct
+{
+   unsigned int* tex;
+   const char* file;
+   int alpha;  // 32-bit bmp with alpha values (as LoadTexBMP32)
+   int mipmap; // build mip chain, trilinear filtering
+   float aniso; // maximum anisotropy (0 = off)
+} TexRequest;
+void LoadTexBatch(TexRequest* list,int n);
+void LoadTexCache(const char* dir,int s3tc); // cook textures into dir (NULL = off)
 void ErrCheck(const char* where);
 int  LoadOBJ(const char* file);
 
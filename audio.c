@@ -0,0 +1,375 @@
+//  In-process sound effects
+//  Kevin McMahon
+#include "CSCIx229.h"
+#include "audio.h"
+#ifndef _WIN32
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#ifdef __linux__
+#include <dlfcn.h>
+#endif
+#endif
+
+#define AUDIO_PERIOD 512   // frames mixed per pass (~12 ms)
+#define AUDIO_QUEUE  64    // pending AudioPlay commands
+#define AUDIO_SOUNDS 16    // decoded sounds
+
+// Decoded sound: interleaved stereo at AUDIO_RATE
+typedef struct
+{
+   short* pcm;
+   int frames;
+} Sound;
+static Sound sound[AUDIO_SOUNDS];
+static int nsound = 0;
+
+//
+//  Little endian fields (WAV byte order on any host)
+//
+static unsigned int Get16(const unsigned char* p)
+{
+   return p[0] | (p[1]<<8);
+}
+static unsigned int Get32(const unsigned char* p)
+{
+   return p[0] | (p[1]<<8) | (p[2]<<16) | ((unsigned int)p[3]<<24);
+}
+
+//
+//  One channel of one frame as signed 16 bits
+//
+static int Sample(const unsigned char* p,int bits)
+{
+   return bits==8 ? (p[0]-128)<<8 : (short)Get16(p);
+}
+
+//
+//  Decode a PCM WAV file (8 or 16 bits, mono or stereo, any rate) once
+//  into the mixer format; returns the sound id for AudioPlay
+//
+int AudioLoad(const char* file)
+{
+   if (nsound>=AUDIO_SOUNDS) Fatal("Too many sounds loading %s\n",file);
+   //  Read the whole file
+   FILE* f = fopen(file,"rb");
+   if (!f) Fatal("Cannot open sound %s\n",file);
+   fseek(f,0,SEEK_END);
+   long n = ftell(f);
+   rewind(f);
+   unsigned char* wav = n>12 ? (unsigned char*)malloc(n) : NULL;
+   if (!wav || fread(wav,n,1,f)!=1) Fatal("Cannot read sound %s\n",file);
+   fclose(f);
+   if (memcmp(wav,"RIFF",4) || memcmp(wav+8,"WAVE",4)) Fatal("%s is not a WAV file\n",file);
+
+   //  Walk the chunks for the format and the samples
+   const unsigned char* data = NULL;
+   unsigned int len = 0,channels = 0,rate = 0,bits = 0;
+   for (long k=12;k+8<=n;)
+   {
+      unsigned int size = Get32(wav+k+4);
+      if (size>n-k-8) size = n-k-8;
+      if (!memcmp(wav+k,"fmt ",4) && size>=16)
+      {
+         if (Get16(wav+k+8)!=1) Fatal("%s is not PCM\n",file);
+         channels = Get16(wav+k+10);
+         rate     = Get32(wav+k+12);
+         bits     = Get16(wav+k+22);
+      }
+      else if (!memcmp(wav+k,"data",4))
+      {
+         data = wav+k+8;
+         len = size;
+      }
+      k += 8 + size + (size&1);
+   }
+   if (!data || !rate) Fatal("%s has no PCM data\n",file);
+   if (channels<1 || channels>2 || (bits!=8 && bits!=16))
+      Fatal("%s: %d channels of %d bits not supported\n",file,channels,bits);
+
+   //  Convert to stereo 16 bits at the mixer rate (nearest sample)
+   int stride = channels*bits/8;
+   long in = len/stride;
+   long out = (long)((long long)in*AUDIO_RATE/rate);
+   short* pcm = (short*)malloc(2*out*sizeof(short));
+   if (!pcm) Fatal("Cannot allocate %ld frames for %s\n",out,file);
+   for (long i=0;i<out;i++)
+   {
+      const unsigned char* p = data + (long long)i*rate/AUDIO_RATE*stride;
+      pcm[2*i]   = Sample(p,bits);
+      pcm[2*i+1] = Sample(p+stride-bits/8,bits);
+   }
+   free(wav);
+   sound[nsound].pcm = pcm;
+   sound[nsound].frames = out;
+   return nsound++;
+}
+
+#ifdef _WIN32
+//  No mixer thread on Windows: callers keep their own playback
+int  AudioInit(const char* sink) {return 0;}
+void AudioPlay(int id,float gain) {}
+void AudioShutdown(void) {}
+#else
+
+//  Play commands: single producer (AudioPlay), single consumer (mixer)
+typedef struct
+{
+   int sound;
+   float gain;
+} AudioCmd;
+static AudioCmd queue[AUDIO_QUEUE];
+static atomic_uint queueHead;   // next slot to fill, written by AudioPlay
+static atomic_uint queueTail;   // next slot to play, written by the mixer
+
+//  One-shots being mixed
+typedef struct
+{
+   int sound;     // -1 when free
+   int pos;       // next frame
+   int gain;      // 1/256 units
+} Voice;
+static Voice voice[AUDIO_VOICES];
+
+//  Output
+enum {SINK_NULL,SINK_WAV,SINK_ALSA};
+static int sinkType;
+static FILE* sinkFile;
+static long sinkFrames;
+static pthread_t mixer;
+static atomic_int running;
+
+#ifdef __linux__
+//  The few libasound entry points used, resolved at run time so the build
+//  needs no ALSA headers and the program runs where libasound is missing
+typedef struct _snd_pcm snd_pcm_t;
+#define SND_PCM_STREAM_PLAYBACK       0
+#define SND_PCM_FORMAT_S16_LE         2
+#define SND_PCM_ACCESS_RW_INTERLEAVED 3
+static void* alsaLib;
+static snd_pcm_t* pcm;
+static int  (*snd_pcm_open_)(snd_pcm_t**,const char*,int,int);
+static int  (*snd_pcm_set_params_)(snd_pcm_t*,int,int,unsigned int,unsigned int,int,unsigned int);
+static long (*snd_pcm_writei_)(snd_pcm_t*,const void*,unsigned long);
+static int  (*snd_pcm_recover_)(snd_pcm_t*,int,int);
+static int  (*snd_pcm_close_)(snd_pcm_t*);
+
+//
+//  Open the default ALSA device (0 if there is none)
+//
+static int AlsaOpen(void)
+{
+   alsaLib = dlopen("libasound.so.2",RTLD_NOW);
+   if (!alsaLib) return 0;
+   snd_pcm_open_       = dlsym(alsaLib,"snd_pcm_open");
+   snd_pcm_set_params_ = dlsym(alsaLib,"snd_pcm_set_params");
+   snd_pcm_writei_     = dlsym(alsaLib,"snd_pcm_writei");
+   snd_pcm_recover_    = dlsym(alsaLib,"snd_pcm_recover");
+   snd_pcm_close_      = dlsym(alsaLib,"snd_pcm_close");
+   if (!snd_pcm_open_ || !snd_pcm_set_params_ || !snd_pcm_writei_ || !snd_pcm_recover_ || !snd_pcm_close_ ||
+       snd_pcm_open_(&pcm,"default",SND_PCM_STREAM_PLAYBACK,0)<0)
+   {
+      dlclose(alsaLib);
+      return 0;
+   }
+   //  Stereo 16-bit with ~50 ms of buffering
+   if (snd_pcm_set_params_(pcm,SND_PCM_FORMAT_S16_LE,SND_PCM_ACCESS_RW_INTERLEAVED,2,AUDIO_RATE,1,50000)<0)
+   {
+      snd_pcm_close_(pcm);
+      dlclose(alsaLib);
+      return 0;
+   }
+   return 1;
+}
+#endif
+
+//
+//  Seconds on a monotonic clock
+//
+static double Now(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC,&ts);
+   return ts.tv_sec + 1e-9*ts.tv_nsec;
+}
+
+//
+//  Canonical 44 byte WAV header for the frames written so far
+//
+static void WavHeader(FILE* f,long frames)
+{
+   unsigned int data = frames*4;
+   unsigned char h[44] = {'R','I','F','F',0,0,0,0,'W','A','V','E','f','m','t',' ',16,0,0,0,
+                          1,0,2,0,0,0,0,0,0,0,0,0,4,0,16,0,'d','a','t','a'};
+   unsigned int v[4][2] = {{4,36+data},{24,AUDIO_RATE},{28,AUDIO_RATE*4},{40,data}};
+   for (int k=0;k<4;k++)
+      for (int b=0;b<4;b++)
+         h[v[k][0]+b] = v[k][1]>>(8*b);
+   fseek(f,0,SEEK_SET);
+   fwrite(h,sizeof(h),1,f);
+}
+
+//
+//  Hand one period to the sink; ALSA paces by blocking, the others sleep
+//  to the period deadline so they run in real time too
+//
+static void SinkWrite(short* buf,double* deadline)
+{
+#ifdef __linux__
+   if (sinkType==SINK_ALSA)
+   {
+      long n = snd_pcm_writei_(pcm,buf,AUDIO_PERIOD);
+      if (n<0 && snd_pcm_recover_(pcm,(int)n,1)<0)
+      {
+         //  Device went away: keep mixing into nothing
+         snd_pcm_close_(pcm);
+         sinkType = SINK_NULL;
+         *deadline = Now();
+      }
+      return;
+   }
+#endif
+   if (sinkType==SINK_WAV)
+   {
+      //  Samples are written in host order (little endian on our targets)
+      fwrite(buf,4,AUDIO_PERIOD,sinkFile);
+      sinkFrames += AUDIO_PERIOD;
+   }
+   *deadline += (double)AUDIO_PERIOD/AUDIO_RATE;
+   double wait = *deadline - Now();
+   if (wait>0)
+   {
+      struct timespec ts = {(time_t)wait,(long)(1e9*(wait-(time_t)wait))};
+      nanosleep(&ts,NULL);
+   }
+}
+
+//
+//  Mixer thread: start queued one-shots, sum the voices, clip, output
+//
+static void* Mixer(void* arg)
+{
+   static int acc[2*AUDIO_PERIOD];
+   static short out[2*AUDIO_PERIOD];
+   double deadline = Now();
+   while (atomic_load(&running))
+   {
+      //  Drain the command queue
+      unsigned int tail = atomic_load_explicit(&queueTail,memory_order_relaxed);
+      unsigned int head = atomic_load_explicit(&queueHead,memory_order_acquire);
+      for (;tail!=head;tail++)
+      {
+         AudioCmd* c = queue + tail%AUDIO_QUEUE;
+         //  Free voice, else the one furthest along
+         int v = 0;
+         for (int k=0;k<AUDIO_VOICES;k++)
+            if (voice[k].sound<0 || (voice[v].sound>=0 && voice[k].pos>voice[v].pos)) v = k;
+         voice[v].sound = c->sound;
+         voice[v].pos = 0;
+         voice[v].gain = (int)(256*c->gain);
+      }
+      atomic_store_explicit(&queueTail,tail,memory_order_release);
+
+      //  Sum the voices
+      memset(acc,0,sizeof(acc));
+      for (int k=0;k<AUDIO_VOICES;k++)
+      {
+         Voice* v = voice+k;
+         if (v->sound<0) continue;
+         const Sound* s = sound + v->sound;
+         int n = s->frames - v->pos;
+         if (n>AUDIO_PERIOD) n = AUDIO_PERIOD;
+         const short* p = s->pcm + 2*v->pos;
+         for (int i=0;i<2*n;i++)
+            acc[i] += (p[i]*v->gain)>>8;
+         v->pos += n;
+         if (v->pos>=s->frames) v->sound = -1;
+      }
+      for (int i=0;i<2*AUDIO_PERIOD;i++)
+         out[i] = acc[i]>32767 ? 32767 : acc[i]<-32768 ? -32768 : acc[i];
+      SinkWrite(out,&deadline);
+   }
+   return NULL;
+}
+
+//
+//  Open the sink and start the mixer thread (1 if running, 0 if the sink
+//  cannot be opened)
+//
+int AudioInit(const char* sink)
+{
+   if (atomic_load(&running)) return 1;
+#ifdef __linux__
+   if (!sink) sink = "alsa";
+#else
+   if (!sink) return 0;
+#endif
+   if (!strcmp(sink,"alsa"))
+   {
+#ifdef __linux__
+      if (!AlsaOpen())
+      {
+         fprintf(stderr,"Cannot open the ALSA default device, no audio mixer\n");
+         return 0;
+      }
+      sinkType = SINK_ALSA;
+#else
+      return 0;
+#endif
+   }
+   else if (!strncmp(sink,"wav:",4))
+   {
+      sinkFile = fopen(sink+4,"wb");
+      if (!sinkFile) Fatal("Cannot open audio file %s\n",sink+4);
+      WavHeader(sinkFile,0);
+      sinkFrames = 0;
+      sinkType = SINK_WAV;
+   }
+   else if (!strcmp(sink,"null"))
+      sinkType = SINK_NULL;
+   else
+      Fatal("Unknown audio sink %s (alsa, null or wav:FILE)\n",sink);
+
+   for (int k=0;k<AUDIO_VOICES;k++)
+      voice[k].sound = -1;
+   atomic_store(&running,1);
+   if (pthread_create(&mixer,NULL,Mixer,NULL)) Fatal("Cannot start audio mixer thread\n");
+   return 1;
+}
+
+//
+//  Queue a one-shot (call from one thread only); dropped if the queue is full
+//
+void AudioPlay(int id,float gain)
+{
+   if (id<0 || id>=nsound || !atomic_load_explicit(&running,memory_order_relaxed)) return;
+   unsigned int head = atomic_load_explicit(&queueHead,memory_order_relaxed);
+   unsigned int tail = atomic_load_explicit(&queueTail,memory_order_acquire);
+   if (head-tail>=AUDIO_QUEUE) return;
+   queue[head%AUDIO_QUEUE].sound = id;
+   queue[head%AUDIO_QUEUE].gain = gain;
+   atomic_store_explicit(&queueHead,head+1,memory_order_release);
+}
+
+//
+//  Stop the mixer and close the sink (finishes the WAV header)
+//
+void AudioShutdown(void)
+{
+   if (!atomic_load(&running)) return;
+   atomic_store(&running,0);
+   pthread_join(mixer,NULL);
+#ifdef __linux__
+   if (sinkType==SINK_ALSA)
+   {
+      snd_pcm_close_(pcm);
+      dlclose(alsaLib);
+   }
+#endif
+   if (sinkType==SINK_WAV)
+   {
+      WavHeader(sinkFile,sinkFrames);
+      fclose(sinkFile);
+   }
+}
+#endif
@@ -0,0 +1,38 @@
+#ifndef AUDIO_H
+#define AUDIO_H
+
+//
+//  In-process sound effects
+//  Kevin McMahon
+//
+//  WAV files are decoded once into 44.1 kHz stereo 16-bit samples.  A
+//  mixer thread sums every playing one-shot and feeds a sink; AudioPlay()
+//  only pushes a command onto a lock-free queue, so the render thread
+//  never blocks on audio.
+//
+//  Sinks (AudioInit argument, NULL picks the platform default):
+//    "alsa"        default PCM device (libasound is loaded at run time)
+//    "null"        mix and discard, paced in real time
+//    "wav:FILE"    record the mix to FILE, paced in real time
+//  The default is ALSA on Linux.  When no device can be opened, and on
+//  other platforms without a sink named, AudioInit returns 0 and no mixer
+//  thread runs.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUDIO_RATE   44100
+#define AUDIO_VOICES 16     // one-shots mixed at once (oldest is replaced)
+
+int  AudioInit(const char* sink);
+int  AudioLoad(const char* file);
+void AudioPlay(int sound,float gain);
+void AudioShutdown(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
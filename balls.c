@@ -0,0 +1,413 @@
+//  Pooled basketballs with simple rigid-body physics
+//  Kevin McMahon
+#include "CSCIx229.h"
+#include "capture.h"
+#include "balls.h"
+
+//  Restitution (fraction of the normal speed kept by a bounce)
+#define E_FLOOR 0.75f
+#define E_WALL  0.50f
+#define E_RIM   0.55f
+#define E_BOARD 0.65f
+#define E_BALL  0.80f
+#define MU      0.50f   // floor friction against the contact speed
+#define ROLL    0.60f   // rolling resistance on the floor (1/s)
+#define REST    0.25f   // bounces slower than this stop
+
+//
+//  Allocate room for max balls
+//
+void BallInit(BallPool* pool,int max,float radius,float gravity)
+{
+   float** f[] = {&pool->px,&pool->py,&pool->pz,&pool->vx,&pool->vy,&pool->vz,
+                  &pool->heading,&pool->spin,&pool->spinRate,&pool->age,&pool->life,&pool->lastY};
+   for (int k=0;k<(int)(sizeof(f)/sizeof(f[0]));k++)
+   {
+      *f[k] = (float*)malloc(max*sizeof(float));
+      if (!*f[k]) Fatal("Cannot allocate pool for %d balls\n",max);
+   }
+   pool->tag = (int*)malloc(max*sizeof(int));
+   pool->lod = (unsigned char*)malloc(max);
+   pool->order = (int*)malloc(max*sizeof(int));
+   pool->key = (int*)malloc(max*sizeof(int));
+   pool->make = (BallMake*)malloc(max*sizeof(BallMake));
+   if (!pool->tag || !pool->lod || !pool->order || !pool->key || !pool->make) Fatal("Cannot allocate pool for %d balls\n",max);
+   pool->n = 0;
+   pool->max = max;
+   pool->radius = radius;
+   pool->gravity = gravity;
+   pool->nhoop = 0;
+   pool->nmake = 0;
+   //  No walls until BallArena
+   for (int k=0;k<3;k++)
+   {
+      pool->lo[k] = -1e30;
+      pool->hi[k] = +1e30;
+   }
+   pool->lo[1] = 0;
+}
+
+//
+//  Floor height and walls
+//
+void BallArena(BallPool* pool,const float lo[3],const float hi[3])
+{
+   for (int k=0;k<3;k++)
+   {
+      pool->lo[k] = lo[k];
+      pool->hi[k] = hi[k];
+   }
+}
+
+//
+//  Add a hoop; returns its index for BallMake
+//
+int BallAddHoop(BallPool* pool,const float rim[3],float rimR,float rimTube,const float boardLo[3],const float boardHi[3])
+{
+   if (pool->nhoop==BALL_MAX_HOOPS) Fatal("Too many hoops (max %d)\n",BALL_MAX_HOOPS);
+   BallHoop* h = pool->hoop + pool->nhoop;
+   for (int k=0;k<3;k++)
+   {
+      h->rim[k] = rim[k];
+      h->boardLo[k] = boardLo[k];
+      h->boardHi[k] = boardHi[k];
+   }
+   h->rimR = rimR;
+   h->rimTube = rimTube;
+   //  Bounds of the rim and board, grown by a ball
+   float reach = rimR + rimTube + pool->radius;
+   for (int k=0;k<3;k++)
+   {
+      float e = k==1 ? rimTube + pool->radius : reach;
+      h->lo[k] = fminf(rim[k]-e,boardLo[k]-pool->radius);
+      h->hi[k] = fmaxf(rim[k]+e,boardHi[k]+pool->radius);
+   }
+   return pool->nhoop++;
+}
+
+//
+//  Throw a ball from start so it reaches target t seconds later (ignoring
+//  anything in the way).  Returns its slot, or -1 when the pool is full.
+//
+int BallLaunch(BallPool* pool,const float start[3],const float target[3],float t,float spinRate,float life,int tag)
+{
+   if (pool->n==pool->max || t<=0) return -1;
+   int i = pool->n++;
+   pool->px[i] = start[0];
+   pool->py[i] = start[1];
+   pool->pz[i] = start[2];
+   pool->vx[i] = (target[0]-start[0])/t;
+   pool->vy[i] = (target[1]-start[1])/t - 0.5f*pool->gravity*t;
+   pool->vz[i] = (target[2]-start[2])/t;
+   pool->heading[i] = atan2(-pool->vz[i],pool->vx[i])*180/M_PI;
+   pool->spin[i] = 0;
+   pool->spinRate[i] = spinRate;
+   pool->age[i] = 0;
+   pool->life[i] = life;
+   pool->tag[i] = tag;
+   pool->lod[i] = 0;
+   return i;
+}
+
+//
+//  Push ball i out along unit normal n to distance d from the contact
+//  point q and reflect its approach speed with restitution e
+//
+static void Bounce(BallPool* pool,int i,const float q[3],const float n[3],float d,float e)
+{
+   pool->px[i] = q[0] + n[0]*d;
+   pool->py[i] = q[1] + n[1]*d;
+   pool->pz[i] = q[2] + n[2]*d;
+   float vn = pool->vx[i]*n[0] + pool->vy[i]*n[1] + pool->vz[i]*n[2];
+   if (vn>=0) return;
+   pool->vx[i] -= (1+e)*vn*n[0];
+   pool->vy[i] -= (1+e)*vn*n[1];
+   pool->vz[i] -= (1+e)*vn*n[2];
+}
+
+//
+//  Floor: bounce, then friction between the contact point and the floor
+//  along the launch heading turns backspin into forward speed (and the
+//  other way round) until the ball rolls
+//
+static void Floor(BallPool* pool,int i,float dt)
+{
+   const float r = pool->radius;
+   float y = pool->lo[1] + r;
+   if (pool->py[i]>=y) return;
+   pool->py[i] = y;
+   float vn = -pool->vy[i];
+   if (vn<=0) return;
+   pool->vy[i] = E_FLOOR*vn>REST ? E_FLOOR*vn : 0;
+
+   float hx = cosf(pool->heading[i]*(M_PI/180));
+   float hz = -sinf(pool->heading[i]*(M_PI/180));
+   float fwd = pool->vx[i]*hx + pool->vz[i]*hz;
+   float wr = pool->spinRate[i]*(M_PI/180)*r;
+   //  A hollow ball: the impulse that stops the contact point slows the
+   //  center by J and the surface by 1.5 J
+   float J = (fwd+wr)/2.5f;
+   float Jmax = MU*(1+E_FLOOR)*vn;
+   if (J>Jmax) J = Jmax;
+   if (J<-Jmax) J = -Jmax;
+   pool->vx[i] -= J*hx;
+   pool->vz[i] -= J*hz;
+   pool->spinRate[i] -= 1.5f*J/r*(180/M_PI);
+   //  Rolling resistance
+   float k = 1 - ROLL*dt;
+   pool->vx[i] *= k;
+   pool->vz[i] *= k;
+   pool->spinRate[i] *= k;
+}
+
+//
+//  Walls: keep the ball inside lo..hi in x and z
+//
+static void Walls(BallPool* pool,int i)
+{
+   const float r = pool->radius;
+   float* p[2] = {pool->px,pool->pz};
+   float* v[2] = {pool->vx,pool->vz};
+   for (int a=0;a<2;a++)
+   {
+      int k = 2*a;
+      if (p[a][i]<pool->lo[k]+r)
+      {
+         p[a][i] = pool->lo[k]+r;
+         if (v[a][i]<0) v[a][i] *= -E_WALL;
+      }
+      else if (p[a][i]>pool->hi[k]-r)
+      {
+         p[a][i] = pool->hi[k]-r;
+         if (v[a][i]>0) v[a][i] *= -E_WALL;
+      }
+   }
+}
+
+//
+//  Rim, backboard and the make test for one hoop
+//
+static void Hoop(BallPool* pool,int i,int hi)
+{
+   const BallHoop* h = pool->hoop + hi;
+   const float r = pool->radius;
+   float dx = pool->px[i] - h->rim[0];
+   float dy = pool->py[i] - h->rim[1];
+   float dz = pool->pz[i] - h->rim[2];
+   //  Nowhere near this hoop (the make test needs the step's start too)
+   if (pool->px[i]<h->lo[0] || pool->px[i]>h->hi[0] || pool->pz[i]<h->lo[2] || pool->pz[i]>h->hi[2] ||
+       fmaxf(pool->py[i],pool->lastY[i])<h->lo[1] || pool->py[i]>h->hi[1])
+      return;
+
+   //  Center dropped through the rim plane inside the ring
+   if (pool->lastY[i]>h->rim[1] && pool->py[i]<=h->rim[1] && dx*dx+dz*dz<h->rimR*h->rimR)
+   {
+      BallMake* m = pool->make + pool->nmake++;
+      m->tag = pool->tag[i];
+      m->hoop = hi;
+   }
+
+   //  Rim: nearest point on the tube's center circle
+   float rho = sqrtf(dx*dx+dz*dz);
+   if (fabsf(dy)<h->rimTube+r && fabsf(rho-h->rimR)<h->rimTube+r)
+   {
+      float q[3] = {h->rim[0]+h->rimR,h->rim[1],h->rim[2]};
+      if (rho>1e-6f)
+      {
+         q[0] = h->rim[0] + h->rimR*dx/rho;
+         q[2] = h->rim[2] + h->rimR*dz/rho;
+      }
+      float w[3] = {pool->px[i]-q[0],pool->py[i]-q[1],pool->pz[i]-q[2]};
+      float d = sqrtf(w[0]*w[0]+w[1]*w[1]+w[2]*w[2]);
+      if (d<h->rimTube+r && d>1e-6f)
+      {
+         float n[3] = {w[0]/d,w[1]/d,w[2]/d};
+         Bounce(pool,i,q,n,h->rimTube+r,E_RIM);
+      }
+   }
+
+   //  Backboard: nearest point of the box
+   float p[3] = {pool->px[i],pool->py[i],pool->pz[i]};
+   float q[3],w[3];
+   for (int k=0;k<3;k++)
+   {
+      q[k] = p[k]<h->boardLo[k] ? h->boardLo[k] : p[k]>h->boardHi[k] ? h->boardHi[k] : p[k];
+      w[k] = p[k]-q[k];
+   }
+   float d2 = w[0]*w[0]+w[1]*w[1]+w[2]*w[2];
+   if (d2<r*r)
+   {
+      float n[3] = {1,0,0};
+      float d = sqrtf(d2);
+      if (d>1e-6f)
+         for (int k=0;k<3;k++)
+            n[k] = w[k]/d;
+      else if (h->rim[0]<q[0])
+         n[0] = -1;   // center inside the board: out the court side
+      Bounce(pool,i,q,n,r,E_BOARD);
+   }
+}
+
+//
+//  Broadphase bucket of a grid cell
+//
+static int Bucket(int cx,int cy,int cz)
+{
+   return ((unsigned int)cx*73856093u ^ (unsigned int)cy*19349663u ^ (unsigned int)cz*83492791u) & (BALL_HASH-1);
+}
+
+//
+//  Separate overlapping balls and exchange their approach speed
+//
+static void Collide(BallPool* pool,int i,int j)
+{
+   const float d0 = 2*pool->radius;
+   float dx = pool->px[j]-pool->px[i];
+   float dy = pool->py[j]-pool->py[i];
+   float dz = pool->pz[j]-pool->pz[i];
+   float d2 = dx*dx+dy*dy+dz*dz;
+   if (d2>=d0*d0 || d2<1e-12f) return;
+   float d = sqrtf(d2);
+   float nx = dx/d,ny = dy/d,nz = dz/d;
+   float push = 0.5f*(d0-d);
+   pool->px[i] -= nx*push; pool->py[i] -= ny*push; pool->pz[i] -= nz*push;
+   pool->px[j] += nx*push; pool->py[j] += ny*push; pool->pz[j] += nz*push;
+   float vn = (pool->vx[i]-pool->vx[j])*nx + (pool->vy[i]-pool->vy[j])*ny + (pool->vz[i]-pool->vz[j])*nz;
+   if (vn<=0) return;
+   float J = 0.5f*(1+E_BALL)*vn;
+   pool->vx[i] -= J*nx; pool->vy[i] -= J*ny; pool->vz[i] -= J*nz;
+   pool->vx[j] += J*nx; pool->vy[j] += J*ny; pool->vz[j] += J*nz;
+}
+
+//
+//  Ball against ball: sort into grid buckets, then test each ball against
+//  the later balls in its own and the 26 neighbouring cells
+//
+static void Balls(BallPool* pool)
+{
+   const int n = pool->n;
+   const float inv = 1/(2*pool->radius);
+   memset(pool->bucket,0,sizeof(pool->bucket));
+   for (int i=0;i<n;i++)
+   {
+      int b = Bucket((int)floorf(pool->px[i]*inv),(int)floorf(pool->py[i]*inv),(int)floorf(pool->pz[i]*inv));
+      pool->key[i] = b;
+      pool->bucket[b+1]++;
+   }
+   for (int b=0;b<BALL_HASH;b++)
+      pool->bucket[b+1] += pool->bucket[b];
+   for (int i=0;i<n;i++)
+      pool->order[pool->bucket[pool->key[i]]++] = i;
+   //  The fill moved every start up one bucket; shift back
+   for (int b=BALL_HASH;b>0;b--)
+      pool->bucket[b] = pool->bucket[b-1];
+   pool->bucket[0] = 0;
+
+   for (int i=0;i<n;i++)
+   {
+      int cx = (int)floorf(pool->px[i]*inv);
+      int cy = (int)floorf(pool->py[i]*inv);
+      int cz = (int)floorf(pool->pz[i]*inv);
+      int seen[27],nseen = 0;
+      for (int a=-1;a<=1;a++)
+         for (int b=-1;b<=1;b++)
+            for (int c=-1;c<=1;c++)
+            {
+               int h = Bucket(cx+a,cy+b,cz+c);
+               //  Two cells can share a bucket; visit it once
+               int k = 0;
+               while (k<nseen && seen[k]!=h) k++;
+               if (k<nseen) continue;
+               seen[nseen++] = h;
+               for (int s=pool->bucket[h];s<pool->bucket[h+1];s++)
+               {
+                  int j = pool->order[s];
+                  if (j>i) Collide(pool,i,j);
+               }
+            }
+   }
+}
+
+//
+//  Advance every ball dt seconds
+//
+void BallStep(BallPool* pool,float dt)
+{
+   float* restrict px = pool->px;
+   float* restrict py = pool->py;
+   float* restrict pz = pool->pz;
+   float* restrict vy = pool->vy;
+   float* restrict spin = pool->spin;
+   float* restrict age = pool->age;
+   float* restrict lastY = pool->lastY;
+   const float* restrict vx = pool->vx;
+   const float* restrict vz = pool->vz;
+   const float* restrict spinRate = pool->spinRate;
+   const float g = pool->gravity;
+   const float drop = 0.5f*g*dt*dt;
+   const float dv = g*dt;
+   const int n = pool->n;
+   for (int i=0;i<n;i++)
+   {
+      lastY[i] = py[i];
+      px[i] += vx[i]*dt;
+      py[i] += vy[i]*dt + drop;
+      pz[i] += vz[i]*dt;
+      vy[i] += dv;
+      spin[i] += spinRate[i]*dt;
+      age[i] += dt;
+   }
+
+   //  Contacts with the arena and hoops
+   pool->nmake = 0;
+   for (int i=0;i<n;i++)
+   {
+      for (int h=0;h<pool->nhoop;h++)
+         Hoop(pool,i,h);
+      Walls(pool,i);
+      Floor(pool,i,dt);
+   }
+   Balls(pool);
+}
+
+//
+//  Remove ball i (the last ball takes its slot)
+//
+void BallRetire(BallPool* pool,int i)
+{
+   int j = --pool->n;
+   if (i==j) return;
+   pool->px[i] = pool->px[j];
+   pool->py[i] = pool->py[j];
+   pool->pz[i] = pool->pz[j];
+   pool->vx[i] = pool->vx[j];
+   pool->vy[i] = pool->vy[j];
+   pool->vz[i] = pool->vz[j];
+   pool->heading[i] = pool->heading[j];
+   pool->spin[i] = pool->spin[j];
+   pool->spinRate[i] = pool->spinRate[j];
+   pool->age[i] = pool->age[j];
+   pool->life[i] = pool->life[j];
+   pool->tag[i] = pool->tag[j];
+   pool->lod[i] = pool->lod[j];
+}
+
+//
+//  Placement of every ball back seconds before the last step (to draw
+//  between ticks).  Returns the number written to out.
+//
+int BallInstances(const BallPool* pool,float back,MeshInstance* out)
+{
+   const float drop = 0.5f*pool->gravity*back*back;
+   const float floorY = pool->lo[1] + pool->radius;
+   for (int i=0;i<pool->n;i++)
+   {
+      out[i].x = pool->px[i] - pool->vx[i]*back;
+      out[i].y = pool->py[i] - pool->vy[i]*back + drop;
+      out[i].z = pool->pz[i] - pool->vz[i]*back;
+      if (out[i].y<floorY) out[i].y = floorY;
+      out[i].yaw = pool->heading[i];
+      out[i].scale = fmodf(pool->spin[i] - pool->spinRate[i]*back,360);
+   }
+   return pool->n;
+}
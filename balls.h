@@ -0,0 +1,99 @@
+#ifndef BALLS_H
+#define BALLS_H
+
+//
+//  Pooled basketballs with simple rigid-body physics
+//  Kevin McMahon
+//
+//  Every ball in play lives in one preallocated pool stored as a
+//  structure of arrays (position, velocity, spin, age each in their own
+//  float array), so the integration in BallStep() is one straight loop
+//  over contiguous floats that the compiler vectorizes.  Live balls are
+//  packed in [0,n); retiring one moves the last ball into its slot, so
+//  callers walking the pool and retiring as they go should walk it
+//  backwards.
+//
+//  After integrating, each ball is collided with the court floor, the
+//  arena walls and every hoop (rim torus and backboard box), then with
+//  the other balls through a uniform grid hashed into BALL_HASH buckets
+//  (cells one ball across, so only neighbouring cells are checked).  A
+//  ball whose center drops through a rim is recorded in make[].  Spin is
+//  backspin about the horizontal axis across the launch heading; floor
+//  friction trades it against forward speed.
+//
+//  Each ball also carries the level of detail it was last drawn at, so
+//  the level's hysteresis follows the ball when retiring moves it.
+//
+//  BallInstances() writes one MeshInstance per ball for an instanced draw
+//  with shaders/ball.vert: x,y,z, launch heading in degrees (yaw about Y,
+//  like glRotated) and, in the scale slot, the backspin angle in degrees.
+//
+//  Needs capture.h (MeshInstance) included first.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BALL_MAX_HOOPS 8
+#define BALL_HASH      4096   // broadphase buckets (power of 2)
+
+//  Horizontal rim (torus) and the backboard box behind it
+typedef struct
+{
+   float rim[3];           // center of the rim
+   float rimR,rimTube;     // torus major and tube radius
+   float boardLo[3];       // backboard corners
+   float boardHi[3];
+   float lo[3],hi[3];      // everything a ball can touch (set by BallAddHoop)
+} BallHoop;
+
+//  A ball that went through a hoop this step
+typedef struct
+{
+   int tag;                // owner's id from BallLaunch
+   int hoop;               // index from BallAddHoop
+} BallMake;
+
+typedef struct
+{
+   int n;                  // live balls, packed at the front
+   int max;                // pool size
+   float radius;           // every ball is this size
+   float gravity;          // vertical acceleration (negative is down)
+   float *px,*py,*pz;      // position
+   float *vx,*vy,*vz;      // velocity
+   float *heading;         // yaw of the launch direction (degrees)
+   float *spin;            // backspin angle (degrees)
+   float *spinRate;        // backspin (degrees per second)
+   float *age;             // seconds since launch
+   float *life;            // seconds in play before it is retired
+   int   *tag;             // owner's id (shooter, hoop)
+   unsigned char *lod;     // drawing level of detail, kept for LodPick (lod.h)
+   //  World
+   float lo[3],hi[3];      // floor at lo[1], walls at lo/hi x and z
+   BallHoop hoop[BALL_MAX_HOOPS];
+   int nhoop;
+   //  Makes found by the last BallStep
+   BallMake* make;
+   int nmake;
+   //  Scratch for the step
+   float* lastY;           // height before the step
+   int* order;             // balls sorted by bucket
+   int* key;               // bucket of each ball
+   int bucket[BALL_HASH+1];
+} BallPool;
+
+void BallInit(BallPool* pool,int max,float radius,float gravity);
+void BallArena(BallPool* pool,const float lo[3],const float hi[3]);
+int  BallAddHoop(BallPool* pool,const float rim[3],float rimR,float rimTube,const float boardLo[3],const float boardHi[3]);
+int  BallLaunch(BallPool* pool,const float start[3],const float target[3],float t,float spinRate,float life,int tag);
+void BallStep(BallPool* pool,float dt);
+void BallRetire(BallPool* pool,int i);
+int  BallInstances(const BallPool* pool,float back,MeshInstance* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
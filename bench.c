@@ -0,0 +1,410 @@
+//
+//  Headless benchmark
+//  Kevin McMahon
+//
+//  Stands in for GLUT so the unchanged scene code (main.c and friends) can
+//  render into an EGL pbuffer with no window or display.  glutMainLoop()
+//  replays a scripted camera path for every view mode and lighting mode,
+//  times each frame (display + glFinish) and prints avg/p50/p95/p99 frame
+//  times and triangles per second.  Animations run on a fixed 60 Hz clock
+//  so runs are reproducible.  The crowd is then timed on its own: the
+//  profiler's crowd stage (CPU and GPU ms) over the default orbit in each
+//  lighting mode, with the GL finished between stages.  Last a practice
+//  gym of -nets N hoops (16 by default) is stepped on its own at the
+//  120 Hz tick, every net with balls dropping through it, and the time per
+//  tick for all the nets is printed.
+//
+//  Build with "make bench" (links EGL instead of GLUT).  With Mesa set
+//  LIBGL_ALWAYS_SOFTWARE=1 to force the llvmpipe rasterizer.
+//
+//  Usage: ./bench [-frames N] [-warmup N] [-size WxH] [-nets N]
+//
+#include "CSCIx229.h"
+#include "profile.h"
+#include "sim.h"
+//  Types only: the stand-ins below call OpenGL directly
+#define CAPTURE_IMPL
+#include "capture.h"
+#include "balls.h"
+#include "net.h"
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <time.h>
+
+// Scene state driven by the camera paths (defined in main.c)
+extern int viewMode;
+extern int lightingMode;
+extern int th,ph;
+extern double dim;
+extern double eyeX,eyeY,eyeZ;
+extern float camYaw,camPitch;
+void Project(void);
+extern const double UNITS_PER_FOOT;
+extern BallPool balls;
+void rimCenter(int i,double rim[3],double* major,double* tube);
+float shotGravity(void);
+
+// Fonts referenced through the GLUT_* font macros
+void* glutStrokeRoman;
+void* glutStrokeMonoRoman;
+void* glutBitmap8By13;
+void* glutBitmap9By15;
+void* glutBitmapHelvetica12;
+void* glutBitmapHelvetica18;
+
+// Callbacks registered by main()
+static void (*displayCB)(void) = NULL;
+static void (*idleCB)(void) = NULL;
+static void (*reshapeCB)(int,int) = NULL;
+
+// Window and run parameters
+static int width = 800;
+static int height = 800;
+static int frames = 120;      // timed frames per path
+static int warmup = 10;       // untimed frames per path
+static int sizeSet = 0;       // -size given on the command line
+static int gymNets = 16;      // hoops in the practice gym
+static double clockMs = 0;    // virtual GLUT_ELAPSED_TIME
+
+//
+//  Wall clock in seconds
+//
+static double Now(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC,&ts);
+   return ts.tv_sec + 1e-9*ts.tv_nsec;
+}
+
+static int CompareDouble(const void* a,const void* b)
+{
+   double x = *(const double*)a;
+   double y = *(const double*)b;
+   return (x>y) - (x<y);
+}
+
+//
+//  Nearest-rank percentile of a sorted array
+//
+static double Percentile(const double* v,int n,double p)
+{
+   int k = (int)ceil(p/100*n) - 1;
+   if (k<0) k = 0;
+   if (k>=n) k = n-1;
+   return v[k];
+}
+
+//
+//  Place the camera at fraction u of the path for the current view mode
+//
+static void CameraPath(double u)
+{
+   const double a = 360*u;
+   if (viewMode==0)
+   {
+      //  Full orbit at the default elevation
+      th = (int)a % 360;
+      ph = 30;
+   }
+   else if (viewMode==1)
+   {
+      //  Orbit that bobs between low and high views
+      th = (int)a % 360;
+      ph = (int)(20 + 15*sin(2*M_PI*u));
+   }
+   else
+   {
+      //  Walk an ellipse around center court, looking at center court
+      eyeX = 10*cos(2*M_PI*u);
+      eyeZ = 5*sin(2*M_PI*u);
+      eyeY = 1.0;
+      camYaw = atan2(-eyeZ,-eyeX)*180/M_PI;
+      camPitch = -10;
+   }
+}
+
+//
+//  Report one set of frame times (and triangles per second unless tris<0)
+//
+static void Report(const char* name,double* ms,int n,double tris)
+{
+   double sum = 0;
+   for (int k=0;k<n;k++)
+      sum += ms[k];
+   qsort(ms,n,sizeof(double),CompareDouble);
+   printf("%-24s %8.2f %8.2f %8.2f %8.2f",name,sum/n,
+          Percentile(ms,n,50),Percentile(ms,n,95),Percentile(ms,n,99));
+   if (tris>=0) printf(" %10.2f",sum>0 ? tris/(1e3*sum) : 0.0);
+   printf("\n");
+}
+
+/*
+ *  GLUT entry points used by the scene
+ */
+void glutInit(int* argc,char** argv)
+{
+   for (int k=1;k<*argc;k++)
+   {
+      if (!strcmp(argv[k],"-frames") && k+1<*argc)
+         frames = atoi(argv[++k]);
+      else if (!strcmp(argv[k],"-warmup") && k+1<*argc)
+         warmup = atoi(argv[++k]);
+      else if (!strcmp(argv[k],"-size") && k+1<*argc && sscanf(argv[++k],"%dx%d",&width,&height)==2)
+         sizeSet = 1;
+      else if (!strcmp(argv[k],"-nets") && k+1<*argc)
+         gymNets = atoi(argv[++k]);
+      else
+         Fatal("Usage: %s [-frames N] [-warmup N] [-size WxH] [-nets N]\n",argv[0]);
+   }
+   if (frames<1 || width<1 || height<1 || gymNets<0) Fatal("Bad benchmark parameters\n");
+}
+
+void glutInitWindowSize(int w,int h)
+{
+   if (sizeSet) return;
+   width = w;
+   height = h;
+}
+
+void glutInitDisplayMode(unsigned int mode) {}
+
+//
+//  Pbuffer with RGB, depth and a compatibility context
+//
+int glutCreateWindow(const char* title)
+{
+   EGLDisplay dpy = EGL_NO_DISPLAY;
+   //  Prefer Mesa's surfaceless platform so no X server is needed
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+   const char* ext = eglQueryString(EGL_NO_DISPLAY,EGL_EXTENSIONS);
+   PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+      (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+   if (ext && strstr(ext,"EGL_MESA_platform_surfaceless") && getPlatformDisplay)
+      dpy = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,EGL_DEFAULT_DISPLAY,NULL);
+#endif
+   if (dpy==EGL_NO_DISPLAY) dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+   if (dpy==EGL_NO_DISPLAY || !eglInitialize(dpy,NULL,NULL)) Fatal("Cannot initialize EGL\n");
+
+   const EGLint cfgAttr[] = {EGL_SURFACE_TYPE,EGL_PBUFFER_BIT,
+                             EGL_RED_SIZE,8,EGL_GREEN_SIZE,8,EGL_BLUE_SIZE,8,
+                             EGL_DEPTH_SIZE,24,EGL_RENDERABLE_TYPE,EGL_OPENGL_BIT,EGL_NONE};
+   EGLConfig cfg;
+   EGLint n = 0;
+   if (!eglChooseConfig(dpy,cfgAttr,&cfg,1,&n) || n<1) Fatal("No EGL pbuffer config with OpenGL\n");
+   const EGLint pbAttr[] = {EGL_WIDTH,width,EGL_HEIGHT,height,EGL_NONE};
+   EGLSurface surf = eglCreatePbufferSurface(dpy,cfg,pbAttr);
+   if (surf==EGL_NO_SURFACE) Fatal("Cannot create %dx%d pbuffer\n",width,height);
+   if (!eglBindAPI(EGL_OPENGL_API)) Fatal("EGL has no desktop OpenGL\n");
+   EGLContext ctx = eglCreateContext(dpy,cfg,EGL_NO_CONTEXT,NULL);
+   if (ctx==EGL_NO_CONTEXT || !eglMakeCurrent(dpy,surf,surf,ctx)) Fatal("Cannot create OpenGL context\n");
+   return 1;
+}
+
+int glutGet(GLenum what)
+{
+   if (what==GLUT_ELAPSED_TIME)  return (int)clockMs;
+   if (what==GLUT_WINDOW_WIDTH)  return width;
+   if (what==GLUT_WINDOW_HEIGHT) return height;
+   return 0;
+}
+
+void glutPostRedisplay(void) {}
+void glutSwapBuffers(void) {}
+//  The bench advances the animation itself every frame, so keep the idle
+//  callback even when the scene's scheduler switches it off
+void glutIdleFunc(void (*f)(void))          {if (f) idleCB = f;}
+void glutTimerFunc(unsigned int ms,void (*f)(int),int value) {}
+void glutDisplayFunc(void (*f)(void))       {displayCB = f;}
+void glutReshapeFunc(void (*f)(int,int))    {reshapeCB = f;}
+void glutSpecialFunc(void (*f)(int,int,int)) {}
+void glutKeyboardFunc(void (*f)(unsigned char,int,int)) {}
+void glutMouseFunc(void (*f)(int,int,int,int)) {}
+void glutMotionFunc(void (*f)(int,int)) {}
+
+//  Text is not rasterized: glyphs are drawn as outline boxes with the
+//  Roman font's fixed advance so the scoreboard still costs some lines
+int glutStrokeWidth(void* font,int ch)
+{
+   return 104;
+}
+
+void glutStrokeCharacter(void* font,int ch)
+{
+   if (ch!=' ')
+   {
+      glBegin(GL_LINE_LOOP);
+      glVertex2f(10,0);
+      glVertex2f(94,0);
+      glVertex2f(94,119);
+      glVertex2f(10,119);
+      glEnd();
+   }
+   glTranslatef(104,0,0);
+}
+
+void glutBitmapCharacter(void* font,int ch) {}
+
+//
+//  The crowd stage alone: the profiler's PROF_CROWD times in each frame of
+//  the default orbit.  The profiler finishes the GL at every stage switch
+//  here, so the CPU time includes the rasterizing a deferring renderer
+//  would otherwise do at the end of the frame.
+//
+static void CrowdBench(void)
+{
+   const char* lightName[3] = {"warm-up","game","rig"};
+   double* cpu = (double*)malloc(2*frames*sizeof(double));
+   long* id = (long*)malloc(frames*sizeof(long));
+   if (!cpu || !id) Fatal("Cannot allocate frame times\n");
+   double* gpu = cpu + frames;
+   viewMode = 0;
+   profSync(1);
+   for (int light=0;light<3;light++)
+   {
+      char name[64];
+      int got = 0;   // frames whose GPU times are back
+      lightingMode = light;
+      //  Timestamps come back a few frames late, so draw a few more
+      for (int f=-warmup;f<frames || (got<frames && f<frames+8);f++)
+      {
+         double g;
+         CameraPath(f<0 ? 0 : f<frames ? (double)f/frames : 1);
+         Project();
+         clockMs += 1000.0/60;
+         if (idleCB) idleCB();
+         displayCB();
+         glFinish();
+         if (f>=0 && f<frames)
+         {
+            id[f] = profFrame();
+            profStage(id[f],PROF_CROWD,cpu+f,&g);
+         }
+         while (got<frames && got<=f && profStage(id[got],PROF_CROWD,&g,gpu+got) && gpu[got]>=0)
+            got++;
+      }
+      snprintf(name,sizeof(name),"crowd cpu / %s",lightName[light]);
+      Report(name,cpu,frames,-1);
+      snprintf(name,sizeof(name),"crowd gpu / %s",lightName[light]);
+      if (got==frames) Report(name,gpu,frames,-1);
+   }
+   profSync(0);
+   free(id);
+   free(cpu);
+}
+
+//
+//  Practice gym: n copies of the scene's net in rows 3 feet apart, each
+//  with a ball dropped through it every quarter second (a few always in
+//  the net), stepped for 10 simulated seconds.  Only NetStep is timed.
+//
+static void NetsBench(int n)
+{
+   if (n<1) return;
+   const int ticks = 10*SIM_HZ;
+   NetCloth* gym = (NetCloth*)malloc(n*sizeof(NetCloth));
+   double* ms = (double*)malloc(ticks*sizeof(double));
+   if (!gym || !ms) Fatal("Cannot allocate %d nets\n",n);
+   BallPool pool;
+   BallInit(&pool,8*n,balls.radius,shotGravity());
+   const float lo[3] = {-1e3,0,-1e3};
+   const float hi[3] = { 1e3,0, 1e3};
+   BallArena(&pool,lo,hi);
+
+   //  Hung like main.c's ballWorld()
+   double rim[3],major,tube;
+   rimCenter(0,rim,&major,&tube);
+   const float gap = 3*UNITS_PER_FOOT;
+   float (*c)[3] = (float(*)[3])malloc(n*sizeof(*c));
+   if (!c) Fatal("Cannot allocate %d nets\n",n);
+   for (int k=0;k<n;k++)
+   {
+      c[k][0] = rim[0] + gap*(k%8);
+      c[k][1] = rim[1] - 0.02*0.6;
+      c[k][2] = rim[2] + gap*(k/8);
+      NetInit(gym+k,c[k],major*0.99,major*0.99*0.65,1.2*UNITS_PER_FOOT,shotGravity());
+   }
+
+   for (int t=0;t<ticks;t++)
+   {
+      //  Each net's next ball, from a little off center so it drags the strings
+      for (int k=0;k<n;k++)
+         if ((t+7*k)%(SIM_HZ/4)==0)
+         {
+            float off = major*(0.3*((t/(SIM_HZ/4)+k)%3) - 0.3);
+            const float start[3] = {c[k][0]+off,c[k][1]+0.5f,c[k][2]};
+            const float end[3]   = {c[k][0]+off,c[k][1]-0.3f,c[k][2]};
+            BallLaunch(&pool,start,end,0.35,0,1.0,k);
+         }
+      BallStep(&pool,SIM_DT);
+      double start = Now();
+      for (int k=0;k<n;k++)
+         NetStep(gym+k,SIM_DT,&pool);
+      ms[t] = 1e3*(Now() - start);
+      for (int b=pool.n-1;b>=0;b--)
+         if (pool.age[b]>=pool.life[b]) BallRetire(&pool,b);
+   }
+   char name[64];
+   snprintf(name,sizeof(name),"nets x%d (per tick)",n);
+   Report(name,ms,ticks,-1);
+   for (int k=0;k<n;k++)
+      glDeleteBuffers(1,&gym[k].vbo);
+   free(c);
+   free(ms);
+   free(gym);
+}
+
+//
+//  Run every path and exit
+//
+void glutMainLoop(void)
+{
+   if (!displayCB) Fatal("No display function\n");
+   const char* modeName[3] = {"ortho","perspective","first-person"};
+   const char* lightName[3] = {"warm-up","game","rig"};
+   const int npath = 3*3;
+   double* all = (double*)malloc(npath*frames*sizeof(double));
+   double* ms = (double*)malloc(frames*sizeof(double));
+   if (!all || !ms) Fatal("Cannot allocate frame times\n");
+   double allTris = 0;
+   int nall = 0;
+
+   if (reshapeCB) reshapeCB(width,height);
+   printf("bench: %dx%d, %s, %d frames per path (+%d warm-up)\n",width,height,
+          (const char*)glGetString(GL_RENDERER),frames,warmup);
+   printf("%-24s %8s %8s %8s %8s %10s\n","path","avg ms","p50","p95","p99","Mtri/s");
+
+   for (int light=0;light<3;light++)
+      for (int view=0;view<3;view++)
+      {
+         char name[64];
+         double tris = 0;
+         lightingMode = light;
+         viewMode = view;
+         for (int f=-warmup;f<frames;f++)
+         {
+            CameraPath(f<0 ? 0 : (double)f/frames);
+            Project();
+            clockMs += 1000.0/60;
+            if (idleCB) idleCB();
+            unsigned long t0 = profTris;
+            double start = Now();
+            displayCB();
+            glFinish();
+            double dt = 1e3*(Now() - start);
+            if (f<0) continue;
+            ms[f] = dt;
+            all[nall++] = dt;
+            tris += profTris - t0;
+         }
+         allTris += tris;
+         snprintf(name,sizeof(name),"%s / %s",modeName[view],lightName[light]);
+         Report(name,ms,frames,tris);
+      }
+   Report("all",all,nall,allTris);
+   CrowdBench();
+   NetsBench(gymNets);
+   ErrCheck("bench");
+   free(ms);
+   free(all);
+   exit(0);
+}
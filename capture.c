@@ -0,0 +1,872 @@
+//  Immediate-mode capture into retained vertex batches
+//  Kevin McMahon
+#include "CSCIx229.h"
+#define CAPTURE_IMPL
+#include "capture.h"
+#include "shader.h"
+#include "profile.h"
+#include "stats.h"
+
+// Interleaved vertex as stored in the mesh buffer
+typedef struct
+{
+   float x,y,z;
+   float nx,ny,nz;
+   float s,t;
+   unsigned char rgba[4];
+} CapVert;
+
+// Growing triangle list for one material
+typedef struct
+{
+   unsigned int tex;
+   int blend;
+   CapVert* v;
+   int n,max;
+   int* end;           // vertex count at the end of each part so far
+   int nend,maxend;
+   MeshRun* run;       // where each function's vertices start (list offsets)
+   int nrun,maxrun;
+} CapList;
+
+// Recorder state
+static int      capOn = 0;
+static double   capM[16];          // modelview at glBegin (column major)
+static double   capN[9];           // normal matrix (cofactors of upper 3x3)
+static GLenum   capMode;
+static CapVert* capPrim = NULL;    // vertices of the current glBegin block
+static int      capNprim = 0,capMaxprim = 0;
+static float    capNormal[3] = {0,0,1};
+static float    capTex[2] = {0,0};
+static unsigned char capColor[4] = {255,255,255,255};
+static unsigned int capTexBound = 0;
+static int      capTexOn = 0;
+static int      capBlendOn = 0;
+static CapList* capList = NULL;
+static int      capNlist = 0,capMaxlist = 0;
+static int      capPart = 0;       // part being recorded
+static const char* capFn = NULL;   // draw function of the current glBegin block
+//  Forwarded glBegin block (for the triangle count)
+static GLenum   fwdMode;
+static int      fwdVerts = 0;
+
+//  Render-state cache: the enables in stateCap plus the values flagged in
+//  stateHave are what OpenGL holds; anything else is set for real
+#define STATE_NCAP  16
+#define STATE_TEX   1     // GL_TEXTURE_2D binding (unit 0, the only one the draw code uses)
+#define STATE_PROG  2
+#define STATE_FUNC  4     // blend function
+#define STATE_SPEC  8     // front and back specular, emission, shininess
+#define STATE_EMIT  16
+#define STATE_SHINY 32
+static const GLenum stateCap[STATE_NCAP] =
+   {GL_TEXTURE_2D,GL_BLEND,GL_LIGHTING,GL_COLOR_MATERIAL,GL_DEPTH_TEST,GL_NORMALIZE,
+    GL_CULL_FACE,GL_POLYGON_OFFSET_LINE,GL_LIGHT0,GL_LIGHT1,GL_LIGHT2,GL_LIGHT3,
+    GL_LIGHT4,GL_LIGHT5,GL_LIGHT6,GL_LIGHT7};
+int stateCache = 1;
+static unsigned int stateKnown = 0;   // bit k: stateCap[k] is known
+static unsigned int stateOn = 0;      // bit k: stateCap[k] is enabled
+static int      stateHave = 0;
+static unsigned int stateTex,stateProg;
+static GLenum   stateSrc,stateDst;
+static float    stateSpec[4],stateEmit[4],stateShiny;
+static const Mesh* stateMesh = NULL;  // arrays drawMeshBatch() left bound
+
+//
+//  Grow an array to hold at least n elements
+//
+static void* Grow(void* p,int* max,int n,int size)
+{
+   if (n <= *max) return p;
+   int m = *max ? *max : 256;
+   while (m < n) m *= 2;
+   p = realloc(p,(size_t)m*size);
+   if (!p) Fatal("Cannot grow capture buffer to %d elements\n",m);
+   *max = m;
+   return p;
+}
+
+//
+//  Find (or start) the triangle list for the current material
+//
+static CapList* CurrentList(void)
+{
+   unsigned int tex = capTexOn ? capTexBound : 0;
+   for (int k=0;k<capNlist;k++)
+      if (capList[k].tex==tex && capList[k].blend==capBlendOn) return capList+k;
+   capList = (CapList*)Grow(capList,&capMaxlist,capNlist+1,sizeof(CapList));
+   CapList* l = capList + capNlist++;
+   l->tex = tex;
+   l->blend = capBlendOn;
+   l->v = NULL;
+   l->n = l->max = 0;
+   l->end = NULL;
+   l->nend = l->maxend = 0;
+   l->run = NULL;
+   l->nrun = l->maxrun = 0;
+   return l;
+}
+
+//
+//  Triangles produced by n vertices of a primitive
+//
+static int TriCount(GLenum mode,int n)
+{
+   switch (mode)
+   {
+      case GL_TRIANGLES:      return n/3;
+      case GL_QUADS:          return 2*(n/4);
+      case GL_QUAD_STRIP:     return n<4 ? 0 : 2*((n-2)/2);
+      case GL_TRIANGLE_STRIP:
+      case GL_TRIANGLE_FAN:
+      case GL_POLYGON:        return n<3 ? 0 : n-2;
+      default:                return 0;
+   }
+}
+
+static void Tri(CapList* l,int a,int b,int c)
+{
+   //  A new run whenever another function's triangles start
+   if (!l->nrun || l->run[l->nrun-1].fn!=capFn)
+   {
+      l->run = (MeshRun*)Grow(l->run,&l->maxrun,l->nrun+1,sizeof(MeshRun));
+      l->run[l->nrun].first = l->n;
+      l->run[l->nrun++].fn = capFn;
+   }
+   l->v = (CapVert*)Grow(l->v,&l->max,l->n+3,sizeof(CapVert));
+   l->v[l->n++] = capPrim[a];
+   l->v[l->n++] = capPrim[b];
+   l->v[l->n++] = capPrim[c];
+   //  Parts only move forward, so each list stays sorted by part
+   l->end = (int*)Grow(l->end,&l->maxend,capPart+1,sizeof(int));
+   while (l->nend<capPart) l->end[l->nend++] = l->n-3;
+   l->nend = capPart+1;
+   l->end[capPart] = l->n;
+}
+
+//
+//  Close the tracked parts of a list at its final count
+//
+static void EndParts(CapList* l,int npart)
+{
+   l->end = (int*)Grow(l->end,&l->maxend,npart,sizeof(int));
+   while (l->nend<npart) l->end[l->nend++] = l->n;
+}
+
+//
+//  Start recording in the caller's local space
+//
+void captureBegin(void)
+{
+   if (capOn) Fatal("captureBegin called while already capturing\n");
+   //  Geometry is stored relative to the modelview at this point
+   glMatrixMode(GL_MODELVIEW);
+   glPushMatrix();
+   glLoadIdentity();
+   //  Pick up whatever attributes are current
+   float f[4];
+   int tex;
+   glGetFloatv(GL_CURRENT_NORMAL,f);
+   capNormal[0] = f[0]; capNormal[1] = f[1]; capNormal[2] = f[2];
+   glGetFloatv(GL_CURRENT_TEXTURE_COORDS,f);
+   capTex[0] = f[0]; capTex[1] = f[1];
+   glGetFloatv(GL_CURRENT_COLOR,f);
+   for (int k=0;k<4;k++) capColor[k] = (unsigned char)(255*f[k]+0.5);
+   glGetIntegerv(GL_TEXTURE_BINDING_2D,&tex);
+   capTexBound = tex;
+   capTexOn = glIsEnabled(GL_TEXTURE_2D);
+   capBlendOn = glIsEnabled(GL_BLEND);
+   capNlist = 0;
+   capPart = 0;
+   capOn = 1;
+}
+
+//
+//  Start the next part of the recording; returns its number
+//  (-1 when not recording, so draw code can call it unconditionally)
+//
+int capturePart(void)
+{
+   if (!capOn) return -1;
+   return ++capPart;
+}
+
+//
+//  Stop recording and upload the batches
+//
+Mesh* captureEnd(void)
+{
+   if (!capOn) Fatal("captureEnd called without captureBegin\n");
+   capOn = 0;
+   glMatrixMode(GL_MODELVIEW);
+   glPopMatrix();
+
+   Mesh* mesh = (Mesh*)malloc(sizeof(Mesh));
+   if (!mesh) Fatal("Cannot allocate mesh\n");
+   mesh->nvert = 0;
+   mesh->nbatch = 0;
+   mesh->npart = capPart+1;
+   mesh->nrun = 0;
+   for (int k=0;k<capNlist;k++)
+   {
+      if (capList[k].n) mesh->nbatch++;
+      EndParts(capList+k,mesh->npart);
+      mesh->nrun += capList[k].nrun;
+   }
+   int nb1 = mesh->nbatch ? mesh->nbatch : 1;
+   mesh->batch = (MeshBatch*)malloc(nb1*sizeof(MeshBatch));
+   int* parts = (int*)malloc(nb1*(mesh->npart+1)*sizeof(int));
+   mesh->box = (float*)malloc(6*mesh->npart*sizeof(float));
+   mesh->run = (MeshRun*)malloc((mesh->nrun+1)*sizeof(MeshRun));
+   if (!mesh->batch || !parts || !mesh->box || !mesh->run) Fatal("Cannot allocate mesh batches\n");
+   mesh->batch[0].part = parts;
+   for (int p=0;p<mesh->npart;p++)
+      for (int k=0;k<3;k++)
+      {
+         mesh->box[6*p+k] = 1e30;
+         mesh->box[6*p+k+3] = -1e30;
+      }
+
+   //  Opaque materials first so the blended pass is a contiguous tail
+   int nb = 0,nr = 0;
+   for (int pass=0;pass<2;pass++)
+      for (int k=0;k<capNlist;k++)
+      {
+         CapList* l = capList+k;
+         if (!l->n || l->blend!=pass) continue;
+         mesh->batch[nb].tex = l->tex;
+         mesh->batch[nb].blend = l->blend;
+         mesh->batch[nb].first = mesh->nvert;
+         mesh->batch[nb].count = l->n;
+         mesh->batch[nb].part = parts + nb*(mesh->npart+1);
+         mesh->batch[nb].part[0] = mesh->nvert;
+         for (int p=0;p<mesh->npart;p++)
+         {
+            mesh->batch[nb].part[p+1] = mesh->nvert + l->end[p];
+            //  Grow the part's box over its vertices in this list
+            float* box = mesh->box + 6*p;
+            for (int i=p ? l->end[p-1] : 0;i<l->end[p];i++)
+            {
+               const float* v = &l->v[i].x;
+               for (int c=0;c<3;c++)
+               {
+                  if (v[c]<box[c]) box[c] = v[c];
+                  if (v[c]>box[c+3]) box[c+3] = v[c];
+               }
+            }
+         }
+         for (int r=0;r<l->nrun;r++)
+         {
+            mesh->run[nr].first = mesh->nvert + l->run[r].first;
+            mesh->run[nr++].fn = l->run[r].fn;
+         }
+         mesh->nvert += l->n;
+         nb++;
+      }
+   mesh->run[nr].first = mesh->nvert;
+   mesh->run[nr].fn = NULL;
+
+   //  Concatenate into one buffer
+   CapVert* all = (CapVert*)malloc((mesh->nvert ? mesh->nvert : 1)*sizeof(CapVert));
+   if (!all) Fatal("Cannot allocate %d mesh vertices\n",mesh->nvert);
+   for (int b=0;b<mesh->nbatch;b++)
+      for (int k=0;k<capNlist;k++)
+      {
+         CapList* l = capList+k;
+         if (l->n && l->tex==mesh->batch[b].tex && l->blend==mesh->batch[b].blend)
+            memcpy(all+mesh->batch[b].first,l->v,l->n*sizeof(CapVert));
+      }
+   for (int k=0;k<capNlist;k++)
+   {
+      free(capList[k].v);
+      free(capList[k].end);
+      free(capList[k].run);
+   }
+   capNlist = 0;
+
+   glGenBuffers(1,&mesh->vbo);
+   glBindBuffer(GL_ARRAY_BUFFER,mesh->vbo);
+   glBufferData(GL_ARRAY_BUFFER,mesh->nvert*sizeof(CapVert),all,GL_STATIC_DRAW);
+   glBindBuffer(GL_ARRAY_BUFFER,0);
+   free(all);
+   ErrCheck("captureEnd");
+   return mesh;
+}
+
+//
+//  Forget the cached state (it was changed behind the wrappers)
+//
+void stateInvalidate(void)
+{
+   stateKnown = 0;
+   stateHave = 0;
+}
+
+static int CapSlot(GLenum cap)
+{
+   for (int k=0;k<STATE_NCAP;k++)
+      if (stateCap[k]==cap) return k;
+   return -1;
+}
+
+//
+//  Enable or disable cap unless it already is; 0 when skipped
+//
+static int SetCap(GLenum cap,int on)
+{
+   int k = CapSlot(cap);
+   unsigned int bit = k<0 ? 0 : 1u<<k;
+   if (stateCache && (stateKnown & bit) && !(stateOn & bit)==!on)
+   {
+      PROF_SAVED(1);
+      return 0;
+   }
+   PROF_CALLS(1);
+   if (on) glEnable(cap); else glDisable(cap);
+   stateKnown |= bit;
+   if (on) stateOn |= bit; else stateOn &= ~bit;
+   return 1;
+}
+
+static int SetTex(unsigned int tex)
+{
+   if (stateCache && (stateHave & STATE_TEX) && stateTex==tex)
+   {
+      PROF_SAVED(1);
+      return 0;
+   }
+   PROF_CALLS(1);
+   glBindTexture(GL_TEXTURE_2D,tex);
+   stateTex = tex;
+   stateHave |= STATE_TEX;
+   return 1;
+}
+
+static void SetBlendFunc(GLenum src,GLenum dst)
+{
+   if (stateCache && (stateHave & STATE_FUNC) && stateSrc==src && stateDst==dst)
+   {
+      PROF_SAVED(1);
+      return;
+   }
+   PROF_CALLS(1);
+   glBlendFunc(src,dst);
+   stateSrc = src;
+   stateDst = dst;
+   stateHave |= STATE_FUNC;
+}
+
+//
+//  Current program, asked of OpenGL only when not known
+//
+static unsigned int CurrentProgram(void)
+{
+   if (!(stateHave & STATE_PROG))
+   {
+      int prog;
+      glGetIntegerv(GL_CURRENT_PROGRAM,&prog);
+      stateProg = prog;
+      stateHave |= STATE_PROG;
+   }
+   return stateProg;
+}
+
+//
+//  Where the current program (e.g. shaders/pixel.*) is told which batches
+//  are textured, -1 for none
+//
+static int TexturedUniform(void)
+{
+   static int prog = -1,loc = -1;
+   int cur = CurrentProgram();
+   if (cur!=prog)
+   {
+      prog = cur;
+      loc = cur ? glGetUniformLocation(cur,"Textured") : -1;
+   }
+   return loc;
+}
+
+//
+//  Point the vertex arrays at a mesh unless they already are
+//
+static void MeshArrays(const Mesh* mesh)
+{
+   const int stride = sizeof(CapVert);
+   if (stateMesh==mesh) return;
+   if (!stateMesh)
+   {
+      PROF_GL(glEnableClientState(GL_VERTEX_ARRAY));
+      PROF_GL(glEnableClientState(GL_NORMAL_ARRAY));
+      PROF_GL(glEnableClientState(GL_TEXTURE_COORD_ARRAY));
+      PROF_GL(glEnableClientState(GL_COLOR_ARRAY));
+   }
+   PROF_GL(glBindBuffer(GL_ARRAY_BUFFER,mesh->vbo));
+   PROF_GL(glVertexPointer(3,GL_FLOAT,stride,(void*)0));
+   PROF_GL(glNormalPointer(GL_FLOAT,stride,(void*)(3*sizeof(float))));
+   PROF_GL(glTexCoordPointer(2,GL_FLOAT,stride,(void*)(6*sizeof(float))));
+   PROF_GL(glColorPointer(4,GL_UNSIGNED_BYTE,stride,(void*)(8*sizeof(float))));
+   stateMesh = mesh;
+}
+
+//
+//  Count n vertices from first on (times copies each) under the functions
+//  that recorded them; the draw itself goes to the first of them
+//
+static void StatsRuns(const Mesh* mesh,int first,int n,unsigned long times,int draw)
+{
+   //  Last run starting at or before first
+   int lo = 0,hi = mesh->nrun;
+   while (hi-lo>1)
+   {
+      int mid = (lo+hi)/2;
+      if (mesh->run[mid].first<=first) lo = mid; else hi = mid;
+   }
+   for (int r=lo,end=first+n;r<mesh->nrun && mesh->run[r].first<end;r++)
+   {
+      int a = mesh->run[r].first>first ? mesh->run[r].first : first;
+      int b = mesh->run[r+1].first<end ? mesh->run[r+1].first : end;
+      unsigned long v = (unsigned long)(b-a)*times;
+      if (draw) statsDraw(mesh->run[r].fn,GL_TRIANGLES,v); else statsVerts(mesh->run[r].fn,v);
+      draw = 0;
+   }
+}
+
+//
+//  Replay a recorded mesh (opaque and/or blended batches)
+//
+void drawMesh(const Mesh* mesh,int pass)
+{
+   drawMeshParts(mesh,pass,NULL);
+}
+
+//
+//  Replay only the parts with show[p] set (all of them when show is NULL)
+//
+void drawMeshParts(const Mesh* mesh,int pass,const unsigned char* show)
+{
+   if (!mesh || !mesh->nvert) return;
+   if (show)
+   {
+      int any = 0;
+      for (int p=0;p<mesh->npart && !any;p++)
+         any = show[p];
+      if (!any) return;
+   }
+   for (int b=0;b<mesh->nbatch;b++)
+      if (pass & (mesh->batch[b].blend ? MESH_BLENDED : MESH_OPAQUE))
+         drawMeshBatch(mesh,b,-1,show);
+   drawMeshDone();
+}
+
+//
+//  Draw batch b of a mesh: just part when part >= 0, otherwise the parts
+//  with show[p] set (all of them when show is NULL), neighboring parts
+//  merged into one multi-draw.  The arrays, texture and blend state stay
+//  set for the next batch; drawMeshDone() puts things back.
+//
+void drawMeshBatch(const Mesh* mesh,int b,int part,const unsigned char* show)
+{
+   static int* first = NULL;
+   static int* count = NULL;
+   static int maxfirst = 0,maxcount = 0;
+   if (!mesh || !mesh->nvert) return;
+   const MeshBatch* mb = mesh->batch+b;
+   int start = mb->first,nv = mb->count,nrange = 0;
+   if (part>=0)
+   {
+      start = mb->part[part];
+      nv = mb->part[part+1]-start;
+   }
+   else if (show)
+   {
+      first = (int*)Grow(first,&maxfirst,mesh->npart,sizeof(int));
+      count = (int*)Grow(count,&maxcount,mesh->npart,sizeof(int));
+      nv = 0;
+      for (int p=0;p<mesh->npart;p++)
+      {
+         int n = mb->part[p+1]-mb->part[p];
+         if (!show[p] || !n) continue;
+         if (nrange && first[nrange-1]+count[nrange-1]==mb->part[p])
+            count[nrange-1] += n;
+         else
+         {
+            first[nrange] = mb->part[p];
+            count[nrange++] = n;
+         }
+         nv += n;
+      }
+   }
+   if (!nv) return;
+
+   MeshArrays(mesh);
+   statsEnable(__func__,!SetCap(GL_TEXTURE_2D,mb->tex!=0));
+   if (mb->tex) statsBind(__func__,!SetTex(mb->tex));
+   int textured = TexturedUniform();
+   if (textured>=0)
+   {
+      glUniform1i(textured,mb->tex!=0);
+      PROF_CALLS(1);
+   }
+   statsEnable(__func__,!SetCap(GL_BLEND,mb->blend));
+   if (mb->blend) SetBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA);
+   if (nrange)
+      glMultiDrawArrays(GL_TRIANGLES,first,count,nrange);
+   else
+      glDrawArrays(GL_TRIANGLES,start,nv);
+   if (nrange)
+      for (int r=0;r<nrange;r++)
+         StatsRuns(mesh,first[r],count[r],1,!r);
+   else
+      StatsRuns(mesh,start,nv,1,1);
+   PROF_CALLS(1);
+   PROF_VERTS(nv);
+   PROF_TRIS(nv/3);
+}
+
+//
+//  Release the arrays drawMeshBatch() left bound
+//
+void drawMeshDone(void)
+{
+   if (!stateMesh) return;
+   PROF_GL(glDisableClientState(GL_COLOR_ARRAY));
+   PROF_GL(glDisableClientState(GL_TEXTURE_COORD_ARRAY));
+   PROF_GL(glDisableClientState(GL_NORMAL_ARRAY));
+   PROF_GL(glDisableClientState(GL_VERTEX_ARRAY));
+   PROF_GL(glBindBuffer(GL_ARRAY_BUFFER,0));
+   stateMesh = NULL;
+   //  Leave the same state the draw functions do
+   PROF_GL(glColor3f(1,1,1));
+   statsEnable(__func__,!SetCap(GL_TEXTURE_2D,1));
+   statsEnable(__func__,!SetCap(GL_BLEND,0));
+}
+
+//
+//  Draw ninst copies of a mesh in one call per batch
+//  instVbo holds MeshInstance records (ninst of them from record first),
+//  prog is shaders/instance.vert/frag
+//
+void drawMeshInstanced(const Mesh* mesh,int prog,unsigned int instVbo,int first,int ninst,int pass)
+{
+   if (!mesh || !mesh->nvert || ninst<1) return;
+   const int stride = sizeof(CapVert);
+   const int istride = sizeof(MeshInstance);
+   int inst  = PROF_GL(glGetAttribLocation(prog,"Inst"));
+   int scale = PROF_GL(glGetAttribLocation(prog,"InstScale"));
+   int textured = PROF_GL(glGetUniformLocation(prog,"Textured"));
+
+   drawMeshDone();
+   capUseProgram(prog);
+   SetLightUniforms(prog);
+   PROF_GL(glBindBuffer(GL_ARRAY_BUFFER,mesh->vbo));
+   PROF_GL(glEnableClientState(GL_VERTEX_ARRAY));
+   PROF_GL(glEnableClientState(GL_NORMAL_ARRAY));
+   PROF_GL(glEnableClientState(GL_TEXTURE_COORD_ARRAY));
+   PROF_GL(glEnableClientState(GL_COLOR_ARRAY));
+   PROF_GL(glVertexPointer(3,GL_FLOAT,stride,(void*)0));
+   PROF_GL(glNormalPointer(GL_FLOAT,stride,(void*)(3*sizeof(float))));
+   PROF_GL(glTexCoordPointer(2,GL_FLOAT,stride,(void*)(6*sizeof(float))));
+   PROF_GL(glColorPointer(4,GL_UNSIGNED_BYTE,stride,(void*)(8*sizeof(float))));
+   //  Per-instance placement advances once per copy
+   PROF_GL(glBindBuffer(GL_ARRAY_BUFFER,instVbo));
+   PROF_GL(glEnableVertexAttribArray(inst));
+   PROF_GL(glEnableVertexAttribArray(scale));
+   PROF_GL(glVertexAttribPointer(inst,4,GL_FLOAT,GL_FALSE,istride,(void*)((size_t)first*istride)));
+   PROF_GL(glVertexAttribPointer(scale,1,GL_FLOAT,GL_FALSE,istride,(void*)((size_t)first*istride+4*sizeof(float))));
+   PROF_GL(glVertexAttribDivisor(inst,1));
+   PROF_GL(glVertexAttribDivisor(scale,1));
+
+   for (int b=0;b<mesh->nbatch;b++)
+   {
+      const MeshBatch* mb = mesh->batch+b;
+      if (!(pass & (mb->blend ? MESH_BLENDED : MESH_OPAQUE))) continue;
+      PROF_GL(glUniform1i(textured,mb->tex!=0));
+      if (mb->tex) statsBind(__func__,!SetTex(mb->tex));
+      statsEnable(__func__,!SetCap(GL_BLEND,mb->blend));
+      if (mb->blend) SetBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA);
+      PROF_GL(glDrawArraysInstanced(GL_TRIANGLES,mb->first,mb->count,ninst));
+      StatsRuns(mesh,mb->first,mb->count,ninst,1);
+      PROF_VERTS(mb->count*ninst);
+      PROF_TRIS(mb->count/3*ninst);
+   }
+   statsEnable(__func__,!SetCap(GL_BLEND,0));
+
+   PROF_GL(glVertexAttribDivisor(inst,0));
+   PROF_GL(glVertexAttribDivisor(scale,0));
+   PROF_GL(glDisableVertexAttribArray(inst));
+   PROF_GL(glDisableVertexAttribArray(scale));
+   PROF_GL(glDisableClientState(GL_COLOR_ARRAY));
+   PROF_GL(glDisableClientState(GL_TEXTURE_COORD_ARRAY));
+   PROF_GL(glDisableClientState(GL_NORMAL_ARRAY));
+   PROF_GL(glDisableClientState(GL_VERTEX_ARRAY));
+   PROF_GL(glBindBuffer(GL_ARRAY_BUFFER,0));
+   capUseProgram(0);
+   PROF_GL(glColor3f(1,1,1));
+}
+
+void freeMesh(Mesh* mesh)
+{
+   if (!mesh) return;
+   glDeleteBuffers(1,&mesh->vbo);
+   free(mesh->batch[0].part);
+   free(mesh->box);
+   free(mesh->run);
+   free(mesh->batch);
+   free(mesh);
+}
+
+//
+//  Wrappers: forward to OpenGL unless recording
+//  (only forwarded work counts toward the render statistics)
+//
+void capBegin(GLenum mode,const char* fn)
+{
+   if (!capOn)
+   {
+      PROF_CALLS(1);
+      statsDraw(fn,mode,0);
+      fwdMode = mode;
+      fwdVerts = 0;
+      glBegin(mode);
+      return;
+   }
+   capMode = mode;
+   capFn = fn;
+   capNprim = 0;
+   glGetDoublev(GL_MODELVIEW_MATRIX,capM);
+   //  Cofactors of the upper 3x3 (inverse transpose up to scale)
+   const double* m = capM;
+   capN[0] = m[5]*m[10]-m[6]*m[9];  capN[1] = m[9]*m[2]-m[10]*m[1];  capN[2] = m[1]*m[6]-m[2]*m[5];
+   capN[3] = m[6]*m[8]-m[4]*m[10];  capN[4] = m[10]*m[0]-m[8]*m[2];  capN[5] = m[2]*m[4]-m[0]*m[6];
+   capN[6] = m[4]*m[9]-m[5]*m[8];   capN[7] = m[8]*m[1]-m[9]*m[0];   capN[8] = m[0]*m[5]-m[1]*m[4];
+   //  Mirrored transforms flip the cofactor direction
+   double det = m[0]*capN[0] + m[4]*capN[1] + m[8]*capN[2];
+   if (det < 0)
+      for (int k=0;k<9;k++) capN[k] = -capN[k];
+}
+
+void capEnd(void)
+{
+   if (!capOn)
+   {
+      PROF_CALLS(1);
+      PROF_TRIS(TriCount(fwdMode,fwdVerts));
+      glEnd();
+      return;
+   }
+   CapList* l = CurrentList();
+   int n = capNprim;
+   switch (capMode)
+   {
+      case GL_TRIANGLES:
+         for (int k=0;k+2<n;k+=3) Tri(l,k,k+1,k+2);
+         break;
+      case GL_QUADS:
+         for (int k=0;k+3<n;k+=4) {Tri(l,k,k+1,k+3); Tri(l,k+1,k+2,k+3);}
+         break;
+      case GL_QUAD_STRIP:
+         for (int k=0;k+3<n;k+=2) {Tri(l,k,k+1,k+3); Tri(l,k,k+3,k+2);}
+         break;
+      case GL_TRIANGLE_STRIP:
+         for (int k=0;k+2<n;k++)
+            if (k%2) Tri(l,k+1,k,k+2); else Tri(l,k,k+1,k+2);
+         break;
+      case GL_TRIANGLE_FAN:
+      case GL_POLYGON:
+         for (int k=1;k+1<n;k++) Tri(l,0,k,k+1);
+         break;
+      default:
+         //  Points and lines are not batched
+         break;
+   }
+   capNprim = 0;
+}
+
+void capVertex3d(double x,double y,double z,const char* fn)
+{
+   if (!capOn) {PROF_VERTS(1); PROF_CALLS(1); statsVerts(fn,1); fwdVerts++; glVertex3d(x,y,z); return;}
+   capPrim = (CapVert*)Grow(capPrim,&capMaxprim,capNprim+1,sizeof(CapVert));
+   CapVert* v = capPrim + capNprim++;
+   const double* m = capM;
+   const double* c = capN;
+   v->x = m[0]*x + m[4]*y + m[8]*z  + m[12];
+   v->y = m[1]*x + m[5]*y + m[9]*z  + m[13];
+   v->z = m[2]*x + m[6]*y + m[10]*z + m[14];
+   double nx = c[0]*capNormal[0] + c[1]*capNormal[1] + c[2]*capNormal[2];
+   double ny = c[3]*capNormal[0] + c[4]*capNormal[1] + c[5]*capNormal[2];
+   double nz = c[6]*capNormal[0] + c[7]*capNormal[1] + c[8]*capNormal[2];
+   double len = sqrt(nx*nx + ny*ny + nz*nz);
+   if (len > 0) {nx /= len; ny /= len; nz /= len;}
+   v->nx = nx; v->ny = ny; v->nz = nz;
+   v->s = capTex[0];
+   v->t = capTex[1];
+   memcpy(v->rgba,capColor,4);
+}
+
+void capVertex3f(float x,float y,float z,const char* fn)
+{
+   if (!capOn) {PROF_VERTS(1); PROF_CALLS(1); statsVerts(fn,1); fwdVerts++; glVertex3f(x,y,z); return;}
+   capVertex3d(x,y,z,fn);
+}
+
+void capNormal3d(double x,double y,double z)
+{
+   if (!capOn) {PROF_CALLS(1); glNormal3d(x,y,z); return;}
+   capNormal[0] = x; capNormal[1] = y; capNormal[2] = z;
+}
+
+void capNormal3f(float x,float y,float z)
+{
+   if (!capOn) {PROF_CALLS(1); glNormal3f(x,y,z); return;}
+   capNormal[0] = x; capNormal[1] = y; capNormal[2] = z;
+}
+
+void capTexCoord2d(double s,double t)
+{
+   if (!capOn) {PROF_CALLS(1); glTexCoord2d(s,t); return;}
+   capTex[0] = s; capTex[1] = t;
+}
+
+void capTexCoord2f(float s,float t)
+{
+   if (!capOn) {PROF_CALLS(1); glTexCoord2f(s,t); return;}
+   capTex[0] = s; capTex[1] = t;
+}
+
+void capColor3f(float r,float g,float b)
+{
+   if (!capOn) {PROF_CALLS(1); glColor3f(r,g,b); return;}
+   capColor[0] = (unsigned char)(255*r+0.5);
+   capColor[1] = (unsigned char)(255*g+0.5);
+   capColor[2] = (unsigned char)(255*b+0.5);
+   capColor[3] = 255;
+}
+
+//  State changes reach OpenGL while recording too (through the cache),
+//  so OpenGL always holds what the draw functions last set
+void capBindTexture(GLenum target,unsigned int tex,const char* fn)
+{
+   int set = 1;
+   if (target==GL_TEXTURE_2D)
+      set = SetTex(tex);
+   else
+   {
+      PROF_CALLS(1);
+      glBindTexture(target,tex);
+   }
+   if (!capOn)
+      statsBind(fn,!set);
+   else if (target==GL_TEXTURE_2D)
+      capTexBound = tex;
+}
+
+void capEnable(GLenum cap,const char* fn)
+{
+   int set = SetCap(cap,1);
+   if (!capOn) {statsEnable(fn,!set); return;}
+   if (cap==GL_TEXTURE_2D) capTexOn = 1;
+   else if (cap==GL_BLEND) capBlendOn = 1;
+}
+
+void capDisable(GLenum cap,const char* fn)
+{
+   int set = SetCap(cap,0);
+   if (!capOn) {statsEnable(fn,!set); return;}
+   if (cap==GL_TEXTURE_2D) capTexOn = 0;
+   else if (cap==GL_BLEND) capBlendOn = 0;
+}
+
+//  Answered from the cache when it knows
+int capIsEnabled(GLenum cap)
+{
+   int k = CapSlot(cap);
+   if (k>=0 && (stateKnown & (1u<<k))) return (stateOn>>k) & 1;
+   int on = glIsEnabled(cap);
+   if (k>=0)
+   {
+      stateKnown |= 1u<<k;
+      if (on) stateOn |= 1u<<k; else stateOn &= ~(1u<<k);
+   }
+   return on;
+}
+
+void capUseProgram(unsigned int prog)
+{
+   if (stateCache && (stateHave & STATE_PROG) && stateProg==prog)
+   {
+      PROF_SAVED(1);
+      return;
+   }
+   PROF_CALLS(1);
+   glUseProgram(prog);
+   stateProg = prog;
+   stateHave |= STATE_PROG;
+}
+
+void capBlendFunc(GLenum sfactor,GLenum dfactor)
+{
+   SetBlendFunc(sfactor,dfactor);
+}
+
+//
+//  Specular material (front and back) is cached, the rest passes through
+//  (color material keeps changing ambient and diffuse behind our back)
+//
+void capMaterialf(GLenum face,GLenum pname,float v)
+{
+   if (pname==GL_SHININESS)
+   {
+      if (face==GL_FRONT_AND_BACK && stateCache && (stateHave & STATE_SHINY) && stateShiny==v)
+      {
+         PROF_SAVED(1);
+         return;
+      }
+      stateShiny = v;
+      if (face==GL_FRONT_AND_BACK) stateHave |= STATE_SHINY; else stateHave &= ~STATE_SHINY;
+   }
+   PROF_CALLS(1);
+   glMaterialf(face,pname,v);
+}
+
+void capMaterialfv(GLenum face,GLenum pname,const float* v)
+{
+   float* cache = pname==GL_SPECULAR ? stateSpec : pname==GL_EMISSION ? stateEmit : NULL;
+   int bit = pname==GL_SPECULAR ? STATE_SPEC : STATE_EMIT;
+   if (cache)
+   {
+      if (face==GL_FRONT_AND_BACK && stateCache && (stateHave & bit) && !memcmp(cache,v,4*sizeof(float)))
+      {
+         PROF_SAVED(1);
+         return;
+      }
+      memcpy(cache,v,4*sizeof(float));
+      if (face==GL_FRONT_AND_BACK) stateHave |= bit; else stateHave &= ~bit;
+   }
+   PROF_CALLS(1);
+   glMaterialfv(face,pname,v);
+}
+
+//
+//  Counted pass-throughs (nothing to record, the modelview is read at glBegin)
+//
+void capPushMatrix(const char* fn)                {PROF_CALLS(1); if (!capOn) statsPush(fn); glPushMatrix();}
+void capPopMatrix(void)                           {PROF_CALLS(1); glPopMatrix();}
+void capTranslated(double x,double y,double z)    {PROF_CALLS(1); glTranslated(x,y,z);}
+void capRotated(double a,double x,double y,double z) {PROF_CALLS(1); glRotated(a,x,y,z);}
+void capRotatef(float a,float x,float y,float z)  {PROF_CALLS(1); glRotatef(a,x,y,z);}
+void capScaled(double x,double y,double z)        {PROF_CALLS(1); glScaled(x,y,z);}
+void capScalef(float x,float y,float z)           {PROF_CALLS(1); glScalef(x,y,z);}
+void capLightf(GLenum light,GLenum pname,float v) {PROF_CALLS(1); glLightf(light,pname,v);}
+void capLightfv(GLenum light,GLenum pname,const float* v)  {PROF_CALLS(1); glLightfv(light,pname,v);}
+void capLineWidth(float w)                        {PROF_CALLS(1); glLineWidth(w);}
+void capTexParameteri(GLenum target,GLenum pname,int v)    {PROF_CALLS(1); glTexParameteri(target,pname,v);}
+void capTexParameterf(GLenum target,GLenum pname,float v)  {PROF_CALLS(1); glTexParameterf(target,pname,v);}
+void capDrawElements(GLenum mode,int count,GLenum type,const void* indices,const char* fn)
+{
+   PROF_CALLS(1);
+   statsDraw(fn,mode,count);
+   PROF_VERTS(count);
+   PROF_TRIS(TriCount(mode,count));
+   glDrawElements(mode,count,type,indices);
+}
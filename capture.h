@@ -0,0 +1,167 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+//
+//  Immediate-mode capture
+//  Kevin McMahon
+//
+//  Records whatever the draw functions emit between captureBegin() and
+//  captureEnd() (positions, normals, UVs, colors and the bound texture)
+//  into per-material triangle batches stored in one vertex buffer.
+//  The recorded Mesh replays with one glDrawArrays per material.
+//  capturePart() splits a recording into separately cullable parts, each
+//  with its own bounding box; drawMeshParts() replays just the parts asked
+//  for, still one call per material.
+//
+//  main.c includes this header after the GL headers so the immediate-mode
+//  entry points below route through the cap* wrappers.  When nothing is
+//  being recorded the wrappers just forward to OpenGL, counting vertices
+//  and calls for the profiler (profile.h).  The ones that make up the
+//  drawing work (glBegin, vertices, texture binds, enables, matrix pushes,
+//  glDrawElements) are function-like macros that also pass the caller's
+//  __func__, so the render statistics (stats.h) know which draw function
+//  asked for it.
+//
+//  The wrappers also keep a render-state cache: the enables, the bound
+//  texture, blend function, program and specular material they last set.
+//  A change to the value already set is skipped (and counted as saved),
+//  and glIsEnabled() is answered from the cache.  Code that changes that
+//  state behind the wrappers without putting it back calls
+//  stateInvalidate() so everything is set for real again.  drawMeshBatch()
+//  leaves its arrays bound for the next batch of the same mesh, which is
+//  how the render queue (queue.h) replays sorted batches; drawMeshDone()
+//  releases them.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// One run of triangles sharing the same texture and blend state
+typedef struct
+{
+   unsigned int tex;   // 0 = untextured
+   int blend;          // drawn in the blended pass
+   int first;          // first vertex in the mesh buffer
+   int count;          // number of vertices (multiple of 3)
+   int* part;          // npart+1 offsets: part p is vertices part[p]..part[p+1]-1
+} MeshBatch;
+
+// Vertices recorded by one draw function, for the render statistics
+typedef struct
+{
+   int first;          // first vertex
+   const char* fn;     // the recording function's __func__
+} MeshRun;
+
+typedef struct
+{
+   unsigned int vbo;   // interleaved vertices for all batches
+   int nvert;
+   int nbatch;
+   MeshBatch* batch;   // opaque batches first, then blended
+   int npart;          // parts started by capturePart(), 1 if none
+   float* box;         // per part: min x,y,z then max x,y,z (empty parts have min>max)
+   int nrun;           // runs of vertices recorded by one draw function
+   MeshRun* run;       // nrun+1 of them: run r is vertices run[r].first..run[r+1].first-1
+} Mesh;
+
+// Which batches drawMesh() replays
+#define MESH_OPAQUE  1
+#define MESH_BLENDED 2
+#define MESH_ALL     3
+
+// Placement of one copy of a mesh: translate, yaw about Y (degrees), scale
+typedef struct
+{
+   float x,y,z;
+   float yaw;
+   float scale;
+} MeshInstance;
+
+void  captureBegin(void);
+Mesh* captureEnd(void);
+int   capturePart(void);
+void  drawMesh(const Mesh* mesh,int pass);
+void  drawMeshParts(const Mesh* mesh,int pass,const unsigned char* show);
+void  drawMeshInstanced(const Mesh* mesh,int prog,unsigned int instVbo,int first,int ninst,int pass);
+void  drawMeshBatch(const Mesh* mesh,int b,int part,const unsigned char* show);
+void  drawMeshDone(void);
+void  freeMesh(Mesh* mesh);
+
+// Render-state cache
+extern int stateCache;   // 0 = every change reaches OpenGL
+void stateInvalidate(void);
+int  capIsEnabled(GLenum cap);
+void capUseProgram(unsigned int prog);
+
+// Wrapped immediate-mode entry points (fn = calling draw function)
+void capBegin(GLenum mode,const char* fn);
+void capEnd(void);
+void capVertex3d(double x,double y,double z,const char* fn);
+void capVertex3f(float x,float y,float z,const char* fn);
+void capNormal3d(double x,double y,double z);
+void capNormal3f(float x,float y,float z);
+void capTexCoord2d(double s,double t);
+void capTexCoord2f(float s,float t);
+void capColor3f(float r,float g,float b);
+void capBindTexture(GLenum target,unsigned int tex,const char* fn);
+void capEnable(GLenum cap,const char* fn);
+void capDisable(GLenum cap,const char* fn);
+void capBlendFunc(GLenum sfactor,GLenum dfactor);
+void capMaterialf(GLenum face,GLenum pname,float v);
+void capMaterialfv(GLenum face,GLenum pname,const float* v);
+// Counted for the profiler, otherwise passed straight through
+void capPushMatrix(const char* fn);
+void capPopMatrix(void);
+void capTranslated(double x,double y,double z);
+void capRotated(double a,double x,double y,double z);
+void capRotatef(float a,float x,float y,float z);
+void capScaled(double x,double y,double z);
+void capScalef(float x,float y,float z);
+void capLightf(GLenum light,GLenum pname,float v);
+void capLightfv(GLenum light,GLenum pname,const float* v);
+void capLineWidth(float w);
+void capTexParameteri(GLenum target,GLenum pname,int v);
+void capTexParameterf(GLenum target,GLenum pname,float v);
+void capDrawElements(GLenum mode,int count,GLenum type,const void* indices,const char* fn);
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifndef CAPTURE_IMPL
+#define glBegin(mode)       capBegin(mode,__func__)
+#define glEnd         capEnd
+#define glVertex3d(x,y,z)   capVertex3d(x,y,z,__func__)
+#define glVertex3f(x,y,z)   capVertex3f(x,y,z,__func__)
+#define glNormal3d    capNormal3d
+#define glNormal3f    capNormal3f
+#define glTexCoord2d  capTexCoord2d
+#define glTexCoord2f  capTexCoord2f
+#define glColor3f     capColor3f
+#define glBindTexture(target,tex) capBindTexture(target,tex,__func__)
+#define glEnable(cap)       capEnable(cap,__func__)
+#define glDisable(cap)      capDisable(cap,__func__)
+#define glPushMatrix()      capPushMatrix(__func__)
+#define glPopMatrix   capPopMatrix
+#define glTranslated  capTranslated
+#define glRotated     capRotated
+#define glRotatef     capRotatef
+#define glScaled      capScaled
+#define glScalef      capScalef
+#define glLightf      capLightf
+#define glLightfv     capLightfv
+#define glMaterialf   capMaterialf
+#define glMaterialfv  capMaterialfv
+#define glBlendFunc   capBlendFunc
+#define glLineWidth   capLineWidth
+#define glTexParameteri capTexParameteri
+#define glTexParameterf capTexParameterf
+#define glDrawElements(mode,count,type,indices) capDrawElements(mode,count,type,indices,__func__)
+#define glIsEnabled     capIsEnabled
+#undef  glUseProgram    // GLEW makes it a macro
+#define glUseProgram    capUseProgram
+#endif
+
+#endif
@@ -0,0 +1,562 @@
+//  Instanced crowd impostors
+//  Kevin McMahon
+#include "CSCIx229.h"
+#include "capture.h"
+#include "shader.h"
+#include "lights.h"
+#include "cull.h"
+#include "profile.h"
+#include "stats.h"
+#include "crowd.h"
+
+#define CELL_W  32                        // atlas cell in pixels
+#define CELL_H  64
+#define ATLAS_W (CROWD_VARIANTS*CELL_W)
+#define ATLAS_H (CROWD_POSES*CELL_H)
+#define LIGHT_W 256                       // light map: around the bowl ...
+#define LIGHT_H 16                        // ... and up the band
+#define SINK    0.3                       // card height sunk under the bleachers ...
+#define JITTER  0.05                      // ... less up to this much, so rows are not flat
+
+//  Shirt, skin and hair of each atlas column, and how wide the fan is
+typedef struct
+{
+   unsigned char shirt[3],skin[3],hair[3];
+   float build;
+   int cap;             // hair is a cap in the shirt color
+} Variant;
+
+static const Variant variant[CROWD_VARIANTS] =
+{
+   {{207,184,124},{224,180,150},{ 60, 40, 25},1.00,0},   // CU gold
+   {{ 28, 28, 30},{190,140,100},{ 25, 20, 15},1.10,0},   // black
+   {{235,235,230},{235,195,165},{160,120, 60},0.90,0},   // white
+   {{207,184,124},{120, 85, 60},{ 20, 15, 10},1.05,1},   // gold, gold cap
+   {{162,164,163},{224,180,150},{ 90, 60, 35},0.95,0},   // silver
+   {{ 28, 28, 30},{235,195,165},{200,170,110},0.90,1},   // black, black cap
+   {{180,155, 95},{160,115, 80},{ 30, 22, 15},1.15,0},   // old gold
+   {{ 70, 72, 78},{224,180,150},{ 50, 35, 20},1.00,0},   // charcoal
+};
+
+//
+//  Fixed hash of an integer to 0..1, so the seating is the same every run
+//
+static float Rand(unsigned int k)
+{
+   k ^= k>>16; k *= 0x7feb352d;
+   k ^= k>>15; k *= 0x846ca68b;
+   k ^= k>>16;
+   return k/4294967296.0f;
+}
+
+//
+//  Is x,y inside the capsule from a to b of radius r
+//
+static int Capsule(float x,float y,float ax,float ay,float bx,float by,float r)
+{
+   float dx = bx-ax,dy = by-ay;
+   float t = ((x-ax)*dx + (y-ay)*dy)/(dx*dx + dy*dy);
+   t = t<0 ? 0 : t>1 ? 1 : t;
+   float ex = x-ax-t*dx,ey = y-ay-t*dy;
+   return ex*ex + ey*ey <= r*r;
+}
+
+//
+//  Paint one fan into its cell (y up, feet at the bottom): head, shirt,
+//  arms at the sides (pose 0) or over the head (pose 1)
+//
+static void PaintFan(unsigned char* rgba,int col,int pose)
+{
+   const Variant* v = variant+col;
+   const unsigned char pants[3] = {40,45,60};
+   const float cx = CELL_W/2.0;
+   const float half = 8.5*v->build;           // half the shoulders
+   for (int j=0;j<CELL_H;j++)
+      for (int i=0;i<CELL_W;i++)
+      {
+         float x = i+0.5,y = j+0.5;
+         float dx = x-cx;
+         const unsigned char* c = NULL;
+         float shade = 1;
+         //  Arms first so the torso covers the shoulders
+         for (int s=-1;s<=1;s+=2)
+         {
+            float sx = cx + s*(half-1.5);
+            if (pose==0 ? Capsule(x,y,sx,39,cx+s*(half+1.0),17,2.0)
+                        : Capsule(x,y,sx,39,cx+s*(half+4.0),60,2.0))
+               c = (pose==0 ? y>30 : y<47) ? v->shirt : v->skin;
+         }
+         //  Torso, rounded at the shoulders and darker at the sides
+         float w = half - (y>38 ? 1.2*(y-38) : 0);
+         if (y>=8 && y<43 && fabs(dx)<w)
+         {
+            c = v->shirt;
+            shade = 1 - 0.3*(dx/w)*(dx/w);
+         }
+         else if (y<8 && fabs(dx)<half-1)
+            c = pants;
+         //  Neck, then the head with hair (or a cap) on top
+         if (y>=42 && y<46 && fabs(dx)<2.5)
+            c = v->skin;
+         float hy = y-51;
+         if (dx*dx + hy*hy < 6.2*6.2)
+         {
+            c = v->skin;
+            if (v->cap ? (hy>1.0 || (hy>0.0 && dx>-2)) : (hy>1.5 || (hy>-3 && fabs(dx)>4.8)))
+               c = v->cap ? v->shirt : v->hair;
+            shade = 1 - 0.2*(dx*dx + hy*hy)/(6.2*6.2);
+         }
+         unsigned char* p = rgba + 4*((pose*CELL_H + j)*ATLAS_W + col*CELL_W + i);
+         if (c)
+         {
+            for (int k=0;k<3;k++)
+               p[k] = (unsigned char)(shade*c[k]);
+            p[3] = 255;
+         }
+         else
+         {
+            //  Transparent texels dark, so the filtered edges do not glow
+            p[0] = p[1] = p[2] = 30;
+            p[3] = 0;
+         }
+      }
+}
+
+//
+//  Every variant in every pose, mipmapped, and how much of its cell the
+//  widest and tallest figure in each pose fills
+//
+static void BuildAtlas(Crowd* crowd)
+{
+   unsigned char* rgba = (unsigned char*)malloc(4*ATLAS_W*ATLAS_H);
+   if (!rgba) Fatal("Cannot allocate crowd atlas\n");
+   for (int pose=0;pose<CROWD_POSES;pose++)
+   {
+      for (int col=0;col<CROWD_VARIANTS;col++)
+         PaintFan(rgba,col,pose);
+      //  Opaque texels, plus one for the filtering
+      float reach = 0,top = 0;
+      for (int j=0;j<CELL_H;j++)
+         for (int i=0;i<ATLAS_W;i++)
+            if (rgba[4*((pose*CELL_H + j)*ATLAS_W + i) + 3])
+            {
+               float dx = fabs(i%CELL_W + 0.5 - CELL_W/2.0);
+               if (dx>reach) reach = dx;
+               if (j>top) top = j;
+            }
+      crowd->fill[pose][0] = fmin(2*(reach+1.5)/CELL_W,1);
+      crowd->fill[pose][1] = fmin((top+2.0)/CELL_H,1);
+   }
+   glGenTextures(1,&crowd->tex);
+   glBindTexture(GL_TEXTURE_2D,crowd->tex);
+   glTexImage2D(GL_TEXTURE_2D,0,GL_RGBA,ATLAS_W,ATLAS_H,0,GL_RGBA,GL_UNSIGNED_BYTE,rgba);
+   glGenerateMipmap(GL_TEXTURE_2D);
+   //  One mip level per texel: blending two is lost on figures this small
+   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR_MIPMAP_NEAREST);
+   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);
+   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
+   glBindTexture(GL_TEXTURE_2D,0);
+   free(rgba);
+   ErrCheck("Crowd atlas");
+}
+
+//
+//  Point d along the rectangle hx by hz starting at its -x,-z corner and
+//  going +x first, and which way a fan there faces the court
+//
+static void RowPoint(float d,float hx,float hz,float* x,float* z,float* yaw)
+{
+   if (d<2*hx)                  {*x = -hx+d; *z = -hz;   *yaw =   0;}
+   else if ((d-=2*hx)<2*hz)     {*x =  hx;   *z = -hz+d; *yaw = -90;}
+   else if ((d-=2*hz)<2*hx)     {*x =  hx-d; *z =  hz;   *yaw = 180;}
+   else                         {d -= 2*hx;  *x = -hx;   *z = hz-d; *yaw = 90;}
+}
+
+//
+//  Run of the bowl a fan sits in
+//
+static int Seg(const CrowdFan* f)
+{
+   int s = (int)(f->around*CROWD_SEGS);
+   return s<0 ? 0 : s<CROWD_SEGS ? s : CROWD_SEGS-1;
+}
+
+//
+//  Seat fans in rows up the band between the rectangle offLo out
+//  from the court (hx by hz) at height yLo and offHi out at yHi
+//
+void CrowdInit(Crowd* crowd,int seats,int rows,float hx,float hz,float offLo,float offHi,float yLo,float yHi)
+{
+   memset(crowd,0,sizeof(Crowd));
+   if (seats<1 || rows<1) return;
+   CrowdFan* fan = (CrowdFan*)malloc(seats*sizeof(CrowdFan));
+   float* row = (float*)malloc(seats*sizeof(float));
+   crowd->fan = (CrowdFan*)malloc(seats*sizeof(CrowdFan));
+   crowd->row = (float*)malloc(seats*sizeof(float));
+   crowd->light = (unsigned char*)malloc(4*seats);
+   if (!fan || !row || !crowd->fan || !crowd->row || !crowd->light) Fatal("Cannot allocate %d fans\n",seats);
+
+   //  The seat pitch sizes the cards, and a card's height decides how far
+   //  up the band the top row can sit (its head level with the shell), so
+   //  settle both together
+   float top = 1,pitch = 0;
+   for (int pass=0;pass<2;pass++)
+   {
+      float len = 0;
+      for (int r=0;r<rows;r++)
+         len += 4*(hx+hz+2*(offLo + top*(r+0.5)/rows*(offHi-offLo)));
+      pitch = len/seats;
+      crowd->width = 1.15*pitch;
+      crowd->height = 2*crowd->width;
+      top = 1 - 0.7*crowd->height/(yHi-yLo);
+   }
+
+   //  Seats go to the rows by length; each row's count rounds the running
+   //  total so they add up to exactly seats
+   float len = 0;
+   int n = 0;
+   for (int r=0;r<rows;r++)
+   {
+      float t = top*(r+0.5)/rows;
+      float off = offLo + t*(offHi-offLo);
+      float rhx = hx+off,rhz = hz+off;
+      float perim = 4*(rhx+rhz);
+      len += perim;
+      int end = r==rows-1 ? seats : (int)(len/pitch+0.5);
+      int count = end-n;
+      //  The bottom of each card sinks under the bleachers
+      float y = yLo + t*(yHi-yLo) - SINK*crowd->height;
+      for (int k=0;k<count;k++)
+      {
+         CrowdFan* f = fan+n+k;
+         unsigned int id = 5*(n+k);
+         float d = (k+0.5+0.3*(Rand(id)-0.5))*perim/count;
+         float yaw;
+         RowPoint(d,rhx,rhz,&f->x,&f->z,&yaw);
+         f->y = y + JITTER*crowd->height*Rand(id+1);
+         f->variant = (int)(CROWD_VARIANTS*Rand(id+2));
+         f->phase = Rand(id+3);
+         f->shade = 0.8 + 0.3*Rand(id+4);
+         f->around = d/perim;
+         row[n+k] = (r+0.5)/rows;
+      }
+      n = end;
+   }
+   crowd->n = n;
+
+   //  Sort the fans into runs around the bowl (keeping the rows in order),
+   //  and box each run: cards turn to the viewer and stand up to a quarter
+   //  of their height
+   int at[CROWD_SEGS];
+   float box[6*CROWD_SEGS];
+   memset(crowd->seg,0,sizeof(crowd->seg));
+   for (int i=0;i<n;i++)
+      crowd->seg[Seg(fan+i)+1]++;
+   for (int s=0;s<CROWD_SEGS;s++)
+   {
+      crowd->seg[s+1] += crowd->seg[s];
+      at[s] = crowd->seg[s];
+      box[6*s] = box[6*s+1] = box[6*s+2] = 1e30;
+      box[6*s+3] = box[6*s+4] = box[6*s+5] = -1e30;
+   }
+   for (int i=0;i<n;i++)
+   {
+      int s = Seg(fan+i);
+      crowd->fan[at[s]] = fan[i];
+      crowd->row[at[s]++] = row[i];
+      float* b = box + 6*s;
+      const float lo[3] = {fan[i].x-0.5*crowd->width,fan[i].y,fan[i].z-0.5*crowd->width};
+      const float hi[3] = {fan[i].x+0.5*crowd->width,fan[i].y+1.25*crowd->height,fan[i].z+0.5*crowd->width};
+      for (int k=0;k<3;k++)
+      {
+         if (lo[k]<b[k]) b[k] = lo[k];
+         if (hi[k]>b[k+3]) b[k+3] = hi[k];
+      }
+   }
+   BvhBuild(&crowd->tree,box,CROWD_SEGS);
+   free(fan);
+   free(row);
+
+   glGenBuffers(1,&crowd->vbo);
+   glBindBuffer(GL_ARRAY_BUFFER,crowd->vbo);
+   glBufferData(GL_ARRAY_BUFFER,n*sizeof(CrowdFan),crowd->fan,GL_STATIC_DRAW);
+   //  Lights, white until the map is first lit
+   memset(crowd->light,255,4*n);
+   glGenBuffers(1,&crowd->lightFan);
+   glBindBuffer(GL_ARRAY_BUFFER,crowd->lightFan);
+   glBufferData(GL_ARRAY_BUFFER,4*n,crowd->light,GL_DYNAMIC_DRAW);
+   //  Unit card: x across, y up from the feet
+   const float card[8] = {-0.5,0, 0.5,0, -0.5,1, 0.5,1};
+   glGenBuffers(1,&crowd->card);
+   glBindBuffer(GL_ARRAY_BUFFER,crowd->card);
+   glBufferData(GL_ARRAY_BUFFER,sizeof(card),card,GL_STATIC_DRAW);
+   BuildAtlas(crowd);
+
+   //  Light map samples: position and normal of a fan's upper body at each
+   //  texel, then the texel in clip coordinates
+   float* sample = (float*)malloc(8*LIGHT_W*LIGHT_H*sizeof(float));
+   if (!sample) Fatal("Cannot allocate crowd light samples\n");
+   for (int j=0;j<LIGHT_H;j++)
+   {
+      float t = top*j/(LIGHT_H-1);
+      float off = offLo + t*(offHi-offLo);
+      float rhx = hx+off,rhz = hz+off;
+      for (int i=0;i<LIGHT_W;i++)
+      {
+         float* v = sample + 8*(j*LIGHT_W+i);
+         float yaw;
+         RowPoint(4*(rhx+rhz)*i/LIGHT_W,rhx,rhz,v,v+2,&yaw);
+         v[1] = yLo + t*(yHi-yLo) + 0.3*crowd->height;
+         v[3] = sinf(yaw*(M_PI/180));
+         v[4] = 0.7;
+         v[5] = cosf(yaw*(M_PI/180));
+         v[6] = 2*(i+0.5)/LIGHT_W-1;
+         v[7] = 2*(j+0.5)/LIGHT_H-1;
+      }
+   }
+   glGenBuffers(1,&crowd->lightVbo);
+   glBindBuffer(GL_ARRAY_BUFFER,crowd->lightVbo);
+   glBufferData(GL_ARRAY_BUFFER,8*LIGHT_W*LIGHT_H*sizeof(float),sample,GL_STATIC_DRAW);
+   glBindBuffer(GL_ARRAY_BUFFER,0);
+   free(sample);
+
+   //  The light map wraps around the bowl, drawn into and read back
+   glGenTextures(1,&crowd->lightMap);
+   glBindTexture(GL_TEXTURE_2D,crowd->lightMap);
+   glTexImage2D(GL_TEXTURE_2D,0,GL_RGBA,LIGHT_W,LIGHT_H,0,GL_RGBA,GL_UNSIGNED_BYTE,NULL);
+   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_NEAREST);
+   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_NEAREST);
+   glBindTexture(GL_TEXTURE_2D,0);
+   int prev;
+   glGetIntegerv(GL_FRAMEBUFFER_BINDING,&prev);
+   glGenFramebuffers(1,&crowd->lightFbo);
+   glBindFramebuffer(GL_FRAMEBUFFER,crowd->lightFbo);
+   glFramebufferTexture2D(GL_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_TEXTURE_2D,crowd->lightMap,0);
+   if (glCheckFramebufferStatus(GL_FRAMEBUFFER)!=GL_FRAMEBUFFER_COMPLETE)
+   {
+      glDeleteFramebuffers(1,&crowd->lightFbo);
+      crowd->lightFbo = 0;
+   }
+   glBindFramebuffer(GL_FRAMEBUFFER,prev);
+   ErrCheck("CrowdInit");
+}
+
+//
+//  Everything the light map depends on from the fixed-function lights,
+//  taken back to world coordinates through the view (the modelview here)
+//  so the camera moving changes nothing
+//
+static void LightState(float s[CROWD_LIGHT_STATE])
+{
+   float mv[16];
+   PROF_GL(glGetFloatv(GL_MODELVIEW_MATRIX,mv));
+   memset(s,0,CROWD_LIGHT_STATE*sizeof(float));
+   s[0] = glIsEnabled(GL_LIGHTING);
+   PROF_GL(glGetFloatv(GL_LIGHT_MODEL_AMBIENT,s+1));
+   for (int i=0;i<8;i++)
+   {
+      float v[4],*p = s + 5 + 21*i;
+      p[0] = glIsEnabled(GL_LIGHT0+i);
+      if (!p[0]) continue;
+      //  eye -> world: the transposed rotation after taking off the
+      //  translation (directions and w=0 positions only rotate)
+      PROF_GL(glGetLightfv(GL_LIGHT0+i,GL_POSITION,v));
+      for (int j=0;j<3;j++)
+         p[1+j] = mv[4*j]*(v[0]-mv[12]*v[3]) + mv[4*j+1]*(v[1]-mv[13]*v[3]) + mv[4*j+2]*(v[2]-mv[14]*v[3]);
+      p[4] = v[3];
+      PROF_GL(glGetLightfv(GL_LIGHT0+i,GL_SPOT_DIRECTION,v));
+      for (int j=0;j<3;j++)
+         p[5+j] = mv[4*j]*v[0] + mv[4*j+1]*v[1] + mv[4*j+2]*v[2];
+      PROF_GL(glGetLightfv(GL_LIGHT0+i,GL_AMBIENT,p+8));
+      PROF_GL(glGetLightfv(GL_LIGHT0+i,GL_DIFFUSE,p+12));
+      PROF_GL(glGetLightfv(GL_LIGHT0+i,GL_SPOT_CUTOFF,p+16));
+      PROF_GL(glGetLightfv(GL_LIGHT0+i,GL_SPOT_EXPONENT,p+17));
+      PROF_GL(glGetLightfv(GL_LIGHT0+i,GL_CONSTANT_ATTENUATION,p+18));
+      PROF_GL(glGetLightfv(GL_LIGHT0+i,GL_LINEAR_ATTENUATION,p+19));
+      PROF_GL(glGetLightfv(GL_LIGHT0+i,GL_QUADRATIC_ATTENUATION,p+20));
+   }
+}
+
+//
+//  Whether the lights moved on from the ones the map was lit under: the
+//  clustered list exactly, the fixed-function state to a part in a
+//  thousand so the round trip through the eye coordinates does not count
+//
+static int LightsChanged(Crowd* crowd)
+{
+   float s[CROWD_LIGHT_STATE];
+   unsigned int hash = LightsHash();
+   int changed = !crowd->lit || hash!=crowd->lightHash;
+   LightState(s);
+   for (int k=0;k<CROWD_LIGHT_STATE && !changed;k++)
+      changed = fabs(s[k]-crowd->lightState[k]) > 1e-3*(1+fabs(crowd->lightState[k]));
+   if (changed)
+   {
+      crowd->lightHash = hash;
+      memcpy(crowd->lightState,s,sizeof(s));
+   }
+   return changed;
+}
+
+//
+//  Each fan's light from the map, filtered between the four texels around
+//  its seat like the texture would be, into the cards' light buffer
+//
+static void ReadLight(Crowd* crowd)
+{
+   static unsigned char map[LIGHT_H][LIGHT_W][4];
+   PROF_GL(glReadPixels(0,0,LIGHT_W,LIGHT_H,GL_RGBA,GL_UNSIGNED_BYTE,map));
+   for (int i=0;i<crowd->n;i++)
+   {
+      //  Texel centers: around the bowl from the first, up the rows from
+      //  the bottom row to the top one
+      float u = crowd->fan[i].around*LIGHT_W;
+      float v = crowd->row[i]*(LIGHT_H-1);
+      int i0 = (int)u,j0 = (int)v;
+      float fu = u-i0,fv = v-j0;
+      i0 %= LIGHT_W;
+      int i1 = (i0+1)%LIGHT_W;
+      int j1 = j0<LIGHT_H-1 ? j0+1 : j0;
+      for (int k=0;k<3;k++)
+         crowd->light[4*i+k] = (unsigned char)((1-fv)*((1-fu)*map[j0][i0][k] + fu*map[j0][i1][k]) +
+                                                 fv *((1-fu)*map[j1][i0][k] + fu*map[j1][i1][k]) + 0.5);
+      crowd->light[4*i+3] = 255;
+   }
+   PROF_GL(glBindBuffer(GL_ARRAY_BUFFER,crowd->lightFan));
+   PROF_GL(glBufferSubData(GL_ARRAY_BUFFER,0,4*crowd->n,crowd->light));
+   PROF_GL(glBindBuffer(GL_ARRAY_BUFFER,0));
+}
+
+//
+//  Light every texel of the light map with lightProg under the current
+//  lights and modelview, one point per texel into the map's framebuffer,
+//  and hand it to the fans; nothing to do while the lights stay the same
+//
+static void LightMap(Crowd* crowd,int lightProg)
+{
+   if (!crowd->lightFbo || !lightProg) return;
+   if (!LightsChanged(crowd)) return;
+   crowd->lit = 1;
+
+   int prev,vp[4];
+   PROF_GL(glGetIntegerv(GL_FRAMEBUFFER_BINDING,&prev));
+   PROF_GL(glGetIntegerv(GL_VIEWPORT,vp));
+   PROF_GL(glBindFramebuffer(GL_FRAMEBUFFER,crowd->lightFbo));
+   PROF_GL(glViewport(0,0,LIGHT_W,LIGHT_H));
+
+   glUseProgram(lightProg);
+   SetLightUniforms(lightProg);
+   LightsBind(lightProg);
+   PROF_GL(glBindBuffer(GL_ARRAY_BUFFER,crowd->lightVbo));
+   PROF_GL(glEnableClientState(GL_VERTEX_ARRAY));
+   PROF_GL(glEnableClientState(GL_NORMAL_ARRAY));
+   PROF_GL(glEnableClientState(GL_TEXTURE_COORD_ARRAY));
+   PROF_GL(glVertexPointer(3,GL_FLOAT,8*sizeof(float),(void*)0));
+   PROF_GL(glNormalPointer(GL_FLOAT,8*sizeof(float),(void*)(3*sizeof(float))));
+   PROF_GL(glTexCoordPointer(2,GL_FLOAT,8*sizeof(float),(void*)(6*sizeof(float))));
+   PROF_GL(glDrawArrays(GL_POINTS,0,LIGHT_W*LIGHT_H));
+   statsDraw(__func__,GL_POINTS,LIGHT_W*LIGHT_H);
+   PROF_VERTS(LIGHT_W*LIGHT_H);
+   PROF_GL(glDisableClientState(GL_TEXTURE_COORD_ARRAY));
+   PROF_GL(glDisableClientState(GL_NORMAL_ARRAY));
+   PROF_GL(glDisableClientState(GL_VERTEX_ARRAY));
+   PROF_GL(glBindBuffer(GL_ARRAY_BUFFER,0));
+   ReadLight(crowd);
+
+   PROF_GL(glBindFramebuffer(GL_FRAMEBUFFER,prev));
+   PROF_GL(glViewport(vp[0],vp[1],vp[2],vp[3]));
+}
+
+//
+//  The fans in view (all when view is NULL) with prog (shaders/crowd.vert)
+//  at time seconds, cheer seconds after the last basket, the wave going or
+//  not; the light map is lit with lightProg (shaders/crowdlight.vert) first
+//  if the lights changed.  One instanced draw per stretch of runs in view.
+//
+void CrowdDraw(Crowd* crowd,int prog,int lightProg,float time,float cheer,int wave,const Frustum* view)
+{
+   if (!crowd->n || !prog) return;
+   LightMap(crowd,lightProg);
+   if (view && !BvhCull(&crowd->tree,view,crowd->shown)) return;
+
+   const int stride = sizeof(CrowdFan);
+   int inst  = PROF_GL(glGetAttribLocation(prog,"Inst"));
+   int fan   = PROF_GL(glGetAttribLocation(prog,"Fan"));
+   int seat  = PROF_GL(glGetAttribLocation(prog,"Seat"));
+   int light = PROF_GL(glGetAttribLocation(prog,"Light"));
+
+   //  Card axes in eye coordinates: the world vertical, and across it
+   //  square to the view direction (straight across when looking down)
+   float mv[16];
+   PROF_GL(glGetFloatv(GL_MODELVIEW_MATRIX,mv));
+   float scale = sqrtf(mv[4]*mv[4] + mv[5]*mv[5] + mv[6]*mv[6]);
+   float r = sqrtf(mv[4]*mv[4] + mv[5]*mv[5]);
+   float rx = r>1e-4*scale ? mv[5]/r*scale : scale;
+   float ry = r>1e-4*scale ? -mv[4]/r*scale : 0;
+
+   glUseProgram(prog);
+   PROF_GL(glUniform3f(PROF_GL(glGetUniformLocation(prog,"Right")),crowd->width*rx,crowd->width*ry,0));
+   PROF_GL(glUniform3f(PROF_GL(glGetUniformLocation(prog,"Up")),crowd->height*mv[4],crowd->height*mv[5],crowd->height*mv[6]));
+   PROF_GL(glUniform1f(PROF_GL(glGetUniformLocation(prog,"Time")),time));
+   PROF_GL(glUniform1f(PROF_GL(glGetUniformLocation(prog,"Cheer")),cheer));
+   PROF_GL(glUniform1f(PROF_GL(glGetUniformLocation(prog,"Wave")),wave ? 1.0 : 0.0));
+   PROF_GL(glUniform2f(PROF_GL(glGetUniformLocation(prog,"Atlas")),CROWD_VARIANTS,CROWD_POSES));
+   PROF_GL(glUniform4f(PROF_GL(glGetUniformLocation(prog,"Fill")),crowd->fill[0][0],crowd->fill[0][1],crowd->fill[1][0],crowd->fill[1][1]));
+   PROF_GL(glUniform1f(PROF_GL(glGetUniformLocation(prog,"Sunk")),SINK-JITTER));
+   PROF_GL(glUniform1f(PROF_GL(glGetUniformLocation(prog,"WavePeriod")),CROWD_WAVE));
+   PROF_GL(glUniform1f(PROF_GL(glGetUniformLocation(prog,"CheerTime")),CROWD_CHEER));
+   PROF_GL(glUniform1f(PROF_GL(glGetUniformLocation(prog,"CheerLag")),CROWD_LAG));
+   PROF_GL(glUniform1i(PROF_GL(glGetUniformLocation(prog,"Tex")),0));
+   glBindTexture(GL_TEXTURE_2D,crowd->tex);
+
+   PROF_GL(glBindBuffer(GL_ARRAY_BUFFER,crowd->card));
+   PROF_GL(glEnableClientState(GL_VERTEX_ARRAY));
+   PROF_GL(glVertexPointer(2,GL_FLOAT,0,(void*)0));
+   //  Per-fan attributes advance once per card
+   PROF_GL(glEnableVertexAttribArray(inst));
+   PROF_GL(glEnableVertexAttribArray(fan));
+   PROF_GL(glEnableVertexAttribArray(seat));
+   PROF_GL(glEnableVertexAttribArray(light));
+   PROF_GL(glVertexAttribDivisor(inst,1));
+   PROF_GL(glVertexAttribDivisor(fan,1));
+   PROF_GL(glVertexAttribDivisor(seat,1));
+   PROF_GL(glVertexAttribDivisor(light,1));
+
+   //  Each stretch of neighbouring runs in view from its first fan
+   for (int s=0;s<CROWD_SEGS;)
+   {
+      if (view && !crowd->shown[s])
+      {
+         s++;
+         continue;
+      }
+      int e = s+1;
+      while (e<CROWD_SEGS && (!view || crowd->shown[e])) e++;
+      const int first = crowd->seg[s],count = crowd->seg[e]-first;
+      s = e;
+      if (!count) continue;
+      PROF_GL(glBindBuffer(GL_ARRAY_BUFFER,crowd->vbo));
+      PROF_GL(glVertexAttribPointer(inst,3,GL_FLOAT,GL_FALSE,stride,(void*)((size_t)first*stride)));
+      PROF_GL(glVertexAttribPointer(fan,3,GL_FLOAT,GL_FALSE,stride,(void*)((size_t)first*stride+3*sizeof(float))));
+      PROF_GL(glVertexAttribPointer(seat,1,GL_FLOAT,GL_FALSE,stride,(void*)((size_t)first*stride+6*sizeof(float))));
+      PROF_GL(glBindBuffer(GL_ARRAY_BUFFER,crowd->lightFan));
+      PROF_GL(glVertexAttribPointer(light,3,GL_UNSIGNED_BYTE,GL_TRUE,4,(void*)(4*(size_t)first)));
+      PROF_GL(glDrawArraysInstanced(GL_TRIANGLE_STRIP,0,4,count));
+      statsDraw(__func__,GL_TRIANGLE_STRIP,4ul*count);
+      PROF_VERTS(4*count);
+      PROF_TRIS(2*count);
+   }
+
+   PROF_GL(glVertexAttribDivisor(inst,0));
+   PROF_GL(glVertexAttribDivisor(fan,0));
+   PROF_GL(glVertexAttribDivisor(seat,0));
+   PROF_GL(glVertexAttribDivisor(light,0));
+   PROF_GL(glDisableVertexAttribArray(inst));
+   PROF_GL(glDisableVertexAttribArray(fan));
+   PROF_GL(glDisableVertexAttribArray(seat));
+   PROF_GL(glDisableVertexAttribArray(light));
+   PROF_GL(glDisableClientState(GL_VERTEX_ARRAY));
+   PROF_GL(glBindBuffer(GL_ARRAY_BUFFER,0));
+   glUseProgram(0);
+}
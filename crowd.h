@@ -0,0 +1,92 @@
+#ifndef CROWD_H
+#define CROWD_H
+
+//
+//  Instanced crowd impostors
+//  Kevin McMahon
+//
+//  Fills the bleacher band around the court with one flat card per fan,
+//  all drawn with a single glDrawArraysInstanced.  CrowdInit() lays the
+//  seats out in rows up the band (rectangles around the court, growing
+//  from the low rail to the tall shell), spreading the seat count over
+//  the rows by their length so every row has the same seat pitch.  Each
+//  fan gets a variant (shirt color, build, hair), a phase and a shade from
+//  a fixed hash of its seat, so the layout is the same every run.
+//
+//  The variants are painted into a small texture atlas at startup: one
+//  column per variant, one row per pose (seated with arms down, standing
+//  with arms up).  shaders/crowd.vert turns every card toward the viewer
+//  about the vertical and animates it: standing and waving as the wave
+//  passes or after a basket, each fan a bit out of step with its
+//  neighbours.  Seated fans hold still, so the scene can stop redrawing.  Each card only covers what can
+//  show: the cell as wide and tall as its pose's figures (measured when
+//  the atlas is painted), from where the bleachers stop hiding the feet.
+//  The fragment stage only samples the atlas and drops the transparent
+//  texels, so the crowd needs no sorting.
+//
+//  Fans are not lit one by one.  The lights are run once per texel of a
+//  small light map wrapped around the band (around the bowl by up the
+//  rows, shaders/crowdlight.vert drawing one point per texel), the map is
+//  read back, and every fan gets the light at its seat as a per-instance
+//  attribute.  The map is ambient and diffuse only, so it holds from any
+//  viewpoint and is only lit again when the lights change.
+//
+//  The fans are stored in runs around the bowl, each with a box in a cull
+//  tree (cull.h), and only the runs in the view frustum are drawn: one
+//  instanced draw for every stretch of neighbouring runs in view.
+//
+//  Needs capture.h, cull.h and lights.h included first.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CROWD_VARIANTS 8     // atlas columns
+#define CROWD_POSES    2     // atlas rows: seated, arms up
+#define CROWD_WAVE     12.0  // seconds for the wave to go around the bowl
+#define CROWD_CHEER    3.0   // seconds the crowd stands after a basket
+#define CROWD_LAG      0.5   // seconds the cheer takes to reach the last fan
+#define CROWD_SEGS     64    // runs of fans around the bowl, culled whole
+#define CROWD_LIGHT_STATE (5+8*21)   // fixed-function light state the light map depends on
+
+//  One fan, as the per-instance attributes of the card
+typedef struct
+{
+   float x,y,z;       // feet on the row
+   float variant;     // atlas column
+   float phase;       // 0..1, offsets this fan's timing
+   float shade;       // brightness
+   float around;      // 0..1 position around the bowl (the wave follows it)
+} CrowdFan;
+
+typedef struct
+{
+   int n;
+   CrowdFan* fan;        // by run around the bowl, up the rows in each
+   float* row;           // 0..1 up the rows, where each fan reads the light map
+   float width,height;   // card size
+   unsigned int vbo;     // fans
+   unsigned int card;    // unit card, a 4 vertex strip
+   unsigned int tex;     // variant atlas
+   float fill[CROWD_POSES][2];       // share of the card width and height the figures take
+   unsigned int lightMap,lightFbo;   // light map and its framebuffer (0 = unlit)
+   unsigned int lightVbo;            // a point per light map texel
+   unsigned int lightHash;           // the clustered lights the map was last lit under
+   float lightState[CROWD_LIGHT_STATE];   // ... and the fixed-function ones
+   int lit;                          // 0 until the map is first lit
+   unsigned char* light;             // each fan's light, rgba
+   unsigned int lightFan;            // the same for the cards
+   int seg[CROWD_SEGS+1];            // run s is fans seg[s] to seg[s+1]-1
+   Bvh tree;                         // a box per run
+   unsigned char shown[CROWD_SEGS];  // runs in view
+} Crowd;
+
+void CrowdInit(Crowd* crowd,int seats,int rows,float hx,float hz,float offLo,float offHi,float yLo,float yHi);
+void CrowdDraw(Crowd* crowd,int prog,int lightProg,float time,float cheer,int wave,const Frustum* view);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,158 @@
+//  View-frustum culling
+//  Kevin McMahon
+#include "CSCIx229.h"
+#include "cull.h"
+
+//  Build state for the qsort comparison
+static const float* sortBox;
+static int sortAxis;
+
+//
+//  Order props by box center along sortAxis
+//
+static int ByCenter(const void* a,const void* b)
+{
+   const float* A = sortBox + 6*(*(const int*)a);
+   const float* B = sortBox + 6*(*(const int*)b);
+   float ca = A[sortAxis]+A[sortAxis+3];
+   float cb = B[sortAxis]+B[sortAxis+3];
+   return ca<cb ? -1 : ca>cb;
+}
+
+//
+//  Fill node k with items first..first+count-1 and split it
+//
+static void Build(Bvh* bvh,const float* box,int k,int first,int count)
+{
+   BvhNode* nd = bvh->node+k;
+   float clo[3] = {1e30,1e30,1e30};
+   float chi[3] = {-1e30,-1e30,-1e30};
+   for (int c=0;c<3;c++)
+   {
+      nd->lo[c] = 1e30;
+      nd->hi[c] = -1e30;
+   }
+   for (int i=first;i<first+count;i++)
+   {
+      const float* b = box + 6*bvh->item[i];
+      for (int c=0;c<3;c++)
+      {
+         float m = 0.5*(b[c]+b[c+3]);
+         if (b[c]<nd->lo[c]) nd->lo[c] = b[c];
+         if (b[c+3]>nd->hi[c]) nd->hi[c] = b[c+3];
+         if (m<clo[c]) clo[c] = m;
+         if (m>chi[c]) chi[c] = m;
+      }
+   }
+   nd->first = first;
+   nd->count = count;
+   nd->kid = 0;
+   if (count<=BVH_LEAF) return;
+
+   //  Median split across the widest spread of centers
+   sortAxis = 0;
+   for (int c=1;c<3;c++)
+      if (chi[c]-clo[c] > chi[sortAxis]-clo[sortAxis]) sortAxis = c;
+   sortBox = box;
+   qsort(bvh->item+first,count,sizeof(int),ByCenter);
+   int half = count/2;
+   int kid = bvh->nnode;
+   bvh->nnode += 2;
+   bvh->node[k].kid = kid;
+   Build(bvh,box,kid,first,half);
+   Build(bvh,box,kid+1,first+half,count-half);
+}
+
+//
+//  Build the tree over n boxes (6 floats each); the boxes are not kept
+//
+void BvhBuild(Bvh* bvh,const float* box,int n)
+{
+   bvh->nprop = n;
+   bvh->nitem = 0;
+   bvh->item = (int*)malloc((n ? n : 1)*sizeof(int));
+   bvh->node = (BvhNode*)malloc((n ? 2*n : 1)*sizeof(BvhNode));
+   if (!bvh->item || !bvh->node) Fatal("Cannot allocate BVH for %d props\n",n);
+   for (int i=0;i<n;i++)
+      if (box[6*i]<=box[6*i+3]) bvh->item[bvh->nitem++] = i;
+   bvh->nnode = 1;
+   Build(bvh,box,0,0,bvh->nitem);
+}
+
+void BvhFree(Bvh* bvh)
+{
+   free(bvh->node);
+   free(bvh->item);
+   bvh->node = NULL;
+   bvh->item = NULL;
+   bvh->nnode = bvh->nitem = bvh->nprop = 0;
+}
+
+//
+//  Clip planes of projection * modelview, in the modelview's object space
+//
+void FrustumFromGL(Frustum* f)
+{
+   float P[16],M[16],C[16];
+   glGetFloatv(GL_PROJECTION_MATRIX,P);
+   glGetFloatv(GL_MODELVIEW_MATRIX,M);
+   //  C = P*M (column major)
+   for (int c=0;c<4;c++)
+      for (int r=0;r<4;r++)
+         C[4*c+r] = P[r]*M[4*c] + P[4+r]*M[4*c+1] + P[8+r]*M[4*c+2] + P[12+r]*M[4*c+3];
+   //  Row 3 plus or minus rows 0, 1 and 2
+   for (int k=0;k<6;k++)
+   {
+      int row = k/2;
+      float s = (k%2) ? -1 : 1;
+      for (int c=0;c<4;c++)
+         f->p[k][c] = C[4*c+3] + s*C[4*c+row];
+   }
+}
+
+//
+//  Mark every item below node k
+//
+static int Take(const Bvh* bvh,const BvhNode* nd,unsigned char* visible)
+{
+   for (int i=nd->first;i<nd->first+nd->count;i++)
+      visible[bvh->item[i]] = 1;
+   return nd->count;
+}
+
+//
+//  Test node k against the planes still in mask
+//
+static int Cull(const Bvh* bvh,int k,const Frustum* f,int mask,unsigned char* visible)
+{
+   const BvhNode* nd = bvh->node+k;
+   for (int i=0;i<6;i++)
+   {
+      if (!(mask & (1<<i))) continue;
+      const float* p = f->p[i];
+      //  Corner farthest along the plane normal, and the nearest one
+      float dmax = p[3],dmin = p[3];
+      for (int c=0;c<3;c++)
+      {
+         float a = p[c]*nd->lo[c];
+         float b = p[c]*nd->hi[c];
+         dmax += a>b ? a : b;
+         dmin += a>b ? b : a;
+      }
+      if (dmax<0) return 0;
+      if (dmin>=0) mask &= ~(1<<i);
+   }
+   if (!mask || !nd->kid) return Take(bvh,nd,visible);
+   return Cull(bvh,nd->kid,f,mask,visible) + Cull(bvh,nd->kid+1,f,mask,visible);
+}
+
+//
+//  Set visible[i] for every prop whose box reaches into the frustum
+//  (visible has nprop entries); returns how many
+//
+int BvhCull(const Bvh* bvh,const Frustum* f,unsigned char* visible)
+{
+   memset(visible,0,bvh->nprop);
+   if (!bvh->nitem) return 0;
+   return Cull(bvh,0,f,0x3F,visible);
+}
@@ -0,0 +1,54 @@
+#ifndef CULL_H
+#define CULL_H
+
+//
+//  View-frustum culling
+//  Kevin McMahon
+//
+//  Props register an axis-aligned box each (6 floats: min x,y,z then
+//  max x,y,z) and BvhBuild() sorts them into a bounding-volume hierarchy,
+//  splitting the longest axis at the median until a node holds BVH_LEAF
+//  props.  Every frame FrustumFromGL() takes the six clip planes out of the
+//  current projection times modelview, so they are in the same space as
+//  the boxes, and BvhCull() walks the tree: a node outside one plane is
+//  dropped with everything below it, a node inside all planes is taken
+//  whole without testing its children.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BVH_LEAF 2   // props per leaf
+
+typedef struct
+{
+   float lo[3],hi[3];
+   int kid;          // first of two children (the second follows), 0 = leaf
+   int first,count;  // run of Bvh.item under this node
+} BvhNode;
+
+typedef struct
+{
+   BvhNode* node;    // node 0 is the root
+   int nnode;
+   int* item;        // prop numbers in tree order
+   int nitem;
+   int nprop;        // props registered (empty boxes are left out of the tree)
+} Bvh;
+
+typedef struct
+{
+   float p[6][4];    // a*x+b*y+c*z+d >= 0 inside: left, right, bottom, top, near, far
+} Frustum;
+
+void BvhBuild(Bvh* bvh,const float* box,int n);
+void BvhFree(Bvh* bvh);
+void FrustumFromGL(Frustum* f);
+int  BvhCull(const Bvh* bvh,const Frustum* f,unsigned char* visible);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,246 @@
+//  Clustered lights
+//  Kevin McMahon
+#include "CSCIx229.h"
+#include "lights.h"
+
+#define NCLUSTER (LIGHT_GX*LIGHT_GY*LIGHT_GZ)
+#define NREF     (LIGHT_INDEX_W*LIGHT_INDEX_H)
+
+static Light light[LIGHT_MAX];
+static int nlight = 0;
+static int uploaded = 0;              // LightsUpload() ran since LightsClear()
+static const int gridN[3] = {LIGHT_GX,LIGHT_GY,LIGHT_GZ};
+static float gridLo[3] = {0,0,0};     // world -> cluster: (p-gridLo)*gridScale
+static float gridScale[3] = {1,1,1};
+static float viewInv[16];             // eye -> world
+static unsigned int tex[LIGHT_NTEX];  // LightData, LightGrid, LightIndex
+
+//  What goes into the textures
+static float data[3][LIGHT_MAX][4];
+static float grid[LIGHT_GY][LIGHT_GX*LIGHT_GZ][4];  // [y][z*GX+x]
+static float refs[NREF];
+static int count[NCLUSTER];
+static int first[NCLUSTER];           // run of each cluster in refs
+static int fill[NCLUSTER];
+static int cells[LIGHT_MAX][6];       // cluster range x0,x1,y0,y1,z0,z1 (empty if x0>x1)
+
+//
+//  World box the clusters cover
+//
+void LightsInit(const float lo[3],const float hi[3])
+{
+   for (int k=0;k<3;k++)
+   {
+      gridLo[k] = lo[k];
+      gridScale[k] = gridN[k]/(hi[k]-lo[k]);
+   }
+}
+
+//
+//  Start this frame's list
+//
+void LightsClear(void)
+{
+   nlight = 0;
+   uploaded = 0;
+}
+
+//
+//  Add a light; -1 if the list is full
+//
+int LightAdd(const Light* l)
+{
+   if (nlight==LIGHT_MAX) return -1;
+   light[nlight] = *l;
+   return nlight++;
+}
+
+int LightCount(void)
+{
+   return nlight;
+}
+
+//
+//  Hash of this frame's list, so a caller can tell when the lights changed
+//
+unsigned int LightsHash(void)
+{
+   unsigned int h = 2166136261u;
+   const unsigned char* b = (const unsigned char*)light;
+   for (size_t k=0;k<nlight*sizeof(Light);k++)
+      h = (h^b[k])*16777619u;
+   return h;
+}
+
+//
+//  Clusters a light can reach: the box around its sphere, or for a spot
+//  narrower than 45 degrees the box around the apex and the disc the cone
+//  cuts at its range
+//
+static void Cells(const Light* l,int c[6])
+{
+   float lo[3],hi[3];
+   float len = sqrtf(l->dir[0]*l->dir[0]+l->dir[1]*l->dir[1]+l->dir[2]*l->dir[2]);
+   if (l->cutoff<45 && len>0)
+   {
+      float r = l->range*tanf(l->cutoff*M_PI/180);
+      for (int k=0;k<3;k++)
+      {
+         float a = l->dir[k]/len;
+         float end = l->pos[k] + l->range*a;
+         float e = r*sqrtf(fmaxf(1-a*a,0));
+         lo[k] = fminf(l->pos[k],end-e);
+         hi[k] = fmaxf(l->pos[k],end+e);
+      }
+   }
+   else
+      for (int k=0;k<3;k++)
+      {
+         lo[k] = l->pos[k] - l->range;
+         hi[k] = l->pos[k] + l->range;
+      }
+   for (int k=0;k<3;k++)
+   {
+      int c0 = (int)floorf((lo[k]-gridLo[k])*gridScale[k]);
+      int c1 = (int)floorf((hi[k]-gridLo[k])*gridScale[k]);
+      if (c1<0 || c0>=gridN[k])
+      {
+         c[0] = 1;
+         c[1] = 0;
+         return;
+      }
+      c[2*k]   = c0<0 ? 0 : c0;
+      c[2*k+1] = c1>=gridN[k] ? gridN[k]-1 : c1;
+   }
+}
+
+//
+//  Float texture the shader reads texel by texel
+//
+static void MakeTexture(int unit,unsigned int t,int internal,int format,int w,int h)
+{
+   glActiveTexture(GL_TEXTURE0+unit);
+   glBindTexture(GL_TEXTURE_2D,t);
+   glTexImage2D(GL_TEXTURE_2D,0,internal,w,h,0,format,GL_FLOAT,NULL);
+   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_NEAREST);
+   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_NEAREST);
+   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);
+   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
+}
+
+//
+//  Bin this frame's lights into the clusters and upload them.  view is
+//  the camera's modelview (column major, rotation and translation only).
+//
+void LightsUpload(const float view[16])
+{
+   if (!tex[0])
+   {
+      glGenTextures(LIGHT_NTEX,tex);
+      MakeTexture(LIGHT_UNIT,  tex[0],GL_RGBA32F,GL_RGBA,LIGHT_MAX,3);
+      MakeTexture(LIGHT_UNIT+1,tex[1],GL_RGBA32F,GL_RGBA,LIGHT_GX*LIGHT_GZ,LIGHT_GY);
+      MakeTexture(LIGHT_UNIT+2,tex[2],GL_R32F,GL_RED,LIGHT_INDEX_W,LIGHT_INDEX_H);
+      glActiveTexture(GL_TEXTURE0);
+   }
+
+   //  Inverse of the camera for the shader's cluster lookup
+   for (int i=0;i<3;i++)
+   {
+      for (int j=0;j<3;j++)
+         viewInv[4*i+j] = view[4*j+i];
+      viewInv[4*i+3] = 0;
+      viewInv[12+i] = -(view[4*i]*view[12] + view[4*i+1]*view[13] + view[4*i+2]*view[14]);
+   }
+   viewInv[15] = 1;
+
+   //  Lights in eye coordinates
+   for (int i=0;i<nlight;i++)
+   {
+      const Light* l = light+i;
+      float len = sqrtf(l->dir[0]*l->dir[0]+l->dir[1]*l->dir[1]+l->dir[2]*l->dir[2]);
+      if (len==0) len = 1;
+      for (int k=0;k<3;k++)
+      {
+         data[0][i][k] = view[k]*l->pos[0] + view[4+k]*l->pos[1] + view[8+k]*l->pos[2] + view[12+k];
+         data[1][i][k] = (view[k]*l->dir[0] + view[4+k]*l->dir[1] + view[8+k]*l->dir[2])/len;
+         data[2][i][k] = l->color[k];
+      }
+      data[0][i][3] = l->range;
+      data[1][i][3] = l->cutoff>=180 ? -2 : cosf(l->cutoff*M_PI/180);
+      data[2][i][3] = l->exponent;
+   }
+
+   //  Count the lights per cluster (the first LIGHT_CLUSTER_MAX are kept)
+   memset(count,0,sizeof(count));
+   for (int i=0;i<nlight;i++)
+   {
+      int* c = cells[i];
+      Cells(light+i,c);
+      for (int x=c[0];x<=c[1];x++)
+         for (int y=c[2];y<=c[3];y++)
+            for (int z=c[4];z<=c[5];z++)
+            {
+               int n = (y*LIGHT_GZ + z)*LIGHT_GX + x;
+               if (count[n]<LIGHT_CLUSTER_MAX) count[n]++;
+            }
+   }
+   //  Each cluster's run in the index list (clusters past the end get none)
+   int total = 0;
+   for (int n=0;n<NCLUSTER;n++)
+   {
+      if (count[n]>NREF-total) count[n] = NREF-total;
+      float* g = grid[n/(LIGHT_GX*LIGHT_GZ)][n%(LIGHT_GX*LIGHT_GZ)];
+      g[0] = total;
+      g[1] = count[n];
+      g[2] = g[3] = 0;
+      first[n] = fill[n] = total;
+      total += count[n];
+   }
+   //  Drop the lights into their runs
+   for (int i=0;i<nlight;i++)
+   {
+      const int* c = cells[i];
+      for (int x=c[0];x<=c[1];x++)
+         for (int y=c[2];y<=c[3];y++)
+            for (int z=c[4];z<=c[5];z++)
+            {
+               int n = (y*LIGHT_GZ + z)*LIGHT_GX + x;
+               if (fill[n]<first[n]+count[n]) refs[fill[n]++] = i;
+            }
+   }
+
+   glActiveTexture(GL_TEXTURE0+LIGHT_UNIT);
+   glBindTexture(GL_TEXTURE_2D,tex[0]);
+   glTexSubImage2D(GL_TEXTURE_2D,0,0,0,LIGHT_MAX,3,GL_RGBA,GL_FLOAT,data);
+   glActiveTexture(GL_TEXTURE0+LIGHT_UNIT+1);
+   glBindTexture(GL_TEXTURE_2D,tex[1]);
+   glTexSubImage2D(GL_TEXTURE_2D,0,0,0,LIGHT_GX*LIGHT_GZ,LIGHT_GY,GL_RGBA,GL_FLOAT,grid);
+   glActiveTexture(GL_TEXTURE0+LIGHT_UNIT+2);
+   glBindTexture(GL_TEXTURE_2D,tex[2]);
+   int rows = (total+LIGHT_INDEX_W-1)/LIGHT_INDEX_W;
+   if (rows) glTexSubImage2D(GL_TEXTURE_2D,0,0,0,LIGHT_INDEX_W,rows,GL_RED,GL_FLOAT,refs);
+   glActiveTexture(GL_TEXTURE0);
+   uploaded = nlight>0;
+   ErrCheck("LightsUpload");
+}
+
+//
+//  Point the current program's ClusterLight() at this frame's lights
+//  (turned off when none were uploaded)
+//
+void LightsBind(int prog)
+{
+   glUniform1i(glGetUniformLocation(prog,"Clustered"),uploaded);
+   if (!uploaded) return;
+   const char* name[LIGHT_NTEX] = {"LightData","LightGrid","LightIndex"};
+   for (int k=0;k<LIGHT_NTEX;k++)
+   {
+      glActiveTexture(GL_TEXTURE0+LIGHT_UNIT+k);
+      glBindTexture(GL_TEXTURE_2D,tex[k]);
+      glUniform1i(glGetUniformLocation(prog,name[k]),LIGHT_UNIT+k);
+   }
+   glActiveTexture(GL_TEXTURE0);
+   glUniformMatrix4fv(glGetUniformLocation(prog,"ViewInverse"),1,GL_FALSE,viewInv);
+   glUniform3fv(glGetUniformLocation(prog,"GridLo"),1,gridLo);
+   glUniform3fv(glGetUniformLocation(prog,"GridScale"),1,gridScale);
+}
@@ -0,0 +1,61 @@
+#ifndef LIGHTS_H
+#define LIGHTS_H
+
+//
+//  Clustered lights
+//  Kevin McMahon
+//
+//  Lights past the eight fixed-function ones.  Every frame the caller
+//  clears the list, adds up to LIGHT_MAX lights in world coordinates and
+//  calls LightsUpload() with the view matrix.  Each light has a range it
+//  does not reach past, so it only touches the cells of a world-space grid
+//  (LIGHT_GX x LIGHT_GY x LIGHT_GZ clusters over the box given to
+//  LightsInit) that overlap its cone or sphere.  The lights are binned into
+//  those clusters with a counting sort, and three float textures go to the
+//  GPU:
+//    LightData   LIGHT_MAX x 3: eye position and range, spot axis and cos
+//                cutoff, color and spot exponent
+//    LightGrid   (GX*GZ) x GY: first index and count for each cluster
+//    LightIndex  LIGHT_INDEX_W x LIGHT_INDEX_H: light numbers, cluster by cluster
+//  ClusterLight() in shaders/common.glsl looks up the fragment's cluster and
+//  only loops over the lights binned there.  The constants below are
+//  repeated in common.glsl.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LIGHT_MAX     256
+#define LIGHT_GX      32     // clusters along x, y and z
+#define LIGHT_GY      4
+#define LIGHT_GZ      16
+#define LIGHT_INDEX_W 256    // light/cluster pairs per frame: W x H
+#define LIGHT_INDEX_H 256
+#define LIGHT_CLUSTER_MAX 64 // lights kept per cluster
+#define LIGHT_UNIT    1      // LightData, LightGrid and LightIndex go on units 1-3
+#define LIGHT_NTEX    3      // cluster textures, on units LIGHT_UNIT on
+
+typedef struct
+{
+   float pos[3];      // world position
+   float dir[3];      // spot axis (any length)
+   float color[3];
+   float range;       // no light past this distance
+   float cutoff;      // spot half angle in degrees, 180 = point light
+   float exponent;    // spot falloff like GL_SPOT_EXPONENT
+} Light;
+
+void LightsInit(const float lo[3],const float hi[3]);
+void LightsClear(void);
+int  LightAdd(const Light* l);
+int  LightCount(void);
+unsigned int LightsHash(void);
+void LightsUpload(const float view[16]);
+void LightsBind(int prog);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
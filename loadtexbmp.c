@@ -1,194 +1,557 @@
 //  CSCIx229 library
 //  Willem A. (Vlakkies) Schreuder
-//  Kevin McMahon - LoadTexBMP32()
+//  Kevin McMahon - LoadTexBMP32(), LoadTexBatch()
 #include "CSCIx229.h"
+#include <sys/stat.h>
+//  EXT_texture_filter_anisotropic (core in 4.6)
+#ifndef GL_TEXTURE_MAX_ANISOTROPY_EXT
+#define GL_TEXTURE_MAX_ANISOTROPY_EXT     0x84FE
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT 0x84FF
+#endif
+//  EXT_texture_compression_s3tc
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT   0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT  0x83F3
+#endif
+#ifdef _WIN32
+#define LOADTEX_SERIAL
+#include <direct.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#endif
 
 //
 //  Load texture from BMP file
 //
+//  Files are memory mapped and the pixels handed to OpenGL straight from
+//  the mapping as GL_BGR/GL_BGRA, so there is no copy and no byte swizzle.
+//  LoadTexBatch() maps, validates and pages in a list of files on worker
+//  threads while the GL thread uploads the ones that are ready.  Each
+//  request can also ask for a mip chain (trilinear filtering) and a
+//  maximum anisotropy.
+//
+//  With LoadTexCache() each texture is cooked once: after the first upload
+//  the complete mip chain is read back from OpenGL (optionally S3TC
+//  compressed by the driver) and written to the cache directory.  Later
+//  runs map the cooked file and upload every level as is, skipping the
+//  BMP, mip generation and compression.  A cooked file is used only if
+//  the source's mtime and size and the request's flags still match.
+//
+
+//  BMP as mapped from disk
+typedef struct
+{
+   const char* file;
+   int alpha;                   // 32-bit BGRA (LoadTexBMP32) instead of 24-bit BGR
+   int mipmap;                  // build mip chain and filter trilinearly
+   float aniso;                 // maximum anisotropy (<=1 is off)
+   long long mtime,size;        // source file stamp (cache key)
+   unsigned char* cache;        // cooked file when the cache is current
+   size_t cacheLen;
+   unsigned char* data;         // whole file
+   size_t len;
+   const unsigned char* pixels; // bottom row first, rows padded to 4 bytes
+   unsigned int dx,dy;
+   int ready;                   // set by the worker once mapped
+} BmpFile;
+
+//  Cooked texture file: header, level table, then the level images
+#define TEXCACHE_MAGIC   0x31435854 // "TXC1"
+#define TEXCACHE_MIPMAP  1
+#define TEXCACHE_ALPHA   2
+#define TEXCACHE_S3TC    4
+#define TEXCACHE_LEVELS  16
+typedef struct
+{
+   unsigned int magic;
+   unsigned int flags;          // request that produced it (TEXCACHE_*)
+   long long mtime,size;        // source file stamp
+   unsigned int format;         // internal format (compressed or GL_RGB/GL_RGBA)
+   unsigned int levels;
+} TexCacheHeader;
+typedef struct
+{
+   unsigned int w,h;
+   unsigned int offset,bytes;   // compressed size, or tightly packed RGB/RGBA
+} TexCacheLevel;
+
+//  Cache settings (LoadTexCache)
+static char* cacheDir = NULL;
+static int cacheS3TC = 0;
 
 //
-//  Reverse n bytes
+//  Little endian fields (BMP byte order on any host)
 //
-static void Reverse(void* x,const int n)
+static unsigned int Get16(const unsigned char* p)
 {
-   char* ch = (char*)x;
-   for (int k=0;k<n/2;k++)
+   return p[0] | (p[1]<<8);
+}
+static unsigned int Get32(const unsigned char* p)
+{
+   return p[0] | (p[1]<<8) | (p[2]<<16) | ((unsigned int)p[3]<<24);
+}
+
+//
+//  Map the whole file read-only (0 if it cannot be opened or is empty)
+//
+static int MapFile(const char* file,unsigned char** data,size_t* len)
+{
+#ifdef _WIN32
+   FILE* f = fopen(file,"rb");
+   if (!f) return 0;
+   fseek(f,0,SEEK_END);
+   long n = ftell(f);
+   rewind(f);
+   *data = n>0 ? (unsigned char*)malloc(n) : NULL;
+   if (!*data || fread(*data,n,1,f)!=1)
    {
-      char tmp = ch[k];
-      ch[k] = ch[n-1-k];
-      ch[n-1-k] = tmp;
+      free(*data);
+      fclose(f);
+      return 0;
    }
+   *len = n;
+   fclose(f);
+#else
+   int fd = open(file,O_RDONLY);
+   if (fd<0) return 0;
+   struct stat st;
+   if (fstat(fd,&st) || st.st_size<=0)
+   {
+      close(fd);
+      return 0;
+   }
+   *len = st.st_size;
+   *data = (unsigned char*)mmap(NULL,*len,PROT_READ,MAP_PRIVATE,fd,0);
+   close(fd);
+   if (*data==MAP_FAILED) return 0;
+#endif
+   return 1;
+}
+
+static void UnmapFile(unsigned char* data,size_t len)
+{
+#ifdef _WIN32
+   free(data);
+#else
+   munmap(data,len);
+#endif
 }
 
 //
-//  Load texture from BMP file
+//  Bring the pages of a mapping in ahead of the upload
 //
-unsigned int LoadTexBMP(const char* file)
+static void Prefault(const unsigned char* data,size_t len)
 {
-   //  Open file
-   FILE* f = fopen(file,"rb");
-   if (!f) Fatal("Cannot open file %s\n",file);
+#ifndef _WIN32
+   volatile unsigned char sum = 0;
+   madvise((void*)data,len,MADV_WILLNEED);
+   for (size_t p=0;p<len;p+=4096)
+      sum += data[p];
+   (void)sum;
+#endif
+}
+
+//
+//  Map, check the header and fault the pixels in (no GL calls)
+//
+static void MapBMP(BmpFile* b)
+{
+   if (!MapFile(b->file,&b->data,&b->len)) Fatal("Cannot open file %s\n",b->file);
+   const unsigned char* h = b->data;
    //  Check image magic
-   unsigned short magic;
-   if (fread(&magic,2,1,f)!=1) Fatal("Cannot read magic from %s\n",file);
-   if (magic!=0x4D42 && magic!=0x424D) Fatal("Image magic not BMP in %s\n",file);
+   if (b->len<54) Fatal("Cannot read header from %s\n",b->file);
+   if (h[0]!='B' || h[1]!='M') Fatal("Image magic not BMP in %s\n",b->file);
    //  Read header
-   unsigned int dx,dy,off,k; // Image dimensions, offset and compression
-   unsigned short nbp,bpp;   // Planes and bits per pixel
-   if (fseek(f,8,SEEK_CUR) || fread(&off,4,1,f)!=1 ||
-       fseek(f,4,SEEK_CUR) || fread(&dx,4,1,f)!=1 || fread(&dy,4,1,f)!=1 ||
-       fread(&nbp,2,1,f)!=1 || fread(&bpp,2,1,f)!=1 || fread(&k,4,1,f)!=1)
-     Fatal("Cannot read header from %s\n",file);
-   //  Reverse bytes on big endian hardware (detected by backwards magic)
-   if (magic==0x424D)
+   unsigned int off = Get32(h+10);
+   unsigned int dx  = Get32(h+18);
+   unsigned int dy  = Get32(h+22);
+   unsigned int nbp = Get16(h+26);
+   unsigned int bpp = Get16(h+28);
+   unsigned int k   = Get32(h+30);
+   //  Check image parameters
+   if (dx<1) Fatal("%s image width %d out of range\n",b->file,dx);
+   if (dy<1) Fatal("%s image height %d out of range\n",b->file,dy);
+   if (nbp!=1) Fatal("%s bit planes is not 1: %d\n",b->file,nbp);
+   if (b->alpha)
    {
-      Reverse(&off,4);
-      Reverse(&dx,4);
-      Reverse(&dy,4);
-      Reverse(&nbp,2);
-      Reverse(&bpp,2);
-      Reverse(&k,4);
+      if (bpp!=32) Fatal("%s bits per pixel is not 32: %d\n",b->file,bpp);
+      if (k!=3)    Fatal("%s compressed files not supported\n",b->file);
+   }
+   else
+   {
+      if (bpp!=24) Fatal("%s bits per pixel is not 24: %d\n",b->file,bpp);
+      if (k!=0)    Fatal("%s compressed files not supported\n",b->file);
    }
-   //  Check image parameters
-   unsigned int max;
-   glGetIntegerv(GL_MAX_TEXTURE_SIZE,(int*)&max);
-   if (dx<1 || dx>max) Fatal("%s image width %d out of range 1-%d\n",file,dx,max);
-   if (dy<1 || dy>max) Fatal("%s image height %d out of range 1-%d\n",file,dy,max);
-   if (nbp!=1)  Fatal("%s bit planes is not 1: %d\n",file,nbp);
-   if (bpp!=24) Fatal("%s bits per pixel is not 24: %d\n",file,bpp);
-   if (k!=0)    Fatal("%s compressed files not supported\n",file);
 #ifndef GL_VERSION_2_0
    //  OpenGL 2.0 lifts the restriction that texture size must be a power of two
    for (k=1;k<dx;k*=2);
-   if (k!=dx) Fatal("%s image width not a power of two: %d\n",file,dx);
+   if (k!=dx) Fatal("%s image width not a power of two: %d\n",b->file,dx);
    for (k=1;k<dy;k*=2);
-   if (k!=dy) Fatal("%s image height not a power of two: %d\n",file,dy);
+   if (k!=dy) Fatal("%s image height not a power of two: %d\n",b->file,dy);
 #endif
+   size_t row = ((size_t)dx*(bpp/8)+3)&~(size_t)3;
+   if (off>b->len || row*dy>b->len-off) Fatal("Error reading data from image %s\n",b->file);
+   b->dx = dx;
+   b->dy = dy;
+   b->pixels = b->data + off;
+   //  Touch every page here so the upload on the GL thread doesn't stall on disk
+   Prefault(b->data,b->len);
+}
 
-   //  Allocate image memory
-   unsigned int size = 3*dx*dy;
-   unsigned char* image = (unsigned char*) malloc(size);
-   if (!image) Fatal("Cannot allocate %d bytes of memory for image %s\n",size,file);
-   //  Seek to and read image
-   if (fseek(f,off,SEEK_SET) || fread(image,size,1,f)!=1) Fatal("Error reading data from image %s\n",file);
-   fclose(f);
-   //  Reverse colors (BGR -> RGB)
-   for (k=0;k<size;k+=3)
+//
+//  Cooked file name: directory plus the source path flattened
+//
+static void CachePath(char* path,int n,const char* file)
+{
+   snprintf(path,n,"%s/%s.tex",cacheDir,file);
+   for (char* p=path+strlen(cacheDir)+1;*p;p++)
+      if (*p=='/' || *p=='\\') *p = '_';
+}
+
+static unsigned int CacheFlags(BmpFile* b)
+{
+   return (b->mipmap ? TEXCACHE_MIPMAP : 0) | (b->alpha ? TEXCACHE_ALPHA : 0) | (cacheS3TC ? TEXCACHE_S3TC : 0);
+}
+
+//
+//  Map the cooked file if it is current for this request (no GL calls)
+//
+static int ReadCache(BmpFile* b)
+{
+   if (!cacheDir) return 0;
+   //  Source stamp
+   struct stat st;
+   if (stat(b->file,&st)) return 0;
+   b->mtime = st.st_mtime;
+   b->size  = st.st_size;
+   //  Map and check the cooked file
+   char path[1024];
+   CachePath(path,sizeof(path),b->file);
+   unsigned char* data;
+   size_t len;
+   if (!MapFile(path,&data,&len)) return 0;
+   const TexCacheHeader* h = (const TexCacheHeader*)data;
+   const TexCacheLevel* l = (const TexCacheLevel*)(h+1);
+   int ok = len>=sizeof(TexCacheHeader) && h->magic==TEXCACHE_MAGIC && h->flags==CacheFlags(b) &&
+            h->mtime==b->mtime && h->size==b->size &&
+            h->levels>=1 && h->levels<=TEXCACHE_LEVELS &&
+            len>=sizeof(TexCacheHeader)+h->levels*sizeof(TexCacheLevel);
+   for (unsigned int k=0;ok && k<h->levels;k++)
+      ok = l[k].offset<=len && l[k].bytes<=len-l[k].offset;
+   if (!ok)
    {
-      unsigned char temp = image[k];
-      image[k]   = image[k+2];
-      image[k+2] = temp;
+      UnmapFile(data,len);
+      return 0;
    }
+   Prefault(data,len);
+   b->cache = data;
+   b->cacheLen = len;
+   return 1;
+}
 
-   //  Sanity check
-   ErrCheck("LoadTexBMP");
-   //  Generate 2D texture
-   unsigned int texture;
-   glGenTextures(1,&texture);
-   glBindTexture(GL_TEXTURE_2D,texture);
-   //  Copy image
-   glTexImage2D(GL_TEXTURE_2D,0,GL_RGB,dx,dy,0,GL_RGB,GL_UNSIGNED_BYTE,image);
-   if (glGetError()) Fatal("Error in glTexImage2D %s %dx%d\n",file,dx,dy);
-   //  Scale linearly when image size doesn't match
-   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
-   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
+//
+//  Read the finished texture back from OpenGL and write the cooked file
+//  (silently skipped when the cache directory is not writable)
+//
+static void WriteCache(BmpFile* b)
+{
+   if (!cacheDir) return;
+   TexCacheHeader h = {TEXCACHE_MAGIC,CacheFlags(b),b->mtime,b->size,0,1};
+   TexCacheLevel l[TEXCACHE_LEVELS];
+   int compressed;
+   glGetTexLevelParameteriv(GL_TEXTURE_2D,0,GL_TEXTURE_COMPRESSED,&compressed);
+   glGetTexLevelParameteriv(GL_TEXTURE_2D,0,GL_TEXTURE_INTERNAL_FORMAT,(int*)&h.format);
+   if (!compressed) h.format = b->alpha ? GL_RGBA : GL_RGB;
+   //  Level table
+   if (b->mipmap)
+      for (unsigned int k=b->dx>b->dy?b->dx:b->dy;k>1 && h.levels<TEXCACHE_LEVELS;k/=2)
+         h.levels++;
+   unsigned int offset = sizeof(h) + h.levels*sizeof(TexCacheLevel);
+   for (unsigned int k=0;k<h.levels;k++)
+   {
+      int w,ht,bytes;
+      glGetTexLevelParameteriv(GL_TEXTURE_2D,k,GL_TEXTURE_WIDTH,&w);
+      glGetTexLevelParameteriv(GL_TEXTURE_2D,k,GL_TEXTURE_HEIGHT,&ht);
+      if (compressed)
+         glGetTexLevelParameteriv(GL_TEXTURE_2D,k,GL_TEXTURE_COMPRESSED_IMAGE_SIZE,&bytes);
+      else
+         bytes = w*ht*(b->alpha ? 4 : 3);
+      l[k].w = w;
+      l[k].h = ht;
+      l[k].offset = offset;
+      l[k].bytes = bytes;
+      offset += bytes;
+   }
+   unsigned char* img = (unsigned char*)malloc(offset);
+   if (!img) return;
+   memcpy(img,&h,sizeof(h));
+   memcpy(img+sizeof(h),l,h.levels*sizeof(TexCacheLevel));
+   glPixelStorei(GL_PACK_ALIGNMENT,1);
+   for (unsigned int k=0;k<h.levels;k++)
+      if (compressed)
+         glGetCompressedTexImage(GL_TEXTURE_2D,k,img+l[k].offset);
+      else
+         glGetTexImage(GL_TEXTURE_2D,k,h.format,GL_UNSIGNED_BYTE,img+l[k].offset);
+   glPixelStorei(GL_PACK_ALIGNMENT,4);
+   //  Write under a temporary name so a partial file is never picked up
+   char path[1024],tmp[1040];
+   CachePath(path,sizeof(path),b->file);
+   snprintf(tmp,sizeof(tmp),"%s.tmp",path);
+   FILE* f = glGetError() ? NULL : fopen(tmp,"wb");
+   if (f)
+   {
+      int ok = fwrite(img,offset,1,f)==1;
+      if (fclose(f) || !ok)
+         remove(tmp);
+      else
+      {
+         remove(path);
+         rename(tmp,path);
+      }
+   }
+   free(img);
+}
 
-   //  Free image memory
-   free(image);
-   //  Return texture name
-   return texture;
+//
+//  Largest anisotropy the implementation supports (1 if none)
+//
+static float MaxAnisotropy(void)
+{
+   static float max = 0;
+   if (max==0)
+   {
+      const char* ext = (const char*)glGetString(GL_EXTENSIONS);
+      max = 1;
+      if (ext && strstr(ext,"GL_EXT_texture_filter_anisotropic"))
+         glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT,&max);
+   }
+   return max;
 }
 
-// Loads 32-bit texture w/ aplha for basketball hoop net 
-unsigned int LoadTexBMP32(const char* file)
+//
+//  Driver can compress to S3TC
+//
+static int HasS3TC(void)
+{
+   const char* ext = (const char*)glGetString(GL_EXTENSIONS);
+   return ext && strstr(ext,"GL_EXT_texture_compression_s3tc");
+}
+
+//
+//  Filtering for a texture that has all its levels
+//
+static void TexFilter(BmpFile* b)
 {
-   // Open the file 
-   FILE *f = fopen(file, "rb");
-   if(!f) Fatal("Cannot open file %s\n", file);
-
-   // Check image magic
-   unsigned short magic;
-   if(fread(&magic,2,1,f)!=1) Fatal("Cannot read magic from%s\n", file);
-   if(magic!=0x4D42 && magic!=0x424D) Fatal("Image magic is not BMP in %s\n", file);
-
-   // Read header (same pattern as LoadTexBMP)
-   unsigned int dx, dy, off, k; // IMage dimensions, offset, compression
-   unsigned short nbp, bpp; // Planes and bits per pixel
-   if(fseek(f,8,SEEK_CUR) || fread(&off,4,1,f)!=1 ||
-      fseek(f,4,SEEK_CUR) || fread(&dx,4,1,f)!=1 || fread(&dy,4,1,f)!=1 ||
-      fread(&nbp,2,1,f)!=1 || fread(&bpp,2,1,f)!=1 || fread(&k,4,1,f)!=1)
-      Fatal("Cannot read header from %s\n", file);
-
-   // Reverse butes on big endian hardware (detected by backwards magic)
-   if(magic==0x424D)
+   //  Scale linearly when image size doesn't match
+   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+   if (b->mipmap)
    {
-      Reverse(&off,4);
-      Reverse(&dx,4);
-      Reverse(&dy,4);
-      Reverse(&nbp,2);
-      Reverse(&bpp,2);
-      Reverse(&k,4);
+      //  Blend between the two nearest levels when minified
+      glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR_MIPMAP_LINEAR);
    }
+   else
+      glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
+   //  Anisotropy is clamped to what the implementation offers
+   if (b->aniso>1 && MaxAnisotropy()>1)
+      glTexParameterf(GL_TEXTURE_2D,GL_TEXTURE_MAX_ANISOTROPY_EXT,fmin(b->aniso,MaxAnisotropy()));
+}
 
-   //  Check image parameters
+//
+//  Create the texture from a mapped BMP (GL thread)
+//
+static unsigned int UploadBMP(BmpFile* b)
+{
    unsigned int max;
    glGetIntegerv(GL_MAX_TEXTURE_SIZE,(int*)&max);
-   if (dx<1 || dx>max) Fatal("%s image width %d out of range 1-%d\n",file,dx,max);
-   if (dy<1 || dy>max) Fatal("%s image height %d out of range 1-%d\n",file,dy,max);
-   if (nbp!=1)  Fatal("%s bit planes is not 1: %d\n",file,nbp);
-   if (bpp!=32) Fatal("%s bits per pixel is not 32: %d\n",file,bpp); // updated for 32-bit
-   if (k!=3)    Fatal("%s compressed files not supported\n",file);
-#ifndef GL_VERSION_2_0
-   //  OpenGL 2.0 lifts the restriction that texture size must be a power of two
-   for (k=1;k<dx;k*=2);
-   if (k!=dx) Fatal("%s image width not a power of two: %d\n",file,dx);
-   for (k=1;k<dy;k*=2);
-   if (k!=dy) Fatal("%s image height not a power of two: %d\n",file,dy);
-#endif
+   if (b->dx>max) Fatal("%s image width %d out of range 1-%d\n",b->file,b->dx,max);
+   if (b->dy>max) Fatal("%s image height %d out of range 1-%d\n",b->file,b->dy,max);
 
-   // Allocate image memory for BGRA
-   unsigned int size = 4*dx*dy; // 4 instead of 3... 32 bit .bmp files
-   unsigned char* image = (unsigned char*) malloc(size);
-   if(!image) Fatal("Cannot allocate %d bytes of memory for image %s\n",size,file);
-
-   // Seek to and read image data
-   if(fseek(f,off,SEEK_SET) || fread(image,size,1,f)!=1) Fatal("Error reading data from image %s\n", file);
-   fclose(f);
-
-   // Reverse colors in place
-   for(k=0;k<size;k+=4)
-   {
-      unsigned char B = image[k+0];
-      unsigned char G = image[k+1];
-      unsigned char R = image[k+2];
-      unsigned char A = image[k+3];
-
-      image[k+0] = R;
-      image[k+1] = G;
-      image[k+2] = B;
-      image[k+3] = A;
-   }
+   //  Sanity check
+   ErrCheck(b->alpha ? "LoadTexBMP32" : "LoadTexBMP");
+   //  Generate 2D texture
+   unsigned int texture;
+   glGenTextures(1,&texture);
+   glBindTexture(GL_TEXTURE_2D,texture);
+   //  Copy image: GL reads the BMP byte order and row padding directly
+   int align;
+   glGetIntegerv(GL_UNPACK_ALIGNMENT,&align);
+   glPixelStorei(GL_UNPACK_ALIGNMENT,4);
+#ifndef GL_VERSION_3_0
+   //  Without glGenerateMipmap the chain is built by glTexImage2D
+   if (b->mipmap) glTexParameteri(GL_TEXTURE_2D,GL_GENERATE_MIPMAP,GL_TRUE);
+#endif
+   //  Let the driver compress when S3TC was asked for and is available
+   int format = b->alpha ? GL_RGBA : GL_RGB;
+   if (cacheS3TC && HasS3TC())
+      format = b->alpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+   glTexImage2D(GL_TEXTURE_2D,0,format,b->dx,b->dy,0,b->alpha?GL_BGRA:GL_BGR,GL_UNSIGNED_BYTE,b->pixels);
+   if (glGetError()) Fatal("Error in glTexImage2D %s %dx%d\n",b->file,b->dx,b->dy);
+   glPixelStorei(GL_UNPACK_ALIGNMENT,align);
+#ifdef GL_VERSION_3_0
+   if (b->mipmap) glGenerateMipmap(GL_TEXTURE_2D);
+#endif
+   TexFilter(b);
+   //  Cook it for the next run
+   if (cacheDir && b->mtime) WriteCache(b);
 
-   // Sanity check
-   ErrCheck("LoadTexBMP32");
+   //  Done with the file
+   UnmapFile(b->data,b->len);
+   //  Return texture name
+   return texture;
+}
 
-   // Generate 2D texture
+//
+//  Create the texture from a cooked file (GL thread)
+//
+static unsigned int UploadCache(BmpFile* b)
+{
+   const TexCacheHeader* h = (const TexCacheHeader*)b->cache;
+   const TexCacheLevel* l = (const TexCacheLevel*)(h+1);
+   ErrCheck("LoadTexCache");
    unsigned int texture;
    glGenTextures(1,&texture);
    glBindTexture(GL_TEXTURE_2D,texture);
+   //  Levels are tightly packed
+   int align;
+   glGetIntegerv(GL_UNPACK_ALIGNMENT,&align);
+   glPixelStorei(GL_UNPACK_ALIGNMENT,1);
+   for (unsigned int k=0;k<h->levels;k++)
+      if (h->format==GL_RGB || h->format==GL_RGBA)
+         glTexImage2D(GL_TEXTURE_2D,k,h->format,l[k].w,l[k].h,0,h->format,GL_UNSIGNED_BYTE,b->cache+l[k].offset);
+      else
+         glCompressedTexImage2D(GL_TEXTURE_2D,k,h->format,l[k].w,l[k].h,0,l[k].bytes,b->cache+l[k].offset);
+   glPixelStorei(GL_UNPACK_ALIGNMENT,align);
+   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAX_LEVEL,h->levels-1);
+   if (glGetError()) Fatal("Error uploading cooked texture for %s\n",b->file);
+   TexFilter(b);
+   UnmapFile(b->cache,b->cacheLen);
+   return texture;
+}
+
+//
+//  Load texture from BMP file
+//
+//
+//  Worker half: map the cooked file or else the BMP (no GL calls)
+//
+static void PrepareTex(BmpFile* b)
+{
+   if (!ReadCache(b)) MapBMP(b);
+}
 
-   // Copy image as RGBA
-   glTexImage2D(GL_TEXTURE_2D,0,GL_RGBA,dx,dy,0,GL_RGBA,GL_UNSIGNED_BYTE,image);
-   if (glGetError()) Fatal("Error in glTexImage2D (32-bit) %s %dx%d\n",file,dx,dy);
+//
+//  GL half: upload whichever was mapped
+//
+static unsigned int CreateTex(BmpFile* b)
+{
+   return b->cache ? UploadCache(b) : UploadBMP(b);
+}
 
-   // Simple linear filtering
-   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
-   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
+unsigned int LoadTexBMP(const char* file)
+{
+   BmpFile b = {file,0};
+   PrepareTex(&b);
+   return CreateTex(&b);
+}
 
-   // Free image memory
-   free(image);
+// Loads 32-bit texture w/ aplha for basketball hoop net
+unsigned int LoadTexBMP32(const char* file)
+{
+   BmpFile b = {file,1};
+   PrepareTex(&b);
+   return CreateTex(&b);
+}
 
-   // Return texture name
-   return texture;
-}
\ No newline at end of file
+//
+//  Cook textures into dir (NULL turns the cache off); s3tc stores them
+//  compressed when the driver supports it
+//
+void LoadTexCache(const char* dir,int s3tc)
+{
+   free(cacheDir);
+   cacheDir = dir ? strdup(dir) : NULL;
+   cacheS3TC = s3tc;
+#ifdef _WIN32
+   if (dir) _mkdir(dir);
+#else
+   if (dir) mkdir(dir,0755);
+#endif
+}
+
+#ifndef LOADTEX_SERIAL
+//  Work shared between LoadTexBatch and its workers
+static BmpFile* batch;
+static int batchN,batchNext;
+static pthread_mutex_t batchLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  batchDone = PTHREAD_COND_INITIALIZER;
+
+//
+//  Worker: map files until the list runs out
+//
+static void* MapWorker(void* arg)
+{
+   while (1)
+   {
+      pthread_mutex_lock(&batchLock);
+      int k = batchNext++;
+      pthread_mutex_unlock(&batchLock);
+      if (k>=batchN) return NULL;
+      PrepareTex(batch+k);
+      pthread_mutex_lock(&batchLock);
+      batch[k].ready = 1;
+      pthread_cond_broadcast(&batchDone);
+      pthread_mutex_unlock(&batchLock);
+   }
+}
+#endif
+
+//
+//  Load a list of textures: files are mapped in parallel and uploaded
+//  here in list order as they become ready
+//
+void LoadTexBatch(TexRequest* list,int n)
+{
+   if (n<1) return;
+   BmpFile* b = (BmpFile*)calloc(n,sizeof(BmpFile));
+   if (!b) Fatal("Cannot allocate texture batch of %d\n",n);
+   for (int k=0;k<n;k++)
+   {
+      b[k].file = list[k].file;
+      b[k].alpha = list[k].alpha;
+      b[k].mipmap = list[k].mipmap;
+      b[k].aniso = list[k].aniso;
+   }
+#ifdef LOADTEX_SERIAL
+   for (int k=0;k<n;k++)
+   {
+      PrepareTex(b+k);
+      *list[k].tex = CreateTex(b+k);
+   }
+#else
+   //  One worker per core, at most one per file
+   long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+   int nthread = ncpu<1 ? 1 : ncpu>8 ? 8 : (int)ncpu;
+   if (nthread>n) nthread = n;
+   pthread_t thread[8];
+   batch = b;
+   batchN = n;
+   batchNext = 0;
+   for (int k=0;k<nthread;k++)
+      if (pthread_create(thread+k,NULL,MapWorker,NULL)) Fatal("Cannot start texture loader thread\n");
+   for (int k=0;k<n;k++)
+   {
+      pthread_mutex_lock(&batchLock);
+      while (!b[k].ready)
+         pthread_cond_wait(&batchDone,&batchLock);
+      pthread_mutex_unlock(&batchLock);
+      *list[k].tex = CreateTex(b+k);
+   }
+   for (int k=0;k<nthread;k++)
+      pthread_join(thread[k],NULL);
+   batch = NULL;
+#endif
+   free(b);
+}
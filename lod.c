@@ -0,0 +1,63 @@
+//  Level of detail
+//  Kevin McMahon
+#include "CSCIx229.h"
+#include "lod.h"
+
+//
+//  Projection of the current modelview's object space onto the viewport
+//
+void LodViewFromGL(LodView* v)
+{
+   float P[16],M[16];
+   int vp[4];
+   glGetFloatv(GL_PROJECTION_MATRIX,P);
+   glGetFloatv(GL_MODELVIEW_MATRIX,M);
+   glGetIntegerv(GL_VIEWPORT,vp);
+   for (int c=0;c<4;c++)
+      v->w[c] = P[3]*M[4*c] + P[7]*M[4*c+1] + P[11]*M[4*c+2] + P[15]*M[4*c+3];
+   //  Modelview scale (uniform) times the projection's vertical scale
+   float s = sqrt(M[0]*M[0]+M[1]*M[1]+M[2]*M[2]);
+   v->pixels = 0.5*vp[3]*fabs(P[5])*s;
+}
+
+//
+//  Diameter in pixels of the sphere at x,y,z with radius r
+//  (anything at or behind the eye counts as huge)
+//
+float LodPixels(const LodView* v,float x,float y,float z,float r)
+{
+   float w = v->w[0]*x + v->w[1]*y + v->w[2]*z + v->w[3];
+   if (w<=1e-6) return 1e30;
+   return 2*r*v->pixels/w;
+}
+
+//
+//  Same for the sphere around a box (min x,y,z then max x,y,z)
+//
+float LodBoxPixels(const LodView* v,const float box[6])
+{
+   float dx = box[3]-box[0];
+   float dy = box[4]-box[1];
+   float dz = box[5]-box[2];
+   return LodPixels(v,0.5*(box[0]+box[3]),0.5*(box[1]+box[4]),0.5*(box[2]+box[5]),0.5*sqrt(dx*dx+dy*dy+dz*dz));
+}
+
+//
+//  Level for a copy now drawn at level that covers the given pixels
+//  Level l is meant for LOD_PIXELS/2^l down to half that
+//
+int LodPick(int level,float pixels)
+{
+   float t = LOD_PIXELS/(1<<level);   // below this the next level is enough
+   while (level<LOD_LEVELS-1 && pixels<t*(1-LOD_HYST))
+   {
+      level++;
+      t *= 0.5;
+   }
+   while (level>0 && pixels>2*t*(1+LOD_HYST))
+   {
+      level--;
+      t *= 2;
+   }
+   return level;
+}
@@ -0,0 +1,41 @@
+#ifndef LOD_H
+#define LOD_H
+
+//
+//  Level of detail
+//  Kevin McMahon
+//
+//  Curved props are built at LOD_LEVELS tessellations, each level with half
+//  the segments of the one before, and each copy is drawn at the level its
+//  size on screen calls for.  LodViewFromGL() takes the current projection,
+//  modelview and viewport; LodPixels() is then the projected diameter of a
+//  bounding sphere given in modelview object space.  LodPick() keeps full
+//  detail down to LOD_PIXELS and drops a level each time the size halves,
+//  but only moves once the size is LOD_HYST past a threshold, so a copy
+//  sitting right at one does not flicker between levels.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LOD_LEVELS 4
+#define LOD_PIXELS 80.0   // diameter (pixels) still drawn at full detail
+#define LOD_HYST   0.2    // fraction past a threshold before switching
+
+typedef struct
+{
+   float w[4];        // clip w of an object-space point (row 3 of projection*modelview)
+   float pixels;      // pixels per object-space unit at w = 1
+} LodView;
+
+void  LodViewFromGL(LodView* v);
+float LodPixels(const LodView* v,float x,float y,float z,float r);
+float LodBoxPixels(const LodView* v,const float box[6]);
+int   LodPick(int level,float pixels);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
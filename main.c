@@ -4,8 +4,21 @@
  *  Key bindings:
  *  l          Toggles lighting on/off
  *  1/2        Shoot baskets at repective hoop
- *  j          Progress video on jumbotron
- *  k          Change ligting mode (test, game, warm-up)
+ *  j          Play/pause the jumbotron clip (or step the still frames)
+ *  c          Toggle retained (GPU buffer) court floor
+ *  b          Toggle cached static scene batches
+ *  i          Toggle instanced courtside chairs
+ *  u          Toggle view-frustum culling of the cached props and the crowd
+ *  o          Toggle level of detail for the curved props
+ *  q          Toggle sorted render queue and GL state cache
+ *  x          Toggle per-pixel floor lighting (fixed-function tiles when off)
+ *  p/P        Toggle profiler overlay / write profile.csv
+ *  r          Toggle the render statistics log line (stderr)
+ *  e          Cycle the crowd (fans, fans doing the wave, crowd photo)
+ *  f          Cycle animation frame cap (60, 30, uncapped)
+ *  t          Toggle scoreboard font (stroke lines, texture atlas)
+ *  g          Cycle players warming up (0, 40, 1000 shooting at once)
+ *  k          Change ligting mode (warm-up, game, full arena rig)
  *  v          Change display mode (Orthogonal, Perspective, First Person)
  *  +/-        zoom-in/zoom-out
  *  arrows     Change view angle (orbital) or look direction (FP)
@@ -18,6 +31,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <string.h>
 #include <math.h>
 #include <stdlib.h>
 #ifdef USEGLEW
@@ -35,6 +49,26 @@
 #ifndef GL_CLAMP_TO_EDGE
 #define GL_CLAMP_TO_EDGE 0x812F
 #endif
+//  Texture loading (LoadTexBMP, LoadTexBatch) and the Fatal/ErrCheck below
+#include "CSCIx229.h"
+//  Immediate-mode calls below go through the capture layer
+#include "capture.h"
+#include "shader.h"
+#include "trig.h"
+#include "profile.h"
+#include "audio.h"
+#include "text.h"
+#include "surface.h"
+#include "video.h"
+#include "sim.h"
+#include "balls.h"
+#include "net.h"
+#include "lights.h"
+#include "cull.h"
+#include "lod.h"
+#include "queue.h"
+#include "stats.h"
+#include "crowd.h"
 
 /*
  * =======================================================================
@@ -68,6 +102,103 @@ float camPitch = 0.0f;  // Camera vertical rotation (up/down)
 // --- Unit conversion ---
 const double UNITS_PER_FOOT = 0.2;  // Court tiles are 0.2 units per foot
 
+// --- Court tessellation ---
+// Lots of tiles so the fixed-function (per-vertex) spot lights show their
+// circles; per-pixel lighting draws the court as one quad instead
+const int COURT_ROWS = 400;
+const int COURT_COLS = 768;
+const double COURT_TILE = 0.025;
+
+// --- Retained court surface (built once at startup) ---
+int courtVbo = 1;               // 1 = draw floor from GPU buffers, 0 = immediate mode
+unsigned int courtVertBuf = 0;  // interleaved x,y,z,u,v floats
+unsigned int courtIndexBuf = 0; // two triangles per tile
+int courtIndexCount = 0;
+int courtBufRows = 0;           // grid the buffers were built for
+int courtBufCols = 0;
+
+// --- Per-pixel floor lighting ---
+int pixelLighting = 1;          // 1 = light the floor per fragment, 0 = fixed-function per vertex
+int pixelShader = 0;            // shaders/pixel.vert + pixel.frag
+
+// --- Static scene (recorded once at startup) ---
+// Props split their drawing into parts so the never-changing pieces can be
+// captured into batches while nets and screens keep drawing every frame
+#define SCENE_STATIC  1
+#define SCENE_DYNAMIC 2
+#define SCENE_ALL     (SCENE_STATIC | SCENE_DYNAMIC)
+int staticScene = 1;            // 1 = replay cached batches, 0 = draw everything immediate
+Mesh* staticArena[LOD_LEVELS];  // walls, crowd, furniture, hoop frames (per level of detail)
+
+// --- Courtside chairs (one mesh, drawn per seat) ---
+int chairInstancing = 1;        // 1 = one instanced draw, 0 = replay the mesh once per seat
+int chairCollect = 0;           // 1 = placeChair() records seats instead of drawing
+Mesh* chairMesh[LOD_LEVELS];    // chair() recorded at the origin
+MeshInstance* chairSeats = NULL;
+int nChairSeats = 0;
+int maxChairSeats = 0;
+unsigned int chairSeatBuf = 0;  // chairSeats on the GPU
+int instanceShader = 0;         // shaders/instance.vert + instance.frag
+
+// --- Frustum culling (cached props and the crowd) ---
+int frustumCull = 1;            // 1 = skip props whose boxes are out of view
+Bvh propTree;                   // staticArena parts, then one box per chair seat
+unsigned char* propVisible = NULL;
+MeshInstance* chairShown = NULL; // seats in view grouped by level, streamed to chairCullBuf
+unsigned int chairCullBuf = 0;
+float* propBox = NULL;          // box of each prop in propTree order
+
+// --- Level of detail ---
+// The curved primitives tessellate at lodSegs() of their full segment
+// count.  The cached props, chairs and balls are recorded at every level
+// and each copy draws at the level its size on screen picks (lod.h).
+int lodOn = 1;                  // 0 = everything at full detail
+int lodLevel = 0;               // level the primitives tessellate at, 0 = full
+unsigned char* propLod = NULL;  // level of each cached prop (and seat)
+unsigned char* propMask = NULL; // per level, the parts drawn from its mesh
+unsigned char* ballLod = NULL;  // level of each ball drawn this frame
+unsigned char heldLod[2];       // level of the ball in each shooter's hands
+unsigned char rackLod[2][8];    // level of each ball on the two racks
+
+// --- Render queue ---
+int renderQueue = 1;            // 1 = sort the court's draws and skip repeated GL state
+const unsigned char* propShown = NULL; // this frame's cullProps() for the queued chairs
+
+// --- Redraw scheduling ---
+// Frames are only requested while something animates; input handlers
+// post their own redraws
+int fpsCap = 60;                // animation frame rate, 0 = as fast as swaps allow (vsync)
+int frameTimerArmed = 0;        // a capped frame tick is queued
+double nextFrameTime = 0;       // when that tick is due (s)
+
+// --- Profiler ---
+int profOverlay = 0;            // per-stage timing table in the corner
+const char* PROFILE_CSV = "profile.csv";
+
+// --- Texture cache ---
+const char* TEXTURE_CACHE = "texcache";  // cooked mip chains (NULL to always read the BMPs)
+int textureS3TC = 0;                     // cook textures S3TC compressed
+
+// --- Scoreboard text (laid out once per score change) ---
+TextMesh scoreText;
+int scoreFont = TEXT_STROKE;    // TEXT_STROKE or TEXT_ATLAS
+
+// --- Jumbotron (screen rendered once per change, shown on every side and the laptops) ---
+Surface jumbotron;
+int jumboDirty = 1;             // video frame changed since the surface was drawn
+const float JUMBO_LINE = 3.0f;  // score stroke width in surface pixels (~1 px on screen)
+
+// --- Jumbotron clip (streamed from one packed file, see vidpack) ---
+const char* VIDEO_CLIP = "textures/videoBoard/clip.vid";
+VideoStream* video = NULL;      // NULL: step through texVideoFrames with 'j'
+int videoPlaying = 0;
+int videoHasFrame = 0;          // stream texture holds a picture
+double videoTime = 0;           // clip time (s), advances only while playing
+double videoClock = 0;          // wall clock at the last update
+
+// --- Sound ---
+int swishSound = -1;            // decoded swish, mixed in-process (-1 = external player)
+
 // --- Mouse Input State ---
 int mouse_button = -1;  // Which mouse button is pressed
 int prev_mouse_x = 0;   // Previous mouse X coordinate
@@ -77,6 +208,7 @@ int prev_mouse_y = 0;   // Previous mouse Y coordinate
 /* Lighting mode:
  * 0 = warm-up / introudctions lighting
  * 1 = arena-style overhead lights on the court
+ * 2 = game lights plus the full arena rig (LIGHT_MAX clustered fixtures)
  */
 int lightingMode = 0;
 int light     = 1;      // Lighting enabled/disabled
@@ -119,19 +251,53 @@ const float MAT_BALL_SPEC[4] = {0.3f, 0.3f, 0.3f, 1.0f};
 // Scoreboard state
 int score[2] = {0,0};
 
-// Net swich animation state - index 0 = hoop at +x, index 1 = hoop at -x
-int netAnimating[2] = {0,0};
-double netAnimStart[2] = {0.0,0.0};
-double netSwayPhase[2] = {0.0,0.0}; // stores offset of net as fcn of t
-
 // Shot animation state - index 0 = hoop at +x, index 1 = hoop at -x
-int shotAnimating[2] = {0,0};
-double shotStartTime[2] = {0.0,0.0};
-double shotParamT[2] = {0.0,0.0};
-int shotSwishTriggered[2] = {0,0}; // check to make sure that swish motion occurs once per shot after 0.8 shot progress
-
-// duration of shot in seconds 
-const double SHOT_DURATION = 1.2;
+int shotAnimating[2] = {0,0};      // player balls in play at each hoop
+int shotsTaken[2] = {0,0};         // seeds each shot's aim error
+
+// seconds a shot stays in play (flight, rim, bounces) before the shooter has it back
+const double SHOT_DURATION = 4.0;
+const double SHOT_FLIGHT = 1.0;    // seconds from release to the rim
+const double SHOT_ERROR_FEET = 0.6; // aim error at the rim, up to (makes a bit over half)
+const double BALL_RADIUS_FEET = 0.40;
+
+// --- Balls in flight (pooled, see balls.h) ---
+#define BALL_POOL   2048
+#define WARMUP_MAX  1000
+BallPool balls;
+MeshInstance* ballInst = NULL;     // per-frame placements (pool plus the two held balls)
+unsigned int ballInstBuf = 0;      // ballInst on the GPU
+MeshInstance* ballSorted = NULL;   // ballInst grouped by level of detail
+Mesh* ballMesh[LOD_LEVELS];        // unit basketball recorded for instancing
+int ballShader = 0;                // shaders/ball.vert + instance.frag
+float ballBack = 0;                // frames are drawn this far before the last tick (s)
+int warmupShooters = 0;            // 'g' cycles 0, 40, WARMUP_MAX players warming up
+double warmupNext[WARMUP_MAX];     // when each of them shoots next (simulation time)
+
+// --- Crowd (fan impostors, see crowd.h) ---
+#define CROWD_SEATS 11064          // CU Events Center capacity
+#define CROWD_ROWS  24
+Crowd crowd;
+int crowdMode = 1;                 // 'e' cycles 1 = fans, 2 = fans doing the wave, 0 = crowd photo
+int crowdShader = 0;               // shaders/crowd.vert + crowd.frag
+int crowdLightShader = 0;          // shaders/crowdlight.vert + instance.frag
+double crowdBand[4];               // bleacherBand() the fans were seated on
+int crowdPhotoPart = -1;           // staticArena parts: the photo planes ...
+int bleacherPart = -1;             // ... and the bare bleachers under the fans
+double cheerTime = -1e9;           // simulation time of the last basket
+
+// --- Nets (cloth, see net.h) - index 0 = hoop at +x, index 1 = hoop at -x ---
+NetCloth nets[2];
+float netBlend = 1;                // frames are drawn this far from the last tick to the next
+
+// --- Simulation (fixed SIM_HZ ticks, see sim.h) ---
+// What a tick produces for drawing; zh and light_zh are blended from the
+// last two ticks before every frame (balls and nets keep their own)
+typedef struct
+{
+   double zh, lightZh;
+} SimState;
+SimState simPrev, simCur;
 
 
 // Scorebaord - video board textures 
@@ -139,14 +305,22 @@ const double SHOT_DURATION = 1.2;
 unsigned int texVideoFrames[NUM_VIDEO_FRAMES];
 int currentVideoFrame = 0;
 
+// Texture currently showing on the jumbotron screen
+unsigned int videoTexture(void)
+{
+   if (video && videoHasFrame) return VideoTexture(video);
+   return texVideoFrames[currentVideoFrame];
+}
+
 //  Cosine and Sine in degrees
 #define Cos(x) (cos((x)*3.14159265/180))
 #define Sin(x) (sin((x)*3.14159265/180))
 void reshape(int width, int height);
-
-// Fcn prototypes for loading textures
-unsigned int LoadTexBMP(const char* file);
-unsigned int LoadTexBMP32(const char* file);
+void drawScoreboardScreen(float lineWidth);
+void scheduleFrames(void);
+double simNow(void);
+int rigProgram(void);
+void rigBind(void);
 
 // Set projection mode - introduced in hw4
 void Project()
@@ -200,12 +374,20 @@ void Fatal(const char* format , ...)
 
 // swish sound
 // Got function from AI... looked for simplest method to play sound effect.
+// Now mixed on the audio thread when a sink is running, so no process is
+// spawned from the render loop; without one (no ALSA device, or not Linux)
+// the system() calls play it as before.
 void playSwish(void)
 {
+   if (swishSound>=0)
+   {
+      AudioPlay(swishSound,1.0);
+      return;
+   }
 #ifdef __APPLE__
     system("afplay basketballSwishSound.wav &");
 #elif __linux__
-    system("aplay basketbalSwishSounds.wav &");
+    system("aplay basketballSwishSound.wav &");
 #else
     // Windows (assuming PowerShell + Windows Media Player or similar)
     system("powershell -c (New-Object Media.SoundPlayer 'basketballSwishSound.wav').PlaySync();");
@@ -215,12 +397,13 @@ void playSwish(void)
 /*
  *  Draw vertex in polar coordinates with normal
  *  (Used for the light source visualization)
+ *  th,ph are steps of the table's segment angle
  */
-void Vertex(double th,double ph)
+void Vertex(const TrigTable* t,int th,int ph)
 {
-   double x = Sin(th)*Cos(ph);
-   double z = Cos(th)*Cos(ph);
-   double y =         Sin(ph);
+   double x = TrigSin(t,th)*TrigCos(t,ph);
+   double z = TrigCos(t,th)*TrigCos(t,ph);
+   double y =               TrigSin(t,ph);
    glNormal3d(x,y,z);
    glVertex3d(x,y,z);
 }
@@ -232,55 +415,64 @@ void ball(double x,double y,double z,double r)
    glTranslated(x,y,z);
    glScaled(r,r,r);
    glColor3f(1,1,1); // White
-   //  Bands of latitude
-   for (int ph=-90;ph<90;ph+=15)
+   //  Bands of latitude, 15 degree steps (30 around)
+   const TrigTable* t = TrigTab(24);
+   for (int ph=-6;ph<6;ph++)
    {
       glBegin(GL_QUAD_STRIP);
-      for (int th=0;th<=360;th+=30)
+      for (int th=0;th<=24;th+=2)
       {
-         Vertex(th,ph);
-         Vertex(th,ph+15);
+         Vertex(t,th,ph);
+         Vertex(t,th,ph+1);
       }
       glEnd();
    }
    glPopMatrix();
 }
 
+// Segments for a ring drawn with full segments at full detail, halved for
+// each level of detail down to no fewer than least
+int lodSegs(int full, int least)
+{
+   int n = full >> lodLevel;
+   return n < least ? least : n;
+}
+
 // Creating "Torus" for rim
 // Updated in hw5 to include normals for lighting
 void drawTorus(double majorRadius, double minorRadius, int majorSegments, int minorSegments)
 {
    // majorRadius is the radius of the whole donut
     // minorRadius is the radius of the tube itself 
+   const TrigTable* major = TrigTab(majorSegments);
+   const TrigTable* minor = TrigTab(minorSegments);
    for (int i = 0; i < majorSegments; i++) {
-        double theta1 = (double)i / majorSegments * 2.0 * M_PI;
-        double theta2 = (double)(i + 1) / majorSegments * 2.0 * M_PI;
+        double cos_theta1 = major->c[i],   sin_theta1 = major->s[i];
+        double cos_theta2 = major->c[i+1], sin_theta2 = major->s[i+1];
 
         glBegin(GL_QUAD_STRIP);
         for (int j = 0; j <= minorSegments; j++) {
-            double phi = (double)j / minorSegments * 2.0 * M_PI;
-
-            double cos_phi = cos(phi);
-            double sin_phi = sin(phi);
+            double cos_phi = minor->c[j];
+            double sin_phi = minor->s[j];
             
             // Calculate normal for surface
-            double nx = cos(theta1) * cos_phi;
-            double ny = sin(theta1) * cos_phi;
+            double nx = cos_theta1 * cos_phi;
+            double ny = sin_theta1 * cos_phi;
             double nz = sin_phi;
 
             // Vertex 1
-            double x1 = (majorRadius + minorRadius * cos_phi) * cos(theta1);
-            double y1 = (majorRadius + minorRadius * cos_phi) * sin(theta1);
+            double x1 = (majorRadius + minorRadius * cos_phi) * cos_theta1;
+            double y1 = (majorRadius + minorRadius * cos_phi) * sin_theta1;
             double z1 = minorRadius * sin_phi;
             glNormal3d(nx, ny, nz); // Set normal for lighting
             glVertex3d(x1, y1, z1);
 
             // Vertex 2 (with normal for the next major segment)
-            nx = cos(theta2) * cos_phi;
-            ny = sin(theta2) * cos_phi;
+            nx = cos_theta2 * cos_phi;
+            ny = sin_theta2 * cos_phi;
             glNormal3d(nx, ny, nz);
-            double x2 = (majorRadius + minorRadius * cos_phi) * cos(theta2);
-            double y2 = (majorRadius + minorRadius * cos_phi) * sin(theta2);
+            double x2 = (majorRadius + minorRadius * cos_phi) * cos_theta2;
+            double y2 = (majorRadius + minorRadius * cos_phi) * sin_theta2;
             double z2 = minorRadius * sin_phi;
             glVertex3d(x2, y2, z2);
         }
@@ -294,11 +486,11 @@ void drawTorus(double majorRadius, double minorRadius, int majorSegments, int mi
  */
 void drawCylinder(double radius, double height, int segments)
 {
+    const TrigTable* t = TrigTab(segments);
     glBegin(GL_QUAD_STRIP);
     for (int i = 0; i <= segments; i++) {
-        double angle = (double)i / segments * 2.0 * M_PI;
-        double x = cos(angle); // Normal x is same as vertex x (normalized)
-        double z = sin(angle); // Normal z is same as vertex z (normalized)
+        double x = t->c[i]; // Normal x is same as vertex x (normalized)
+        double z = t->s[i]; // Normal z is same as vertex z (normalized)
         
         glNormal3d(x, 0, z);
         glVertex3d(radius * x, 0, radius * z); // Bottom vertex
@@ -311,28 +503,33 @@ void drawCylinder(double radius, double height, int segments)
 // Textured sphere using spherical UVs (s = th/360, t = (ph+90)/180)
 void drawSolidSphereTextured(double radius)
 {
-   const int d = 15; // same resolution as before
+   // 15 degree steps at full detail (a multiple of 4 so the poles land on a ring)
+   const int n = lodSegs(24, 8) & ~3;
+   const TrigTable* t = TrigTab(n);
 
-   for (int ph = -90; ph < 90; ph += d)
+   // ph, th count steps of d degrees
+   for (int ph = -n/4; ph < n/4; ph++)
    {
+       double cosPh1 = TrigCos(t, ph),   sinPh1 = TrigSin(t, ph);
+       double cosPh2 = TrigCos(t, ph+1), sinPh2 = TrigSin(t, ph+1);
        glBegin(GL_QUAD_STRIP);
-       for (int th = 0; th <= 360; th += d)
+       for (int th = 0; th <= n; th++)
        {
            // ring 1
-           double nx1 = Sin(th) * Cos(ph);
-           double ny1 = Sin(ph);
-           double nz1 = Cos(th) * Cos(ph);
-           double s1  = (double)th / 360.0;
-           double t1  = (double)(ph + 90) / 180.0;
+           double nx1 = t->s[th] * cosPh1;
+           double ny1 = sinPh1;
+           double nz1 = t->c[th] * cosPh1;
+           double s1  = (double)th / n;
+           double t1  = (double)(2*ph) / n + 0.5;
            glNormal3d(nx1, ny1, nz1);
            glTexCoord2d(s1, t1);
            glVertex3d(radius*nx1, radius*ny1, radius*nz1);
 
            // ring 2
-           double nx2 = Sin(th) * Cos(ph + d);
-           double ny2 = Sin(ph + d);
-           double nz2 = Cos(th) * Cos(ph + d);
-           double t2  = (double)(ph + d + 90) / 180.0;
+           double nx2 = t->s[th] * cosPh2;
+           double ny2 = sinPh2;
+           double nz2 = t->c[th] * cosPh2;
+           double t2  = (double)(2*(ph+1)) / n + 0.5;
            glNormal3d(nx2, ny2, nz2);
            glTexCoord2d(s1, t2);   // same s, next t
            glVertex3d(radius*nx2, radius*ny2, radius*nz2);
@@ -373,7 +570,9 @@ void basketball(double x, double y, double z, double r, double rot)
 
    // offset to avoid z-fighting
    const double rLine = 1.001;
-   const int segs = 128;
+   const int segs = lodSegs(128, 16);
+
+   const TrigTable* seam = TrigTab(segs);
 
    glLineWidth(2.5f);
    glColor3f(0.0f, 0.0f, 0.0f);
@@ -381,23 +580,13 @@ void basketball(double x, double y, double z, double r, double rot)
    // seam around y-axis
    glBegin(GL_LINE_LOOP);
    for (int i = 0; i < segs; ++i)
-   {
-      double th = 360.0 * i / segs;
-      double s = Sin(th);
-      double c = Cos(th);
-      glVertex3d(rLine * c, 0.0, rLine * s);
-   }
+      glVertex3d(rLine * seam->c[i], 0.0, rLine * seam->s[i]);
    glEnd();
 
    // seam around x-axis
    glBegin(GL_LINE_LOOP);
    for (int i = 0; i < segs; ++i)
-   {
-      double th = 360.0 * i / segs;
-      double s = Sin(th);
-      double c = Cos(th);
-      glVertex3d(0.0, rLine * c, rLine * s);
-   }
+      glVertex3d(0.0, rLine * seam->c[i], rLine * seam->s[i]);
    glEnd();
 
    glPopMatrix();
@@ -408,15 +597,15 @@ void basketball(double x, double y, double z, double r, double rot)
 // originally used for floor mounted hoop
 void drawTexturedCylinder(unsigned int tex, double radius, double height, int segments, double repeatU, double repeatV)
 {
+   const TrigTable* ring = TrigTab(segments);
    glBindTexture(GL_TEXTURE_2D, tex);
    glEnable(GL_TEXTURE_2D);
    glBegin(GL_QUAD_STRIP);
    for (int i = 0; i <= segments; ++i)
    {
       double t  = (double)i / segments;
-      double ang = t * 2.0 * M_PI;
-      double x = cos(ang);
-      double z = sin(ang);
+      double x = ring->c[i];
+      double z = ring->s[i];
       double s = t * repeatU; // wrap around
       glNormal3d(x, 0.0, z);
       // bottom
@@ -512,19 +701,14 @@ void drawRodBetween(double x1,double y1,double z1, double x2,double y2,double z2
    drawCylinder(r, len, segs);
 
    // circle end caps
-   double angleStep = 2.0 * M_PI / segs;
+   const TrigTable* ring = TrigTab(segs);
 
    // Bottom cap at y = 0 odwn facing normal
    glBegin(GL_TRIANGLE_FAN);
    glNormal3f(0.0f, -1.0f, 0.0f);
    glVertex3f(0.0f, 0.0f, 0.0f); // center vert
    for (int i = 0; i <= segs; ++i)
-   {
-      double a = i * angleStep;
-      double cx = r * cos(a);
-      double cz = r * sin(a);
-      glVertex3f(cx, 0.0f, cz);
-   }
+      glVertex3f(r * ring->c[i], 0.0f, r * ring->s[i]);
    glEnd();
 
    // Top cap
@@ -532,12 +716,7 @@ void drawRodBetween(double x1,double y1,double z1, double x2,double y2,double z2
    glNormal3f(0.0f, 1.0f, 0.0f);
    glVertex3f(0.0f, (float)len, 0.0f);
    for (int i = 0; i <= segs; ++i)
-   {
-      double a = i * angleStep;
-      double cx = r * cos(a);
-      double cz = r * sin(a);
-      glVertex3f(cx, (float)len, cz);
-   }
+      glVertex3f(r * ring->c[i], (float)len, r * ring->s[i]);
    glEnd();
 
    glPopMatrix();
@@ -561,6 +740,10 @@ void drawRoundedBackSolid(double w, double h, double t, double cornerR, int arcS
    const double yTop = halfH;
    const double yTopInner = yTop - cornerR;
 
+   // Quarter arcs are arcSegs steps of a full circle of 4*arcSegs
+   // 90 deg is step arcSegs, 180 deg is step 2*arcSegs
+   const TrigTable* arc = TrigTab(4 * arcSegs);
+
    // front face of the chair
    glNormal3f(0,0,1);
 
@@ -585,9 +768,9 @@ void drawRoundedBackSolid(double w, double h, double t, double cornerR, int arcS
    glVertex3d(xLeft + cornerR, yTopInner, zFront);  // inside corner
    for (int i = 0; i <= arcSegs; ++i)
    {
-      double a  = M_PI - (i * (M_PI/2.0) / arcSegs);  // 180° → 90°
-      double vx = xLeft + cornerR + cornerR * cos(a);
-      double vy = yTopInner + cornerR + cornerR * sin(a);
+      int a = 2*arcSegs - i;  // 180° → 90°
+      double vx = xLeft + cornerR + cornerR * arc->c[a];
+      double vy = yTopInner + cornerR + cornerR * arc->s[a];
       glVertex3d(vx, vy, zFront);
    }
    glEnd();
@@ -597,9 +780,9 @@ void drawRoundedBackSolid(double w, double h, double t, double cornerR, int arcS
    glVertex3d(xRight - cornerR, yTopInner, zFront);
    for (int i = 0; i <= arcSegs; ++i)
    {
-      double a  = (M_PI/2.0) - (i * (M_PI/2.0) / arcSegs);  // 90° → 0°
-      double vx = xRight - cornerR + cornerR * cos(a);
-      double vy = yTopInner + cornerR + cornerR * sin(a);
+      int a = arcSegs - i;  // 90° → 0°
+      double vx = xRight - cornerR + cornerR * arc->c[a];
+      double vy = yTopInner + cornerR + cornerR * arc->s[a];
       glVertex3d(vx, vy, zFront);
    }
    glEnd();
@@ -659,9 +842,9 @@ void drawRoundedBackSolid(double w, double h, double t, double cornerR, int arcS
    glBegin(GL_QUAD_STRIP);
    for (int i = 0; i <= arcSegs; ++i)
    {
-      double a  = M_PI - (i * (M_PI/2.0) / arcSegs);
-      double nx = cos(a);
-      double ny = sin(a);
+      int a = 2*arcSegs - i;
+      double nx = arc->c[a];
+      double ny = arc->s[a];
       double vx = xArcLeft + cornerR * nx;
       double vy = (topY - cornerR) + cornerR * ny;
       glNormal3f(nx, ny, 0);
@@ -674,9 +857,9 @@ void drawRoundedBackSolid(double w, double h, double t, double cornerR, int arcS
    glBegin(GL_QUAD_STRIP);
    for (int i = 0; i <= arcSegs; ++i)
    {
-      double a  = (M_PI/2.0) - (i * (M_PI/2.0) / arcSegs);
-      double nx = cos(a);
-      double ny = sin(a);
+      int a = arcSegs - i;
+      double nx = arc->c[a];
+      double ny = arc->s[a];
       double vx = xArcRight + cornerR * nx;
       double vy = (topY - cornerR) + cornerR * ny;
       glNormal3f(nx, ny, 0);
@@ -718,7 +901,7 @@ void chair(double x, double y, double z, double dirDeg, double scale)
    const double hingeFromBottom = 0.10; // hinge is a bit above bottom of back panel 
 
    const double legR = 0.03;
-   const int segs = 6;
+   const int segs = lodSegs(6, 3);
 
    int texWasEnabled = glIsEnabled(GL_TEXTURE_2D);
    glColor3f(1.0f,1.0f,1.0f);   // let texture drive the color
@@ -787,7 +970,7 @@ void chair(double x, double y, double z, double dirDeg, double scale)
    glTranslated(0.0, backH*0.5 - hingeFromBottom, 0.0);
 
    glColor3f(0.10f,0.10f,0.13f);
-   drawRoundedBackSolid(backW, backH, backT, backR, 10);
+   drawRoundedBackSolid(backW, backH, backT, backR, lodSegs(10, 2));
    glPopMatrix();
 
    // METAL FRAME / LEGS
@@ -832,6 +1015,89 @@ void chair(double x, double y, double z, double dirDeg, double scale)
    glPopMatrix();
 }
 
+// One seat of the courtside layout
+// While the static scene is being recorded the seat is only remembered
+// (drawChairs() draws them all at once), otherwise the chair is drawn now
+void placeChair(double x, double y, double z, double dirDeg, double scale)
+{
+   if (!chairCollect)
+   {
+      chair(x, y, z, dirDeg, scale);
+      return;
+   }
+   if (nChairSeats == maxChairSeats)
+   {
+      maxChairSeats = maxChairSeats ? 2*maxChairSeats : 64;
+      chairSeats = (MeshInstance*)realloc(chairSeats, maxChairSeats*sizeof(MeshInstance));
+      if (!chairSeats) Fatal("Cannot allocate %d chair seats\n", maxChairSeats);
+   }
+   MeshInstance* seat = chairSeats + nChairSeats++;
+   seat->x = x;
+   seat->y = y;
+   seat->z = z;
+   seat->yaw = dirDeg;
+   seat->scale = scale;
+}
+
+// Copy the n placements with seen[i] set (all when seen is NULL) into out,
+// grouped by level; group l is out[start[l]] up to out[start[l+1]]
+void groupByLevel(const MeshInstance* in, int n, const unsigned char* seen, const unsigned char* level, MeshInstance* out, int start[LOD_LEVELS+1])
+{
+   int fill[LOD_LEVELS];
+   for (int l = 0; l <= LOD_LEVELS; ++l)
+      start[l] = 0;
+   for (int i = 0; i < n; ++i)
+      if (!seen || seen[i]) start[level[i]+1]++;
+   for (int l = 0; l < LOD_LEVELS; ++l)
+   {
+      start[l+1] += start[l];
+      fill[l] = start[l];
+   }
+   for (int i = 0; i < n; ++i)
+      if (!seen || seen[i]) out[fill[level[i]]++] = in[i];
+}
+
+// Stream grouped placements into buf and draw each group with its level's mesh
+void drawLevels(Mesh* const* mesh, int prog, unsigned int buf, const MeshInstance* inst, const int start[LOD_LEVELS+1])
+{
+   glBindBuffer(GL_ARRAY_BUFFER, buf);
+   glBufferData(GL_ARRAY_BUFFER, start[LOD_LEVELS]*sizeof(MeshInstance), inst, GL_STREAM_DRAW);
+   glBindBuffer(GL_ARRAY_BUFFER, 0);
+   for (int l = 0; l < LOD_LEVELS; ++l)
+      drawMeshInstanced(mesh[l], prog, buf, start[l], start[l+1]-start[l], MESH_ALL);
+}
+
+// Every recorded seat: one instanced draw per level of detail, or the chair
+// mesh replayed under each seat's transform when instancing is switched off
+// seen[i] says whether seat i is in view (NULL draws them all), level[i]
+// which chairMesh it uses
+void drawChairs(const unsigned char* seen, const unsigned char* level)
+{
+   if (chairInstancing && instanceShader)
+   {
+      if (!seen && !lodOn)
+      {
+         drawMeshInstanced(chairMesh[0], instanceShader, chairSeatBuf, 0, nChairSeats, MESH_ALL);
+         return;
+      }
+      int start[LOD_LEVELS+1];
+      groupByLevel(chairSeats, nChairSeats, seen, level, chairShown, start);
+      drawLevels(chairMesh, instanceShader, chairCullBuf, chairShown, start);
+      return;
+   }
+   for (int i = 0; i < nChairSeats; ++i)
+   {
+      if (seen && !seen[i]) continue;
+      const MeshInstance* seat = chairSeats + i;
+      glPushMatrix();
+      glTranslated(seat->x, seat->y, seat->z);
+      glRotated(seat->yaw, 0, 1, 0);
+      glScaled(seat->scale, seat->scale, seat->scale);
+      drawMesh(chairMesh[level[i]], MESH_ALL);
+      glPopMatrix();
+   }
+}
+
 // Simple scorer's table centered on the near sideline.
 // Front (court side) is closed, back (bench side) is open so can see under it
 void drawScorersTable(double courtLenHalfX, double courtWidHalfZ, double benchY)
@@ -1211,7 +1477,8 @@ void drawLaptop(double x, double y, double z, double yawDeg, double scale)
    double vyT = screenTopY - marginY;
    double vZ  = screenFrontZ + 0.001; // avoid z-fighting
    glEnable(GL_TEXTURE_2D);
-   glBindTexture(GL_TEXTURE_2D, texVideoFrames[currentVideoFrame]);
+   // Mirror of the jumbotron screen (just the video without render targets)
+   glBindTexture(GL_TEXTURE_2D, jumbotron.tex ? jumbotron.tex : videoTexture());
    glColor3f(1.0f,1.0f,1.0f);
    glBegin(GL_QUADS);
    glNormal3f(0,0,1);
@@ -1240,13 +1507,13 @@ void drawTruncatedConeSide(double baseRadius, double topRadius, double height, i
 {
    if (numSlices < 3) numSlices = 3;
 
-   double angleStepDeg = 360.0 / numSlices;
+   const TrigTable* ring = TrigTab(numSlices);
 
    glBegin(GL_QUAD_STRIP);
-   for (double angleDeg = 0.0; angleDeg <= 360.0 + 0.1; angleDeg += angleStepDeg)
+   for (int i = 0; i <= numSlices; ++i)
    {
-      double cosAngle = Cos(angleDeg);
-      double sinAngle = Sin(angleDeg);
+      double cosAngle = ring->c[i];
+      double sinAngle = ring->s[i];
 
       // Normal for the sloped side
       double normalX = cosAngle * height;
@@ -1276,7 +1543,7 @@ void drawGatoradeCooler(double x, double y, double z, double scale)
    double outerRadius = 0.2;
    double bodyHeight = 0.4;
 
-   int    numSlices = 60;
+   int    numSlices = lodSegs(60, 8);
    double lidHeight = 0.05 * bodyHeight;
    double innerRadius = 0.8  * outerRadius;
 
@@ -1287,7 +1554,7 @@ void drawGatoradeCooler(double x, double y, double z, double scale)
    // Lid a bit wider than body so its like the real thing
    double lidRadius = outerRadius * 1.05;
 
-   double angleStepDeg = 360.0 / numSlices;
+   const TrigTable* ring = TrigTab(numSlices);
 
    // Qucik fix for issues with table
    int wasTexEnabled = glIsEnabled(GL_TEXTURE_2D);
@@ -1315,10 +1582,10 @@ void drawGatoradeCooler(double x, double y, double z, double scale)
 
    // Side of lid... drawing cylinder
    glBegin(GL_QUAD_STRIP);
-   for (double angleDeg = 0.0; angleDeg <= 360.0 + 0.1; angleDeg += angleStepDeg)
+   for (int i = 0; i <= numSlices; ++i)
    {
-      double cosAngle = Cos(angleDeg);
-      double sinAngle = Sin(angleDeg);
+      double cosAngle = ring->c[i];
+      double sinAngle = ring->s[i];
 
       // Cylinder side normal: straight out from center
       glNormal3d(cosAngle, 0.0, sinAngle);
@@ -1340,10 +1607,10 @@ void drawGatoradeCooler(double x, double y, double z, double scale)
    glTexCoord2f(0.5f, 0.5f); // texture center
    glVertex3d(0.0, lidHeight, 0.0);
 
-   for (double angleDeg = 0.0; angleDeg <= 360.0 + 0.1; angleDeg += angleStepDeg)
+   for (int i = 0; i <= numSlices; ++i)
    {
-      double cosAngle = Cos(angleDeg);
-      double sinAngle = Sin(angleDeg);
+      double cosAngle = ring->c[i];
+      double sinAngle = ring->s[i];
 
       // Map circle into 1x1 so logo sits correct direction
       float u = 0.5f - 0.5f * (float)cosAngle;
@@ -1378,7 +1645,7 @@ void drawCoolerTable(double centerX, double floorY, double centerZ)
    
    // Leg parameters
    const double legRadius = 0.015;
-   const int legSlices = 12;
+   const int legSlices = lodSegs(12, 4);
    double xL = -halfLengthX;
    double xR =  halfLengthX;
    double zF = -halfDepthZ;
@@ -1470,10 +1737,20 @@ void drawCoolerTable(double centerX, double floorY, double centerZ)
    glPopMatrix();
 }
 
-void drawBallRack(double centerX, double floorY, double centerZ)
+// Level for one rack ball, kept in *level between frames
+int rackBallLod(unsigned char* level, const LodView* view, double x, double y, double z, double r)
+{
+   *level = lodOn ? LodPick(*level, LodPixels(view, x, y, z, r)) : 0;
+   return *level;
+}
+
+// rack: 0 or 1, which set of rackLod levels its balls keep
+void drawBallRack(int rack, double centerX, double floorY, double centerZ)
 {
    glPushMatrix();
    glTranslated(centerX, floorY, centerZ);
+   LodView view;
+   LodViewFromGL(&view);
    
    // height of top rack 
    const double topY = 0.6;  
@@ -1484,7 +1761,7 @@ void drawBallRack(double centerX, double floorY, double centerZ)
 
    // rod params
    const double legRadius = 0.02;
-   const int legSlices = 10;
+   const int legSlices = lodSegs(10, 4);
 
    // Base corner positions (same idea as cooler table)
    double xL = -halfLengthX;
@@ -1552,10 +1829,13 @@ void drawBallRack(double centerX, double floorY, double centerZ)
       double x = xL + t * usableWidth;
 
       // bottom row
+      lodLevel = rackBallLod(&rackLod[rack][2*i], &view, x, bottomY, zCenter, ballR);
       basketball(x, bottomY,  zCenter, ballR, 15.0 * i); // diff rotations for 5th param
       // top row
+      lodLevel = rackBallLod(&rackLod[rack][2*i+1], &view, x, topYBall, zCenter, ballR);
       basketball(x, topYBall, zCenter, ballR, 37.0 * i); 
    }
+   lodLevel = 0;
 
    glEnable(GL_TEXTURE_2D);
    glPopMatrix();
@@ -1563,10 +1843,12 @@ void drawBallRack(double centerX, double floorY, double centerZ)
 
 // Draw the scorer's table with the chairs behind for reporters
 // Chairs: one centered, then every 4 feet out along the table span
-void drawScorersTableWithChairs(double courtLenHalfX, double courtWidHalfZ, double benchY, double chairScale)
+// parts: SCENE_STATIC = table + chairs, SCENE_DYNAMIC = laptops (they show the video)
+void drawScorersTableWithChairs(double courtLenHalfX, double courtWidHalfZ, double benchY, double chairScale, int parts)
 {
    // Drawing table
-   drawScorersTable(courtLenHalfX, courtWidHalfZ, benchY);
+   if (parts & SCENE_STATIC)
+      drawScorersTable(courtLenHalfX, courtWidHalfZ, benchY);
 
    // Reuse the same layout numbers the table function uses
    const double distFromEndline = 35.0; // clear from endlines
@@ -1608,9 +1890,11 @@ void drawScorersTableWithChairs(double courtLenHalfX, double courtWidHalfZ, doub
       if (x < xL || x > xR) continue;
 
       // Scorer chair same bench height facing the court
-      chair(x, benchY, zChairs, 0.0, chairScale);
+      if (parts & SCENE_STATIC)
+         placeChair(x, benchY, zChairs, 0.0, chairScale);
       // Laptop on the table directly in front of that chair
-      drawLaptop(x, yWoodTop+0.03, zLaptop, 180.0, laptopScale);
+      if (parts & SCENE_DYNAMIC)
+         drawLaptop(x, yWoodTop+0.03, zLaptop, 180.0, laptopScale);
    }
 }
 
@@ -1631,7 +1915,7 @@ void drawBenchRow(int count, double halfCourtX, double halfCourtZ, int baselineS
 
     for (int i = 0; i < count; ++i)
     {
-        chair(x, y, z, yawDeg, chairScale);
+        placeChair(x, y, z, yawDeg, chairScale);
         x -= baselineSign * spacing;  // lay out chairs towards center court 
     }
 }
@@ -1722,59 +2006,15 @@ void drawFarSidelineSecondRowRiser(double courtLenHalfX, double courtWidHalfZ, d
 }
 
 
-// Drawing net for basketball hoop (upside down trucated cone w/ texture)
-void drawBasketballHoopNet(double baseRadius, double topRadius, double height, int numSlices, double swayPhase)
-{
-   double angleStepDeg = 360.0 / numSlices;
-
-   // Maximum lateral offset for the bottom of cone... as a fraction of the radius
-   double maxSway = 0.5*baseRadius;
-   double swayOffset = maxSway * swayPhase;
-
-   glBegin(GL_QUAD_STRIP);
-   for(double angleDeg = 0.0; angleDeg <= 360.1; angleDeg += angleStepDeg)
-   {
-      double cosAngle = Cos(angleDeg);
-      double sinAngle = Sin(angleDeg);
-
-      // Normal for the sloped side
-      double normalX = cosAngle * height;
-      double normalY = (baseRadius - topRadius);
-      double normalZ = sinAngle * height;
-
-      double normalLen = sqrt(normalX*normalX + normalY*normalY + normalZ*normalZ);
-      if(normalLen==0.0) normalLen=1.0;
-      normalX /= normalLen;
-      normalY /= normalLen;
-      normalZ /= normalLen;
-
-      glNormal3d(normalX, normalY, normalZ);
-
-      // Texture coords 
-      // s wraps around 0 to 1, representing 0 to 360 degs
-      float s = (float)(angleDeg / 360.0);
-      float tBottom = 1.0f;
-      float tTop = 0.0f;
-
-      // Bottom ring 
-      glTexCoord2f(s, tBottom); glVertex3d(baseRadius*cosAngle, 0.0, baseRadius*sinAngle);
-      // Bottom ring - gets inverted when applied to hoop in basketballHoop()
-      glTexCoord2f(s, tTop); glVertex3d(topRadius*cosAngle, height, topRadius*sinAngle + swayOffset);
-   }
-   glEnd();
-}
-
 // draws entire hoop... updated with tranparent backboard 
-void basketballHoop(double x, double y, double z, double s, double rot, double poleSetbackWorld)
+// parts: SCENE_STATIC = supports, arm, backboard and rim (the nets are cloth, see drawNet)
+void basketballHoop(double x, double y, double z, double s, double rot, double poleSetbackWorld, int parts)
 {
    glPushMatrix();
    glTranslated(x, y, z);
    glRotated(rot, 0, 1, 0);
    glScaled(s, s, s);
 
-   // DEFINING WHICH HOOP WE ARE DRAWING
-   int hoopIndex = (x>=0.0) ? 0 : 1;
-
    // tunables
    const double unitsPerFoot = UNITS_PER_FOOT;
    const double invScale     = (s != 0.0) ? 1.0 / s : 0.0;
@@ -1828,131 +2068,107 @@ void basketballHoop(double x, double y, double z, double s, double rot, double p
    const double supportSpread = (supportSpreadFeet * unitsPerFoot) * invScale;
    const double supportRadius = (supportRadiusFeet * unitsPerFoot) * invScale;
 
-   // Two anchor points on the ceiling, forming a V
-   double topLeftX = -supportSpread;
-   double topLeftY = supportTopY;
-   double topLeftZ = bottomZ;  // same Z as arm joint; change to tilt forward/back
-
-   double topRightX = supportSpread;
-   double topRightY = supportTopY;
-   double topRightZ = bottomZ;
-
-   // Left bar of the V
-   drawTexturedCylinderBetween(texPole,supportRadius,bottomX, bottomY, bottomZ,topLeftX, topLeftY, topLeftZ,32, 1.0, 2.0);
-   // right bar of the v support
-   drawTexturedCylinderBetween(texPole, supportRadius, bottomX, bottomY, bottomZ, topRightX, topRightY, topRightZ, 32, 1.0, 2.0);
-   // Top bar connecting the hoop supports
-   drawTexturedCylinderBetween(texPole, supportRadius, topLeftX,  topLeftY,  topLeftZ, topRightX, topRightY, topRightZ, 32, 1.0, 2.0);
-   
-   // Middle horizontal support bar
-   const double tMid = 0.5; 
-   double midLeftX = bottomX + tMid * (topLeftX - bottomX);
-   double midLeftY = bottomY + tMid * (topLeftY - bottomY);
-   double midLeftZ = bottomZ + tMid * (topLeftZ - bottomZ);
-   double midRightX = bottomX + tMid * (topRightX - bottomX);
-   double midRightY = bottomY + tMid * (topRightY - bottomY);
-   double midRightZ = bottomZ + tMid * (topRightZ - bottomZ);
-
-   drawTexturedCylinderBetween(texPole, supportRadius, midLeftX,  midLeftY,  midLeftZ, midRightX, midRightY, midRightZ, 32, 1.0, 2.0);
-
-
    const double zBack = bbOffset - bbThick*0.5; // back face of board
-   double armLen = zBack - zStart;
-   glColor3f(1.0f,1.0f,1.0f);
-   glPushMatrix();
-   glTranslated(0.0, yArm, zStart);
-   glRotatef(90, 1, 0, 0); // make horizontal 
-   drawTexturedCylinder(texPole, 0.06, armLen, 20, 1.0, 1.0);
-   glPopMatrix();
-
-   // Backboard
-   glPushMatrix();
-   glTranslated(0, bbBase, bbOffset);
-
-   const double bx1 = -bbWidth/2, bx2 = +bbWidth/2;
-   const double by1 = 0, by2 = bbHeight;
-   const double bz1 = -bbThick/2, bz2 = +bbThick/2;
-
-   glEnable(GL_BLEND);
-   // Texture on the front
-   glEnable(GL_TEXTURE_2D);
-   glBindTexture(GL_TEXTURE_2D, texBackboard);
-   glColor3f(1.0f,1.0f,1.0f);
-   glBegin(GL_QUADS);
-   glNormal3f(0,0,1);
-   glTexCoord2f(0.0f,0.0f); glVertex3d(bx1, by1, bz2);
-   glTexCoord2f(1.0f,0.0f); glVertex3d(bx2, by1, bz2);
-   glTexCoord2f(1.0f,1.0f); glVertex3d(bx2, by2, bz2);
-   glTexCoord2f(0.0f,1.0f); glVertex3d(bx1, by2, bz2);
-   glEnd();
-   glDisable(GL_TEXTURE_2D);
-   glDisable(GL_BLEND);
-
-   // Other faces (solid white, lit)
-   glColor3f(1,1,1);
-   glBegin(GL_QUADS);
-   // No Back so see through but still sides
-   // Top
-   glNormal3f(0,1,0);
-   glVertex3d(bx1, by2, bz2); glVertex3d(bx2, by2, bz2);
-   glVertex3d(bx2, by2, bz1); glVertex3d(bx1, by2, bz1);
-   // Bottom
-   glNormal3f(0,-1,0);
-   glVertex3d(bx1, by1, bz1); glVertex3d(bx2, by1, bz1);
-   glVertex3d(bx2, by1, bz2); glVertex3d(bx1, by1, bz2);
-   // Right
-   glNormal3f(1,0,0);
-   glVertex3d(bx2, by1, bz2); glVertex3d(bx2, by1, bz1);
-   glVertex3d(bx2, by2, bz1); glVertex3d(bx2, by2, bz2);
-   // Left
-   glNormal3f(-1,0,0);
-   glVertex3d(bx1, by1, bz1); glVertex3d(bx1, by1, bz2);
-   glVertex3d(bx1, by2, bz2); glVertex3d(bx1, by2, bz1);
-   glEnd();
-   glPopMatrix(); // end backboard
-
-   // Rim... net to come sooon given work on alpha channel of tex
    const double bbFrontZ = bbOffset + bbThick*0.5; // = 0.15 + 0.025 = 0.175
    const double rimZ = bbFrontZ + rimMajor + rimMinor; // touches board
 
-   glColor3f(1.0f,0.4f,0.0f);
-   glPushMatrix();
-   glTranslated(0, rimY, rimZ);
-   glRotatef(90, 1, 0, 0); // axis → Y (horizontal rim)
-   drawTorus(rimMajor, rimMinor, 64, 24); // smoother & thinner
-
-   glPopMatrix();
-  
-   // Drwing net to the hoop
-   const double netTopRadius = rimMajor * 0.99; // connects to the inside of the rim
-   const double netBottomRadius = netTopRadius * 0.65;
-   const double netHeightFeet = 1.2;
-   const double netHeight = (netHeightFeet*unitsPerFoot) * invScale;
+   if (parts & SCENE_STATIC)
+   {
+      // Two anchor points on the ceiling, forming a V
+      double topLeftX = -supportSpread;
+      double topLeftY = supportTopY;
+      double topLeftZ = bottomZ;  // same Z as arm joint; change to tilt forward/back
+
+      double topRightX = supportSpread;
+      double topRightY = supportTopY;
+      double topRightZ = bottomZ;
+
+      // Left bar of the V (untinted so it doesn't pick up the last color drawn)
+      glColor3f(1.0f,1.0f,1.0f);
+      drawTexturedCylinderBetween(texPole,supportRadius,bottomX, bottomY, bottomZ,topLeftX, topLeftY, topLeftZ,lodSegs(32, 6), 1.0, 2.0);
+      // right bar of the v support
+      drawTexturedCylinderBetween(texPole, supportRadius, bottomX, bottomY, bottomZ, topRightX, topRightY, topRightZ, lodSegs(32, 6), 1.0, 2.0);
+      // Top bar connecting the hoop supports
+      drawTexturedCylinderBetween(texPole, supportRadius, topLeftX,  topLeftY,  topLeftZ, topRightX, topRightY, topRightZ, lodSegs(32, 6), 1.0, 2.0);
    
-   glPushMatrix();
+      // Middle horizontal support bar
+      const double tMid = 0.5; 
+      double midLeftX = bottomX + tMid * (topLeftX - bottomX);
+      double midLeftY = bottomY + tMid * (topLeftY - bottomY);
+      double midLeftZ = bottomZ + tMid * (topLeftZ - bottomZ);
+      double midRightX = bottomX + tMid * (topRightX - bottomX);
+      double midRightY = bottomY + tMid * (topRightY - bottomY);
+      double midRightZ = bottomZ + tMid * (topRightZ - bottomZ);
 
-   // center under the rim
-   glTranslated(0, rimY, rimZ);
-   // Cone extends downward (-y)
-   glScaled(1.0,-1.0,1.0); // height goes downwards
+      drawTexturedCylinderBetween(texPole, supportRadius, midLeftX,  midLeftY,  midLeftZ, midRightX, midRightY, midRightZ, lodSegs(32, 6), 1.0, 2.0);
 
-   // push just below the rim
-   glTranslated(0.0, 0.02, 0.0); 
 
-   // Enabling blenmding since 32-bit bmp transparency works
-   glEnable(GL_BLEND);
-   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-   glEnable(GL_TEXTURE_2D);
-   glBindTexture(GL_TEXTURE_2D, texBasketballNet);
+      double armLen = zBack - zStart;
+      glColor3f(1.0f,1.0f,1.0f);
+      glPushMatrix();
+      glTranslated(0.0, yArm, zStart);
+      glRotatef(90, 1, 0, 0); // make horizontal 
+      drawTexturedCylinder(texPole, 0.06, armLen, lodSegs(20, 6), 1.0, 1.0);
+      glPopMatrix();
 
-   glColor3f(0.8f,0.8f,0.8f);
-   drawBasketballHoopNet(netTopRadius, netBottomRadius, netHeight, 24, netSwayPhase[hoopIndex]);
+      // Backboard
+      glPushMatrix();
+      glTranslated(0, bbBase, bbOffset);
 
-   glDisable(GL_TEXTURE_2D);
-   glDisable(GL_BLEND);
+      const double bx1 = -bbWidth/2, bx2 = +bbWidth/2;
+      const double by1 = 0, by2 = bbHeight;
+      const double bz1 = -bbThick/2, bz2 = +bbThick/2;
 
-   glPopMatrix();
-   
+      glEnable(GL_BLEND);
+      // Texture on the front
+      glEnable(GL_TEXTURE_2D);
+      glBindTexture(GL_TEXTURE_2D, texBackboard);
+      glColor3f(1.0f,1.0f,1.0f);
+      glBegin(GL_QUADS);
+      glNormal3f(0,0,1);
+      glTexCoord2f(0.0f,0.0f); glVertex3d(bx1, by1, bz2);
+      glTexCoord2f(1.0f,0.0f); glVertex3d(bx2, by1, bz2);
+      glTexCoord2f(1.0f,1.0f); glVertex3d(bx2, by2, bz2);
+      glTexCoord2f(0.0f,1.0f); glVertex3d(bx1, by2, bz2);
+      glEnd();
+      glDisable(GL_TEXTURE_2D);
+      glDisable(GL_BLEND);
+
+      // Other faces (solid white, lit)
+      glColor3f(1,1,1);
+      glBegin(GL_QUADS);
+      // No Back so see through but still sides
+      // Top
+      glNormal3f(0,1,0);
+      glVertex3d(bx1, by2, bz2); glVertex3d(bx2, by2, bz2);
+      glVertex3d(bx2, by2, bz1); glVertex3d(bx1, by2, bz1);
+      // Bottom
+      glNormal3f(0,-1,0);
+      glVertex3d(bx1, by1, bz1); glVertex3d(bx2, by1, bz1);
+      glVertex3d(bx2, by1, bz2); glVertex3d(bx1, by1, bz2);
+      // Right
+      glNormal3f(1,0,0);
+      glVertex3d(bx2, by1, bz2); glVertex3d(bx2, by1, bz1);
+      glVertex3d(bx2, by2, bz1); glVertex3d(bx2, by2, bz2);
+      // Left
+      glNormal3f(-1,0,0);
+      glVertex3d(bx1, by1, bz1); glVertex3d(bx1, by1, bz2);
+      glVertex3d(bx1, by2, bz2); glVertex3d(bx1, by2, bz1);
+      glEnd();
+      glPopMatrix(); // end backboard
+
+      // Rim... net to come sooon given work on alpha channel of tex
+      // (its own part of the static capture, so it picks its own detail)
+      capturePart();
+      glColor3f(1.0f,0.4f,0.0f);
+      glPushMatrix();
+      glTranslated(0, rimY, rimZ);
+      glRotatef(90, 1, 0, 0); // axis → Y (horizontal rim)
+      drawTorus(rimMajor, rimMinor, lodSegs(64, 8), lodSegs(24, 6)); // smoother & thinner
+
+      glPopMatrix();
+   }
+  
    // End hoop assembly
    glPopMatrix();
 }
@@ -1962,11 +2178,11 @@ void basketballHoop(double x, double y, double z, double s, double rot, double p
 // helpful for moving spotlights to form circle
 void drawCircleFeet(double cx, double cz, double radiusFeet, int segments, double y, double feetPerX, double feetPerZ)
 {
+   const TrigTable* ring = TrigTab(segments);
    glBegin(GL_LINE_STRIP);
    for (int i = 0; i <= segments; ++i) {
-      double t = (double)i / segments * 2.0 * M_PI;
-      double x = (radiusFeet * feetPerX) * cos(t);
-      double z = (radiusFeet * feetPerZ) * sin(t);
+      double x = (radiusFeet * feetPerX) * ring->c[i];
+      double z = (radiusFeet * feetPerZ) * ring->s[i];
       glVertex3d(cx + x, y, cz + z);
    }
    glEnd();
@@ -1975,11 +2191,13 @@ void drawCircleFeet(double cx, double cz, double radiusFeet, int segments, doubl
 // Semicircle opening toward center court (−x direction), radius in FEET
 void drawSemicircleTowardCenterFeet(double cx, double cz, double radiusFeet, int segments, double y, double feetPerX, double feetPerZ)
 {
+   // half circle in segments steps: full circle of 2*segments, -90 deg is step -segments/2
+   const TrigTable* ring = TrigTab(2 * segments);
    glBegin(GL_LINE_STRIP);
    for (int i = 0; i <= segments; ++i) {
-      double t = (-90.0 + (180.0 * i) / segments) * (M_PI / 180.0); // -90 deg to +90 deg
-      double x = cx - (radiusFeet * feetPerX) * cos(t);
-      double z = cz + (radiusFeet * feetPerZ) * sin(t);
+      int t = i - segments/2; // -90 deg to +90 deg (segments even)
+      double x = cx - (radiusFeet * feetPerX) * TrigCos(ring, t);
+      double z = cz + (radiusFeet * feetPerZ) * TrigSin(ring, t);
       glVertex3d(x, y, z);
    }
    glEnd();
@@ -2001,11 +2219,11 @@ void drawCourtEndFeet(double court_width, double y, double feetPerX, double feet
    glEnd();
 
    /// Free-throw semicircle (6ft radius)... opening towards the baseline. Leave 2ft on sides for larger lane
+   const TrigTable* deg1 = TrigTab(360);
    glBegin(GL_LINE_STRIP);
    for (int deg = -90; deg <= 90; ++deg) {
-      double t = deg * (M_PI / 180.0);
-      double x = ft_line_x - (circleRadiusFeet * feetPerX) * cos(t); // open inward (−x)
-      double z = (circleRadiusFeet * feetPerZ) * sin(t);
+      double x = ft_line_x - (circleRadiusFeet * feetPerX) * TrigCos(deg1, deg); // open inward (−x)
+      double z = (circleRadiusFeet * feetPerZ) * TrigSin(deg1, deg);
       glVertex3d(x, y, z);
    }
    glEnd();
@@ -2076,8 +2294,77 @@ void drawCourtMarkings(double court_width, double court_depth)
    glLineWidth(1.0);
 }
 
+// Bake the court tile grid into a static vertex/index buffer pair.
+// Same tiles and UVs as the immediate-mode loop in drawCheckerboard, but the
+// shared grid corners are stored once (rows+1 x cols+1) and each tile becomes
+// two indexed triangles, so the dense tessellation costs one draw per frame.
+void buildCourtSurface(int rows, int cols, double tileSize, double y, double repeatU, double repeatV)
+{
+   const int vertsX = cols + 1;
+   const int vertsZ = rows + 1;
+
+   float* verts = (float*) malloc(5 * sizeof(float) * vertsX * vertsZ);
+   unsigned int* idx = (unsigned int*) malloc(6 * sizeof(unsigned int) * rows * cols);
+   if (!verts || !idx) Fatal("Cannot allocate court surface buffers\n");
+
+   float* v = verts;
+   for (int i = 0; i < vertsZ; i++)
+   {
+      for (int j = 0; j < vertsX; j++)
+      {
+         *v++ = (float)(j * tileSize);
+         *v++ = (float)y;
+         *v++ = (float)(i * tileSize);
+         *v++ = (float)((double)j / cols * repeatU);
+         *v++ = (float)((double)i / rows * repeatV);
+      }
+   }
+
+   // same corner order as the immediate quads: (j,i) (j+1,i) (j+1,i+1) (j,i+1)
+   unsigned int* e = idx;
+   for (int i = 0; i < rows; i++)
+   {
+      for (int j = 0; j < cols; j++)
+      {
+         unsigned int v00 = i * vertsX + j;
+         unsigned int v10 = v00 + 1;
+         unsigned int v11 = v10 + vertsX;
+         unsigned int v01 = v00 + vertsX;
+         *e++ = v00; *e++ = v10; *e++ = v11;
+         *e++ = v00; *e++ = v11; *e++ = v01;
+      }
+   }
+
+   if (!courtVertBuf) glGenBuffers(1, &courtVertBuf);
+   if (!courtIndexBuf) glGenBuffers(1, &courtIndexBuf);
+
+   glBindBuffer(GL_ARRAY_BUFFER, courtVertBuf);
+   glBufferData(GL_ARRAY_BUFFER, 5 * sizeof(float) * vertsX * vertsZ, verts, GL_STATIC_DRAW);
+   glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, courtIndexBuf);
+   glBufferData(GL_ELEMENT_ARRAY_BUFFER, 6 * sizeof(unsigned int) * rows * cols, idx, GL_STATIC_DRAW);
+   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+   free(verts);
+   free(idx);
+
+   courtIndexCount = 6 * rows * cols;
+   courtBufRows = rows;
+   courtBufCols = cols;
+   ErrCheck("buildCourtSurface");
+}
+
+// The per-pixel floor shader textures only when GL_TEXTURE_2D is on
+void pixelTextured(void)
+{
+   if (pixelLighting && pixelShader)
+      glUniform1i(glGetUniformLocation(pixelShader, "Textured"), glIsEnabled(GL_TEXTURE_2D));
+}
+
 // Draws checkerboard floor with normals for lighting (all pointed in +y)
-// checkerboard w/ small squares required for the spot light effect
+// checkerboard w/ small squares required for the spot light effect when
+// lit per vertex; lit per pixel the top is a single quad
 void drawCheckerboard(int rows, int cols, double tileSize)
 {
    double totalWidth = cols * tileSize;
@@ -2093,6 +2380,7 @@ void drawCheckerboard(int rows, int cols, double tileSize)
    // Draw the Top Surface (the checkerboard- now texture in hw6
    glBindTexture(GL_TEXTURE_2D, texWood);
    glEnable(GL_TEXTURE_2D);
+   pixelTextured();
 
    //Set color to white to show texture colors
    glColor3f(1, 1, 1);
@@ -2101,33 +2389,67 @@ void drawCheckerboard(int rows, int cols, double tileSize)
    const double texRepeatV = 4.0;
 
    // lifted to y = court_height
-   glBegin(GL_QUADS);
    glNormal3f(0, 1, 0);
-   
-   for (int i = 0; i < rows; i++)
+
+   // Retained path: whole grid in one indexed draw
+   const int pixel = pixelLighting && pixelShader;
+   if (!pixel && courtVbo && (courtBufRows != rows || courtBufCols != cols))
+      buildCourtSurface(rows, cols, tileSize, court_height, texRepeatU, texRepeatV);
+
+   if (pixel)
    {
-      for (int j = 0; j < cols; j++)
+      // same texture mapping as the tiles, corners only
+      glBegin(GL_QUADS);
+      glTexCoord2d(0, 0);                   glVertex3d(0, court_height, 0);
+      glTexCoord2d(texRepeatU, 0);          glVertex3d(totalWidth, court_height, 0);
+      glTexCoord2d(texRepeatU, texRepeatV); glVertex3d(totalWidth, court_height, totalDepth);
+      glTexCoord2d(0, texRepeatV);          glVertex3d(0, court_height, totalDepth);
+      glEnd();
+   }
+   else if (courtVbo && courtIndexCount > 0)
+   {
+      glBindBuffer(GL_ARRAY_BUFFER, courtVertBuf);
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, courtIndexBuf);
+      glEnableClientState(GL_VERTEX_ARRAY);
+      glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+      glVertexPointer(3, GL_FLOAT, 5*sizeof(float), (void*)0);
+      glTexCoordPointer(2, GL_FLOAT, 5*sizeof(float), (void*)(3*sizeof(float)));
+
+      glDrawElements(GL_TRIANGLES, courtIndexCount, GL_UNSIGNED_INT, (void*)0);
+
+      glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+      glDisableClientState(GL_VERTEX_ARRAY);
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+   }
+   else
+   {
+      glBegin(GL_QUADS);
+      for (int i = 0; i < rows; i++)
       {
-         double x0 = j * tileSize;
-         double x1 = (j + 1) * tileSize;
-         double z0 = i * tileSize;
-         double z1 = (i + 1) * tileSize;
-
-         // Map each tile into the repeating texture domain
-         double u0 = (double)j / cols * texRepeatU;
-         double u1 = (double)(j + 1)/ cols * texRepeatU;
-         double v0 = (double)i / rows * texRepeatV;
-         double v1 = (double)(i + 1)/ rows * texRepeatV;
-
-         glTexCoord2d(u0, v0); glVertex3d(x0, court_height, z0);
-         glTexCoord2d(u1, v0); glVertex3d(x1, court_height, z0);
-         glTexCoord2d(u1, v1); glVertex3d(x1, court_height, z1);
-         glTexCoord2d(u0, v1); glVertex3d(x0, court_height, z1);
+         for (int j = 0; j < cols; j++)
+         {
+            double x0 = j * tileSize;
+            double x1 = (j + 1) * tileSize;
+            double z0 = i * tileSize;
+            double z1 = (i + 1) * tileSize;
+
+            // Map each tile into the repeating texture domain
+            double u0 = (double)j / cols * texRepeatU;
+            double u1 = (double)(j + 1)/ cols * texRepeatU;
+            double v0 = (double)i / rows * texRepeatV;
+            double v1 = (double)(i + 1)/ rows * texRepeatV;
+
+            glTexCoord2d(u0, v0); glVertex3d(x0, court_height, z0);
+            glTexCoord2d(u1, v0); glVertex3d(x1, court_height, z0);
+            glTexCoord2d(u1, v1); glVertex3d(x1, court_height, z1);
+            glTexCoord2d(u0, v1); glVertex3d(x0, court_height, z1);
+         }
       }
+      glEnd();
    }
-
-   glEnd();
    glDisable(GL_TEXTURE_2D);
+   pixelTextured();
 
    // Draw the Sides and Bottom to give it thickness
    glColor3f(0.60f, 0.41f, 0.22f); // dark brown
@@ -2184,6 +2506,14 @@ void drawBasketballCourt(int rows, int cols, double tileSize)
    const double outerHalfZ = innerHalfZ + walkwayPad;
    const double walkwayY = 0.1;  // align with court surface
 
+   // Floor, apron and painted logos lit per pixel (lines are unlit anyway)
+   if (pixelLighting && pixelShader)
+   {
+      glUseProgram(pixelShader);
+      SetLightUniforms(pixelShader);
+      LightsBind(pixelShader);
+   }
+
    // boundary of court
    double innerLoop[5][2] = {
       {-innerHalfX, -innerHalfZ},
@@ -2210,6 +2540,7 @@ void drawBasketballCourt(int rows, int cols, double tileSize)
    };
 
    glDisable(GL_TEXTURE_2D);
+   pixelTextured();
 
    const int apronSegs = 32;
 
@@ -2262,6 +2593,7 @@ void drawBasketballCourt(int rows, int cols, double tileSize)
 
    glEnable(GL_TEXTURE_2D);
    glBindTexture(GL_TEXTURE_2D, texSidelineLogo); 
+   pixelTextured();
    glColor3f(1,1,1);
    glNormal3f(0,1,0);
 
@@ -2294,6 +2626,7 @@ void drawBasketballCourt(int rows, int cols, double tileSize)
    
    glEnable(GL_TEXTURE_2D);
    glBindTexture(GL_TEXTURE_2D, texColoradoWordmark);
+   pixelTextured();
    glColor3f(1,1,1);
 
    glNormal3f(0,1,0);
@@ -2330,6 +2663,7 @@ void drawBasketballCourt(int rows, int cols, double tileSize)
 
    glDisable(GL_BLEND);
    glDisable(GL_TEXTURE_2D);
+   if (pixelLighting && pixelShader) glUseProgram(0);
 
    glEnable(GL_POLYGON_OFFSET_LINE);
    glPolygonOffset(-1.0, -1.0); // Negative values pull the lines toward the camera
@@ -2338,7 +2672,9 @@ void drawBasketballCourt(int rows, int cols, double tileSize)
    glDisable(GL_LIGHTING);
    glDisable(GL_TEXTURE_2D);
    
+   profBegin(PROF_MARKINGS);
    drawCourtMarkings(cols * tileSize, rows * tileSize);
+   profEnd();
 
    // Reset lighting
    if (light) glEnable(GL_LIGHTING);
@@ -2566,7 +2902,10 @@ void drawLowerBowlWalls(double courtLenHalfX, double courtWidHalfZ, double baseY
    drawWallShellCore(xInnerL, xInnerR, zInnerF, zInnerB, y0, y1, wallThickness, 0.20f, 0.20f, 0.20f);
 }
 
-void drawBleacherFanPlanes(double courtLenHalfX, double courtWidHalfZ, double baseY, double offCourtFeet, double secondRowOffsetFeet)
+// The sloped band the crowd sits on, from the top of the low rail to the
+// top of the tall shell: how far out from the court each edge is and how
+// high (offset low, offset high, y low, y high)
+void bleacherBand(double baseY, double offCourtFeet, double secondRowOffsetFeet, double band[4])
 {
    // These MUST stay in sync w/ wall code... brittle (FIX LATER)
    const double lowWallHeightFeet = 2.5; // from drawLowerBowlWalls
@@ -2576,17 +2915,28 @@ void drawBleacherFanPlanes(double courtLenHalfX, double courtWidHalfZ, double ba
    const double wallOffsetFeet = 20.0; // from drawArenaBoundaryWalls
    const double behindRiserFeet = 2.0; // from drawLowerBowlWalls
 
-   // Vertical span: from top of low rail to top of tall shell
-   const double yLowTop  = baseY + lowWallHeightFeet  * UNITS_PER_FOOT;
-   const double yHighTop = baseY + highWallHeightFeet * UNITS_PER_FOOT;
-
    // Radial position of the low rail (just behind the 2-row riser)
    const double radialFeetLow  = offCourtFeet + secondRowOffsetFeet + behindRiserFeet;
    // Radial position of the tall outer wall
    const double radialFeetHigh = walkwayFeet + wallOffsetFeet;
 
-   const double offsetLow = radialFeetLow  * UNITS_PER_FOOT;
-   const double offsetHigh = radialFeetHigh * UNITS_PER_FOOT;
+   band[0] = radialFeetLow  * UNITS_PER_FOOT;
+   band[1] = radialFeetHigh * UNITS_PER_FOOT;
+   // Vertical span: from top of low rail to top of tall shell
+   band[2] = baseY + lowWallHeightFeet  * UNITS_PER_FOOT;
+   band[3] = baseY + highWallHeightFeet * UNITS_PER_FOOT;
+}
+
+// The crowd photo stretched over the bleacher band, or (fans 0) the bare
+// dark bleachers the fan impostors sit on
+void drawBleacherFanPlanes(double courtLenHalfX, double courtWidHalfZ, double baseY, double offCourtFeet, double secondRowOffsetFeet, int fans)
+{
+   double band[4];
+   bleacherBand(baseY, offCourtFeet, secondRowOffsetFeet, band);
+   const double offsetLow = band[0];
+   const double offsetHigh = band[1];
+   const double yLowTop  = band[2];
+   const double yHighTop = band[3];
    const double deltaOff = offsetHigh - offsetLow; // how far between them
 
    // Inner face of the tall bowl (same as drawArenaBoundaryWalls)
@@ -2604,9 +2954,17 @@ void drawBleacherFanPlanes(double courtLenHalfX, double courtWidHalfZ, double ba
    const int sideCols = 8;
    const int baseCols = 4;
 
-   glEnable(GL_TEXTURE_2D);
-   glBindTexture(GL_TEXTURE_2D, texSportsFans);  
-   glColor3f(1.0f, 1.0f, 1.0f);
+   if (fans)
+   {
+      glEnable(GL_TEXTURE_2D);
+      glBindTexture(GL_TEXTURE_2D, texSportsFans);  
+      glColor3f(1.0f, 1.0f, 1.0f);
+   }
+   else
+   {
+      glDisable(GL_TEXTURE_2D);
+      glColor3f(0.16f, 0.16f, 0.18f);
+   }
 
 #define CROWD_QUAD(nx,ny,nz,  x0,y0,z0,  x1,y1,z1,  x2,y2,z2,  x3,y3,z3) \
    do {                                                                  \
@@ -2695,6 +3053,8 @@ void drawBleacherFanPlanes(double courtLenHalfX, double courtWidHalfZ, double ba
 
 #undef CROWD_QUAD
 
+   glEnable(GL_TEXTURE_2D);
+   glColor3f(1.0f, 1.0f, 1.0f);
 }
 
 // Arena fan shell:
@@ -2704,8 +3064,21 @@ void drawArenaBowlAndCrowd(double courtLenHalfX, double courtWidHalfZ, double ba
    drawLowerBowlWalls(courtLenHalfX, courtWidHalfZ, baseY, offCourtFeet, secondRowOffsetFeet);
    // Big outer arena shell
    drawArenaBoundaryWalls(courtLenHalfX, courtWidHalfZ, baseY);
-   // Crowd / bleacher planes between them
-   drawBleacherFanPlanes(courtLenHalfX, courtWidHalfZ, baseY, offCourtFeet, secondRowOffsetFeet);
+   // Crowd / bleacher planes between them: the crowd photo, or bare
+   // bleachers under the fan impostors.  The static capture records both,
+   // each as a part of its own (queueProps() shows the one in use), and
+   // keeps the band for the impostors' rows.
+   int part = capturePart();
+   if (part < 0)
+   {
+      drawBleacherFanPlanes(courtLenHalfX, courtWidHalfZ, baseY, offCourtFeet, secondRowOffsetFeet, !crowdMode);
+      return;
+   }
+   crowdPhotoPart = part;
+   drawBleacherFanPlanes(courtLenHalfX, courtWidHalfZ, baseY, offCourtFeet, secondRowOffsetFeet, 1);
+   bleacherPart = capturePart();
+   drawBleacherFanPlanes(courtLenHalfX, courtWidHalfZ, baseY, offCourtFeet, secondRowOffsetFeet, 0);
+   bleacherBand(baseY, offCourtFeet, secondRowOffsetFeet, crowdBand);
 }
 
 // SCORE BOARD FUNCTIONS
@@ -2721,10 +3094,11 @@ void drawScoreboardFace()
    double hh = height/2;
    double hd = depth/2;
 
-   // Enabling lighting for the socreboard
-   glEnable(GL_LIGHTING);
-   glEnable(GL_TEXTURE_2D);
-   glColor3f(0.15f, 0.15f, 0.15f);
+   // The casing is plain black: unlit and untextured, so it does not pick
+   // up whatever texture or material was set last
+   glDisable(GL_LIGHTING);
+   glDisable(GL_TEXTURE_2D);
+   glColor3f(0.0f, 0.0f, 0.0f);
 
    // Front main face... simple quads
    glBegin(GL_QUADS);
@@ -2736,6 +3110,25 @@ void drawScoreboardFace()
    glVertex3d(-hw, hh, hd);
    glEnd();
 
+   // Screen contents (unlit as well): cached render target when available
+   if(jumbotron.tex)
+      SurfaceDraw(&jumbotron, hd+0.01);
+   else
+      drawScoreboardScreen(1.0f);
+}
+
+// Video and score on the scoreboard face (unlit), in face coordinates
+void drawScoreboardScreen(float lineWidth)
+{
+   // Dimensions of the scoreboard... MUST MATCH drawScoreboardFace()
+   const double width = 6.0;
+   const double height = 3.0;
+   const double depth = 0.0;
+   double hh = height/2;
+   double hd = depth/2;
+
+   glEnable(GL_TEXTURE_2D);
+
    // Draw the screen as a textured quad (front pane)
    const double screenMargin = 0.25;
    const double scoreHeight = 0.8;
@@ -2758,9 +3151,9 @@ void drawScoreboardFace()
    double sy1 = videoTop;
 
    // VIDEO SCREEN SECTION
-   if(texVideoFrames[currentVideoFrame]) 
+   if(videoTexture()) 
    {
-      glBindTexture(GL_TEXTURE_2D, texVideoFrames[currentVideoFrame]);
+      glBindTexture(GL_TEXTURE_2D, videoTexture());
 
       // no lighitng on screen so the "video" looks fine
       // white color to not bleed into video 
@@ -2778,26 +3171,17 @@ void drawScoreboardFace()
       glEnable(GL_LIGHTING);
    }
 
-   // Score section of the video board
-   // String that stores the score 
-   glLineWidth(1.0f);
-   char scoreStr[32];
-   snprintf(scoreStr, sizeof(scoreStr), "Away %d - %d Home", score[0], score[1]);
-
-   // Measure the width of the score so that centered on scoreboard
-   float textWidth = 0.0f;
-   for(char *p = scoreStr; *p; ++p)
-      textWidth += glutStrokeWidth(GLUT_STROKE_ROMAN, *p); // GLUT_STROKE_ROMAN draws the characters as line segments... by-passing glutBitMap
-   
-   if(textWidth > 0) // score to display
+   // Score section of the video board (text laid out by drawCompleteScoreboard)
+   if(scoreText.width > 0) // score to display
    {
       // use middle 60% of the screen
       double targetWidth = sw * 0.8;
-      double textScale = targetWidth / textWidth;
+      double textScale = targetWidth / scoreText.width;
 
       glDisable(GL_LIGHTING);
       glDisable(GL_TEXTURE_2D);
       glColor3f(1.0f, 1.0f, 1.0f);
+      glLineWidth(lineWidth);
 
       glPushMatrix();
 
@@ -2806,12 +3190,10 @@ void drawScoreboardFace()
       glScaled(textScale, textScale, textScale); // font units to universal units
 
       // Centering width wise... close as possible since measured from first character
-      glTranslated(-textWidth*0.5, -0.0, 0.0);
+      glTranslated(-scoreText.width*0.5, -0.0, 0.0);
 
-      for(char *p = scoreStr; *p; ++p)
-      {
-         glutStrokeCharacter(GLUT_STROKE_ROMAN, *p);
-      }
+      // GLUT_STROKE_ROMAN glyphs as line segments, cached in a buffer
+      TextDraw(&scoreText);
 
       glPopMatrix();
 
@@ -2820,6 +3202,22 @@ void drawScoreboardFace()
    }
 }
 
+// Lay out the score and redraw the jumbotron surface, only when the score,
+// font or video frame changed since the last time
+void updateJumbotron(void)
+{
+   // String that stores the score... only re-tessellated when it changes
+   char scoreStr[32];
+   snprintf(scoreStr, sizeof(scoreStr), "Away %d - %d Home", score[0], score[1]);
+   int changed = TextSet(&scoreText, scoreFont, scoreStr);
+
+   if(!jumbotron.tex || (!changed && !jumboDirty)) return;
+   jumboDirty = 0;
+   SurfaceBegin(&jumbotron);
+   drawScoreboardScreen(JUMBO_LINE);
+   SurfaceEnd(&jumbotron);
+}
+
 // Draw complete scoreboard cube
 void drawCompleteScoreboard(double x, double y, double z) 
 {
@@ -2898,6 +3296,9 @@ void drawCenterLogo()
    double radius = 1.3;
    double logoHeight = 0.11;
 
+   // Painted on like the lines, so unlit
+   glDisable(GL_LIGHTING);
+   glColor3f(1, 1, 1);
    glEnable(GL_BLEND);
    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
@@ -2911,129 +3312,37 @@ void drawCenterLogo()
    glEnd();
 
    glDisable(GL_BLEND);
+   if (light) glEnable(GL_LIGHTING);
 }
 
 
-// MASTER BASKETBALL COURT FUNCTION: Draws the entire basketball court scene.
-// Standard version drawing full court with lines
-void drawCompleteBasketballCourt(double x, double y, double z, double scale)
+// Everything around the court: benches, scorer's table, far side seating,
+// riser, arena bowl and the coolers behind the benches
+void drawCourtside(double courtLenHalfX, double courtWidHalfZ, int parts)
 {
-   glPushMatrix();
-   glTranslated(x, y, z);
-   glScalef(scale, scale, scale);
-
-   // Lots of tiles for spot lights to flow 
-   const int rows = 400;
-   const int cols = 768;
-   const double tileSize = 0.025;
-   const double court_width = cols * tileSize;
+   // benches, seating, scorer's table
+   const double benchY = 0.10; // walkway height
+   const double offCourtFeet = 5.0; // 5 ft off the sideline
+   const double chairSpacingFeet = 2.2; // just over 2ft btwn center of chairs
+   const double chairScale = 0.30;
 
-   drawBasketballCourt(rows, cols, tileSize);
+   // Every prop below starts its own part of the static capture so it is
+   // culled on its own box (capturePart() does nothing otherwise)
 
-   const double courtLenHalfX = (cols * tileSize) * 0.5;  // baseline at ±X
-   const double courtWidHalfZ = (rows * tileSize) * 0.5;  // sideline at ±Z
+   // DScorer's table between benches 
+   profBegin(PROF_TABLE);
+   capturePart();
+   drawScorersTableWithChairs(courtLenHalfX, courtWidHalfZ, benchY, chairScale, parts);
+   profEnd();
 
-   // hoops
-   const double hoop_x_pos = court_width * 0.5;
-   const double hoop_scale = 0.6; 
-   const double hoopPoleSetback = 3.0 * UNITS_PER_FOOT;
-   basketballHoop( hoop_x_pos, 0, 0, hoop_scale, -90, hoopPoleSetback);
-   basketballHoop(-hoop_x_pos, 0, 0, hoop_scale,  90, hoopPoleSetback);
-
-   // reconstructing rim positioning scheme using same real-world values from basketballHoop()
-   const double rimHeightFeet = 10.0;
-   const double boardThicknessFeet = 0.167;
-   const double rimRadiusFeet = 0.75;
-   const double rimTubeFeet = 0.25;
-   const double poleRadiusFeet = 0.25;
-   const double bracketLengthFeet = 2.0;
-
-   const double rimY_world = rimHeightFeet*UNITS_PER_FOOT;
-
-   const double bbThick_world = boardThicknessFeet*UNITS_PER_FOOT;
-   const double bbOffset_world = (poleRadiusFeet+bracketLengthFeet)*UNITS_PER_FOOT + .5*(boardThicknessFeet*UNITS_PER_FOOT);
-   const double bbFrontZ_world = bbOffset_world + 0.5 *bbThick_world;
-   const double rimMajor_world = rimRadiusFeet*UNITS_PER_FOOT;
-   const double rimMinor_world = rimTubeFeet*UNITS_PER_FOOT;
-   const double rimZ_world = bbFrontZ_world + rimMajor_world + rimMinor_world;
-
-   // Center of rim for each hoop
-   // Define as own vars to not get confused
-   const double rimX_plus = hoop_x_pos - rimZ_world;
-   const double rimX_minus = -hoop_x_pos + rimZ_world;
-   const double rimY = rimY_world;
-   const double rimZ = 0.0;
-
-   // Starting position of the shot
-   const double shotDistanceFeet = 22.0;
-   const double shotOffsetX = shotDistanceFeet * UNITS_PER_FOOT;
-   
-   const double start0_x = rimX_plus - shotOffsetX;
-   const double start0_y = 5.0 * UNITS_PER_FOOT;
-   const double start0_z = 0.0;
-
-   const double start1_x = rimX_minus + shotOffsetX;
-   const double start1_y = start0_y;
-   const double start1_z = 0.0;
-
-   // Locations for apex of the shooting arc for both sides of the court
-   const double peak0_x = 0.5 * (start0_x + rimX_plus);
-   const double peak1_x = 0.5* (start1_x + rimX_minus);
-   const double peak_y = rimY + 12.0 * UNITS_PER_FOOT; // 5ft above the rim is the apex
-   const double peak_z  = 0.0;
-
-   // size of basketball
-   const double ballRadiusFeet = 0.40;
-   const double ballRadius = ballRadiusFeet *UNITS_PER_FOOT;
-
-   //Net depth for ending position so that ball goes through the net
-   const double netHeightFeet = 1.2;
-   const double netHeightWorld = netHeightFeet*UNITS_PER_FOOT;
-
-   const double end0_x = rimX_plus+0.5;
-   const double end0_y = rimY - 1.5*netHeightWorld;
-   const double end0_z = rimZ;
-
-   const double end1_x = rimX_minus-0.5;
-   const double end1_y = rimY - 1.5*netHeightWorld;
-   const double end1_z = rimZ;
-
-
-   // Lambda-like macro for quadratic Bezier interpolation ... bezier function recieved from ChatGPT
-   // Bezier: B(t) = (1-t)^2 * p) + 2(1-t)t * P1 + t^2 *P2
-   #define BEZIER(p0, p1, p2, t) \
-      (((1.0-(t))*(1.0-(t))*(p0))+(2.0*(1.0-(t))*(t)*(p1)) + ((t)*(t)*(p2)))
-
-   // ball path for hoop +x
-   double t0 = shotParamT[0];
-   double bx0 = BEZIER(start0_x, peak0_x, end0_x, t0);
-   double by0 = BEZIER(start0_y, peak_y, end0_y, t0);
-   double bz0 = BEZIER(start0_z, peak_z, end0_z, t0);
-   basketball(bx0, by0, bz0, ballRadius, 0.0);
-
-   // ball path for hoop -x
-   double t1 = shotParamT[1];
-   double bx1 = BEZIER(start1_x, peak1_x, end1_x, t1);
-   double by1 = BEZIER(start1_y, peak_y, end1_y, t1);
-   double bz1 = BEZIER(start1_z, peak_z, end1_z, t1);
-   basketball(bx1, by1, bz1, ballRadius, 0.0);
-
-   #undef BEZIER
-
-   // AROUND THE COURT ACCESSORIES
-   // benches, seating, scorer's table
-   const double benchY = 0.10; // walkway height
-   const double offCourtFeet = 5.0; // 5 ft off the sideline
-   const double chairSpacingFeet = 2.2; // just over 2ft btwn center of chairs
-   const double chairScale = 0.30;
+   // Rest of the courtside never changes
+   if (!(parts & SCENE_STATIC)) return;
 
+   profBegin(PROF_CHAIRS);
    // Near sideline, -Z, two 12-chair team benches facing +Z
    drawBenchRow(12, courtLenHalfX, courtWidHalfZ, +1, -1, benchY, offCourtFeet, chairSpacingFeet, chairScale, 0.0);
    drawBenchRow(12, courtLenHalfX, courtWidHalfZ, -1, -1, benchY, offCourtFeet, chairSpacingFeet, chairScale, 0.0);
 
-   // DScorer's table between benches 
-   drawScorersTableWithChairs(courtLenHalfX, courtWidHalfZ, benchY, chairScale);
-
    // Far sideline, +Z, chairs 
    const int sidelineChairCount = 21; // chairs from each baseline toward midcourt
    const double yawFacingFar = 180.0; // face toward −Z, direction of court
@@ -3049,10 +3358,15 @@ void drawCompleteBasketballCourt(double x, double y, double z, double scale)
    drawBenchRow(sidelineChairCount, courtLenHalfX, courtWidHalfZ, +1, sidelineFarPosZ, benchY+0.1, offCourtFeet + secondRowOffsetFeet, chairSpacingFeet, chairScale, yawFacingFar);
    // Left baseline (−X) toward center
    drawBenchRow(sidelineChairCount, courtLenHalfX, courtWidHalfZ, -1, sidelineFarPosZ, benchY+0.1, offCourtFeet + secondRowOffsetFeet, chairSpacingFeet, chairScale, yawFacingFar);
+   profEnd();
    // Riser for 2nd row of chairs 
+   profBegin(PROF_BOWL);
+   capturePart();
    drawFarSidelineSecondRowRiser(courtLenHalfX, courtWidHalfZ, benchY, offCourtFeet, secondRowOffsetFeet, sidelineFarPosZ);   
    /// Arena bowl walls + fake crowd planes
+   capturePart();
    drawArenaBowlAndCrowd(courtLenHalfX, courtWidHalfZ, benchY, offCourtFeet, secondRowOffsetFeet);
+   profEnd();
 
    // Drawing coolers on sidelines behind benches 
    double coolerInFromBaselineFeet = 20.0;
@@ -3077,25 +3391,514 @@ void drawCompleteBasketballCourt(double x, double y, double z, double scale)
    double tableFloorY = benchY; // legs rest on the bench walkway
    double tableZ = coolerZ;  // same Z as coolers
 
+   profBegin(PROF_COOLERS);
    // Draw tables first so coolers appear to sit on them
+   capturePart();
    drawCoolerTable(rightTableX, tableFloorY, tableZ);
+   capturePart();
    drawCoolerTable(leftTableX,  tableFloorY, tableZ);
 
    // Coolers themselves 
+   capturePart();
    drawGatoradeCooler(rightCoolerX1, coolerHeight, coolerZ, 0.5);
+   capturePart();
    drawGatoradeCooler(rightCoolerX2, coolerHeight, coolerZ, 0.5);
 
+   capturePart();
    drawGatoradeCooler(leftCoolerX1,  coolerHeight, coolerZ, 0.5);
+   capturePart();
    drawGatoradeCooler(leftCoolerX2,  coolerHeight, coolerZ, 0.5);
+   profEnd();
+}
+
+// Both ceiling-hung hoops at the baselines
+void drawHoops(double courtLenHalfX, int parts)
+{
+   const double hoop_scale = 0.6; 
+   const double hoopPoleSetback = 3.0 * UNITS_PER_FOOT;
+   // Each hoop is its own part of the static capture
+   capturePart();
+   basketballHoop( courtLenHalfX, 0, 0, hoop_scale, -90, hoopPoleSetback, parts);
+   capturePart();
+   basketballHoop(-courtLenHalfX, 0, 0, hoop_scale,  90, hoopPoleSetback, parts);
+}
+
+// Rim of hoop i (0 = +x, 1 = -x) in court coordinates: center, radius and
+// tube, from the same real-world values basketballHoop() draws with
+void rimCenter(int i, double rim[3], double* major, double* tube)
+{
+   const double hoop_x_pos = COURT_COLS * COURT_TILE * 0.5;
+   const double rimHeightFeet = 10.0;
+   const double boardThicknessFeet = 0.167;
+   const double rimRadiusFeet = 0.75;
+   const double rimTubeFeet = 0.0625;
+   const double poleRadiusFeet = 0.25;
+   const double bracketLengthFeet = 0.75;
+
+   const double bbThick_world = boardThicknessFeet*UNITS_PER_FOOT;
+   const double bbOffset_world = (poleRadiusFeet+bracketLengthFeet)*UNITS_PER_FOOT + .5*(boardThicknessFeet*UNITS_PER_FOOT);
+   const double bbFrontZ_world = bbOffset_world + 0.5 *bbThick_world;
+   const double rimMajor_world = rimRadiusFeet*UNITS_PER_FOOT;
+   const double rimMinor_world = rimTubeFeet*UNITS_PER_FOOT;
+   const double rimZ_world = bbFrontZ_world + rimMajor_world + rimMinor_world;
+
+   rim[0] = i == 0 ? hoop_x_pos - rimZ_world : -hoop_x_pos + rimZ_world;
+   rim[1] = rimHeightFeet*UNITS_PER_FOOT;
+   rim[2] = 0.0;
+   if (major) *major = rimMajor_world;
+   if (tube) *tube = rimMinor_world;
+}
+
+// Backboard box of hoop i (6 x 3.5 ft, bottom 0.9 ft under the rim)
+void hoopBoard(int i, float lo[3], float hi[3])
+{
+   const double hoop_x_pos = COURT_COLS * COURT_TILE * 0.5;
+   const double boardWidthFeet = 6.0;
+   const double boardHeightFeet = 3.5;
+   const double boardThicknessFeet = 0.167;
+   const double boardBottomFeet = 10.0 - 0.9;
+   const double bbOffset_world = (0.25 + 0.75)*UNITS_PER_FOOT + 0.5*boardThicknessFeet*UNITS_PER_FOOT;
+   const double face = hoop_x_pos - bbOffset_world - 0.5*boardThicknessFeet*UNITS_PER_FOOT;
+   const double back = face + boardThicknessFeet*UNITS_PER_FOOT;
+   lo[0] = i == 0 ? face : -back;
+   hi[0] = i == 0 ? back : -face;
+   lo[1] = boardBottomFeet*UNITS_PER_FOOT;
+   hi[1] = lo[1] + boardHeightFeet*UNITS_PER_FOOT;
+   lo[2] = -0.5*boardWidthFeet*UNITS_PER_FOOT;
+   hi[2] = -lo[2];
+}
+
+// Aim point for a shot at hoop i: the rim center, off by up to err (world
+// units) in a direction picked by u,v in [0,1)
+void shotTarget(int i, double err, double u, double v, float end[3])
+{
+   double rim[3];
+   rimCenter(i, rim, NULL, NULL);
+   end[0] = rim[0] + err*sqrt(u)*Cos(360*v);
+   end[1] = rim[1];
+   end[2] = rim[2] + err*sqrt(u)*Sin(360*v);
+}
+
+// Player shot at hoop i: 22 ft straight out from the rim, released at 5 ft
+void shotStart(int i, float start[3])
+{
+   const double shotDistanceFeet = 22.0;
+   double rim[3];
+   rimCenter(i, rim, NULL, NULL);
+   start[0] = rim[0] + (i == 0 ? -1 : 1)*shotDistanceFeet*UNITS_PER_FOOT;
+   start[1] = 5.0*UNITS_PER_FOOT;
+   start[2] = 0.0;
+}
+
+// Gravity of the original scripted arc: a one second player shot peaking
+// 12 ft over the rim and ending 1.8 ft under it
+float shotGravity(void)
+{
+   double rim[3];
+   rimCenter(0, rim, NULL, NULL);
+   const double start_y = 5.0*UNITS_PER_FOOT;
+   const double peak_y = rim[1] + 12.0*UNITS_PER_FOOT;
+   const double end_y = rim[1] - 1.8*UNITS_PER_FOOT;
+   return 2.0*(start_y - 2.0*peak_y + end_y);
+}
+
+// Cheap repeatable random number in [0,1) for shooter k (players
+// are -1 and -2), draw n
+static double shotRand(int k, int n)
+{
+   unsigned int h = (unsigned int)k*2654435761u ^ (unsigned int)n*2246822519u;
+   h ^= h >> 15;
+   h *= 2654435769u;
+   h ^= h >> 13;
+   return (h & 0xFFFFFF) / 16777216.0;
+}
+
+// Player shot at hoop i (keys 1/2); scores if it goes in
+void shootBall(int i)
+{
+   float start[3], end[3];
+   simNow();   // the ball leaves the hand now, not at the last tick
+   int n = shotsTaken[i]++;
+   shotStart(i, start);
+   shotTarget(i, SHOT_ERROR_FEET*UNITS_PER_FOOT, shotRand(-1-i, 2*n), shotRand(-1-i, 2*n+1), end);
+   if (BallLaunch(&balls, start, end, SHOT_FLIGHT, 900, SHOT_DURATION, i) >= 0)
+      shotAnimating[i]++;
+}
+
+// The court, the walls around the floor and both hoops for the ball physics,
+// and a net hung from each rim (just under the rim tube, 1.2 ft long)
+void ballWorld(void)
+{
+   const double courtLenHalfX = (COURT_COLS * COURT_TILE) * 0.5;
+   const double courtWidHalfZ = (COURT_ROWS * COURT_TILE) * 0.5;
+   // the walls stand where the courtside seating starts
+   const float lo[3] = {-courtLenHalfX - 1.0, 0.0, -courtWidHalfZ - 1.0};
+   const float hi[3] = { courtLenHalfX + 1.0, 0.0,  courtWidHalfZ + 1.0};
+   BallArena(&balls, lo, hi);
+   for (int i = 0; i < 2; ++i)
+   {
+      double rim[3], major, tube;
+      float c[3], blo[3], bhi[3];
+      rimCenter(i, rim, &major, &tube);
+      hoopBoard(i, blo, bhi);
+      c[0] = rim[0]; c[1] = rim[1]; c[2] = rim[2];
+      BallAddHoop(&balls, c, major, tube, blo, bhi);
+      c[1] -= 0.02*0.6; // basketballHoop() scale
+      NetInit(&nets[i], c, major*0.99, major*0.99*0.65, 1.2*UNITS_PER_FOOT, shotGravity());
+   }
+}
+
+// Warm-up shooter k takes a shot from their own spot (6-24 ft out, within
+// 75 degrees of straight on) at hoop k%2, and picks when to shoot again
+void warmupShot(int k, double t)
+{
+   const int hoop = k % 2;
+   const double distFeet = 6.0 + 18.0*shotRand(k, 0);
+   const double angle = (shotRand(k, 1) - 0.5) * 150.0;
+   double rim[3];
+   float start[3], end[3];
+   rimCenter(hoop, rim, NULL, NULL);
+   start[0] = rim[0] + (hoop == 0 ? -1 : 1)*distFeet*UNITS_PER_FOOT*Cos(angle);
+   start[1] = (4.5 + shotRand(k, 2))*UNITS_PER_FOOT;
+   start[2] = distFeet*UNITS_PER_FOOT*Sin(angle);
+   // longer shots hang longer and miss by more
+   const int n = (int)(t*SIM_HZ);
+   const double flight = 0.8 + 0.015*distFeet;
+   shotTarget(hoop, (0.25 + 0.015*distFeet)*UNITS_PER_FOOT, shotRand(k, 2*n), shotRand(k, 2*n+1), end);
+   const double life = flight + 1.5;
+   BallLaunch(&balls, start, end, flight, 600 + 600*shotRand(k, 3), life, 2 + k);
+   // rebound and reset before the next one
+   warmupNext[k] = t + life + 0.3 + 0.9*shotRand(k, n+7);
+}
+
+// Cycle how many players are warming up (key g)
+void cycleWarmup(void)
+{
+   double t = simNow();
+   warmupShooters = warmupShooters == 0 ? 40 : warmupShooters < WARMUP_MAX ? WARMUP_MAX : 0;
+   // stagger the first shots over a second and a half
+   for (int k = 0; k < warmupShooters; ++k)
+      warmupNext[k] = t + 1.5*shotRand(k, 4);
+}
+
+// Unit basketball for instancing: the leather sphere plus the two seams as
+// thin bands (a captured mesh keeps triangles only, not the seam lines)
+void ballModel(void)
+{
+   glBindTexture(GL_TEXTURE_2D, texBasketball);
+   glEnable(GL_TEXTURE_2D);
+   glColor3f(MAT_BALL_DIF[0], MAT_BALL_DIF[1], MAT_BALL_DIF[2]);
+   drawSolidSphereTextured(1.0);
+   glDisable(GL_TEXTURE_2D);
+
+   const double r = 1.002;
+   const double w = 0.02;
+   const int segs = lodSegs(64, 8);
+   const TrigTable* seam = TrigTab(segs);
+   glColor3f(0.0f, 0.0f, 0.0f);
+   // seam around y-axis
+   glBegin(GL_QUAD_STRIP);
+   for (int i = 0; i <= segs; ++i)
+   {
+      glNormal3d(seam->c[i], 0.0, seam->s[i]);
+      glVertex3d(r * seam->c[i], -w, r * seam->s[i]);
+      glVertex3d(r * seam->c[i],  w, r * seam->s[i]);
+   }
+   glEnd();
+   // seam around x-axis
+   glBegin(GL_QUAD_STRIP);
+   for (int i = 0; i <= segs; ++i)
+   {
+      glNormal3d(0.0, seam->c[i], seam->s[i]);
+      glVertex3d(-w, r * seam->c[i], r * seam->s[i]);
+      glVertex3d( w, r * seam->c[i], r * seam->s[i]);
+   }
+   glEnd();
+   glColor3f(1, 1, 1);
+   glEnable(GL_TEXTURE_2D);
+}
+
+// Every ball in the air plus the ones waiting in the two shooters' hands:
+// one instanced draw per level of detail, or basketball() per ball when
+// there are no shaders
+void drawBalls(void)
+{
+   const double ballRadius = balls.radius;
+   int n = BallInstances(&balls, ballBack, ballInst);
+   int held[2], nheld = 0;
+   for (int i = 0; i < 2; ++i)
+   {
+      if (shotAnimating[i]) continue;
+      float p[3];
+      shotStart(i, p);
+      MeshInstance hand = {p[0], p[1], p[2], i == 0 ? 0 : 180, 0};
+      ballInst[n++] = hand;
+      held[nheld++] = i;
+   }
+
+   // Each ball keeps its level from frame to frame: the pool carries it
+   // along when balls move slots, the held balls have their own
+   LodView view;
+   LodViewFromGL(&view);
+   for (int i = 0; i < n; ++i)
+   {
+      unsigned char* keep = i < balls.n ? balls.lod + i : heldLod + held[i - balls.n];
+      *keep = lodOn ? LodPick(*keep, LodPixels(&view, ballInst[i].x, ballInst[i].y, ballInst[i].z, ballRadius)) : 0;
+      ballLod[i] = *keep;
+   }
+
+   if (ballShader && ballMesh[0])
+   {
+      int start[LOD_LEVELS+1];
+      groupByLevel(ballInst, n, NULL, ballLod, ballSorted, start);
+      glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, MAT_BALL_SPEC);
+      glMaterialf (GL_FRONT_AND_BACK, GL_SHININESS, 8.0f);
+      glUseProgram(ballShader);
+      glUniform1f(glGetUniformLocation(ballShader, "Radius"), ballRadius);
+      drawLevels(ballMesh, ballShader, ballInstBuf, ballSorted, start);
+      // leave the matte material basketball() does; the rest of the scene relies on it
+      glMaterialf (GL_FRONT_AND_BACK, GL_SHININESS, 0.0f);
+      return;
+   }
+   for (int i = 0; i < n; ++i)
+   {
+      lodLevel = ballLod[i];
+      basketball(ballInst[i].x, ballInst[i].y, ballInst[i].z, ballRadius, ballInst[i].yaw);
+   }
+   lodLevel = 0;
+}
+
+// One net, see-through where the texture is
+void drawNet(int i)
+{
+   glEnable(GL_BLEND);
+   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+   glEnable(GL_TEXTURE_2D);
+   glBindTexture(GL_TEXTURE_2D, texBasketballNet);
+   glColor3f(0.8f,0.8f,0.8f);
+   NetDraw(&nets[i], netBlend);
+   glDisable(GL_TEXTURE_2D);
+   glDisable(GL_BLEND);
+}
+
+// World box of one seat: the chair mesh's box turned and scaled into place
+// (same transform as shaders/instance.vert)
+void seatBox(const MeshInstance* seat, float box[6])
+{
+   const float* cb = chairMesh[0]->box;
+   float c = Cos(seat->yaw);
+   float s = Sin(seat->yaw);
+   box[1] = seat->y + seat->scale*cb[1];
+   box[4] = seat->y + seat->scale*cb[4];
+   box[0] = box[2] = 1e30;
+   box[3] = box[5] = -1e30;
+   for (int k = 0; k < 4; ++k)
+   {
+      float x = cb[k&1 ? 3 : 0];
+      float z = cb[k&2 ? 5 : 2];
+      float wx = seat->x + seat->scale*( c*x + s*z);
+      float wz = seat->z + seat->scale*(-s*x + c*z);
+      if (wx < box[0]) box[0] = wx;
+      if (wx > box[3]) box[3] = wx;
+      if (wz < box[2]) box[2] = wz;
+      if (wz > box[5]) box[5] = wz;
+   }
+}
+
+// Cull tree over every cached prop: the parts staticArena was recorded in
+// (capturePart() in drawHoops, basketballHoop and drawCourtside), then one
+// box per seat.  The full-detail boxes also size the props for their level.
+void buildPropTree(void)
+{
+   const int npart = staticArena[0]->npart;
+   int nprop = npart + nChairSeats;
+   propBox = (float*)malloc(6*nprop*sizeof(float));
+   propVisible = (unsigned char*)malloc(nprop);
+   propLod = (unsigned char*)calloc(nprop, 1);
+   propMask = (unsigned char*)malloc(LOD_LEVELS*npart);
+   chairShown = (MeshInstance*)malloc((nChairSeats ? nChairSeats : 1)*sizeof(MeshInstance));
+   if (!propBox || !propVisible || !propLod || !propMask || !chairShown) Fatal("Cannot allocate %d prop boxes\n", nprop);
+   memcpy(propBox, staticArena[0]->box, 6*npart*sizeof(float));
+   for (int i = 0; i < nChairSeats; ++i)
+      seatBox(chairSeats + i, propBox + 6*(npart + i));
+   BvhBuild(&propTree, propBox, nprop);
+}
+
+// Which cached props (and seats) reach into the view: propVisible, or
+// NULL to draw them all when culling is off.  The planes come from the
+// current projection and modelview, so they are in court coordinates.
+const unsigned char* cullProps(void)
+{
+   if (!frustumCull) return NULL;
+   Frustum f;
+   FrustumFromGL(&f);
+   BvhCull(&propTree, &f, propVisible);
+   return propVisible;
+}
+
+// Level of every cached prop in show (all when NULL) from its size on screen
+void pickPropLevels(const unsigned char* show)
+{
+   LodView view;
+   LodViewFromGL(&view);
+   for (int i = 0; i < propTree.nprop; ++i)
+      if (!show || show[i])
+         propLod[i] = lodOn ? LodPick(propLod[i], LodBoxPixels(&view, propBox + 6*i)) : 0;
+}
+
+// Queue the cached props in show (all when NULL), each part from its
+// level's mesh, lit by the rig when it is on.  Of the two bleacher looks
+// only the one for the crowd mode is shown.
+void queueProps(const unsigned char* show)
+{
+   const int npart = staticArena[0]->npart;
+   const int hidden = crowdMode ? crowdPhotoPart : bleacherPart;
+   int rig = rigProgram();
+   for (int l = 0; l < LOD_LEVELS; ++l)
+   {
+      unsigned char* mask = propMask + l*npart;
+      for (int p = 0; p < npart; ++p)
+         mask[p] = (!show || show[p]) && propLod[p] == l && p != hidden;
+      queueMesh(staticArena[l], mask, rig, rig ? rigBind : NULL, PROF_STATIC);
+   }
+}
+
+// Record the props that never move into cached batches (run once at startup)
+// Replayed by drawCompleteBasketballCourt in place of the immediate-mode calls
+void buildStaticScene(void)
+{
+   const double courtLenHalfX = (COURT_COLS * COURT_TILE) * 0.5;
+   const double courtWidHalfZ = (COURT_ROWS * COURT_TILE) * 0.5;
+
+   // Every level of detail, each split into the same parts
+   // Seats are collected for drawChairs() rather than baked in (the same
+   // seats on every pass)
+   chairCollect = 1;
+   for (lodLevel = 0; lodLevel < LOD_LEVELS; ++lodLevel)
+   {
+      nChairSeats = 0;
+      captureBegin();
+      drawHoops(courtLenHalfX, SCENE_STATIC);
+      drawCourtside(courtLenHalfX, courtWidHalfZ, SCENE_STATIC);
+      staticArena[lodLevel] = captureEnd();
+
+      // One chair at the origin, facing +Z at unit scale
+      captureBegin();
+      chair(0, 0, 0, 0, 1);
+      chairMesh[lodLevel] = captureEnd();
+   }
+   chairCollect = 0;
+
+   glGenBuffers(1, &chairSeatBuf);
+   glBindBuffer(GL_ARRAY_BUFFER, chairSeatBuf);
+   glBufferData(GL_ARRAY_BUFFER, nChairSeats*sizeof(MeshInstance), chairSeats, GL_STATIC_DRAW);
+   glBindBuffer(GL_ARRAY_BUFFER, 0);
+   glGenBuffers(1, &chairCullBuf);
+   buildPropTree();
+
+   // Every seat of the bleacher band the capture went over gets a fan
+   CrowdInit(&crowd, CROWD_SEATS, CROWD_ROWS, courtLenHalfX, courtWidHalfZ, crowdBand[0], crowdBand[1], crowdBand[2], crowdBand[3]);
+   crowdShader = CreateShaderProg("shaders/crowd.vert", "shaders/crowd.frag");
+   crowdLightShader = CreateShaderProg("shaders/crowdlight.vert", "shaders/instance.frag");
+
+   instanceShader = CreateShaderProg("shaders/instance.vert", "shaders/instance.frag");
+   pixelShader = CreateShaderProg("shaders/pixel.vert", "shaders/pixel.frag");
+
+   // One basketball at the origin, unit radius, for the pooled balls
+   glBindTexture(GL_TEXTURE_2D, texBasketball);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+   for (lodLevel = 0; lodLevel < LOD_LEVELS; ++lodLevel)
+   {
+      captureBegin();
+      ballModel();
+      ballMesh[lodLevel] = captureEnd();
+   }
+   lodLevel = 0;
+   ballShader = CreateShaderProg("shaders/ball.vert", "shaders/instance.frag");
+   glGenBuffers(1, &ballInstBuf);
+}
+
+// The court's draws as render queue items (see drawCompleteBasketballCourt)
+void queuedFloor(int arg)      { drawBasketballCourt(COURT_ROWS, COURT_COLS, COURT_TILE); }
+void queuedHoops(int parts)    { drawHoops(COURT_COLS * COURT_TILE * 0.5, parts); }
+void queuedBalls(int arg)      { drawBalls(); }
+void queuedScoreboard(int arg) { drawCompleteScoreboard(0.0, 7.5, 0.0); }
+void queuedLogo(int arg)       { drawCenterLogo(); }
+void queuedCrowd(int arg)
+{
+   double t = SimTime() - ballBack;
+   Frustum f;
+   if (frustumCull) FrustumFromGL(&f);
+   CrowdDraw(&crowd, crowdShader, crowdLightShader, t, t - cheerTime, crowdMode == 2, frustumCull ? &f : NULL);
+}
+void queuedCourtside(int parts)
+{
+   drawCourtside(COURT_COLS * COURT_TILE * 0.5, COURT_ROWS * COURT_TILE * 0.5, parts);
+}
+void queuedChairs(int arg)
+{
+   const int npart = staticArena[0]->npart;
+   drawChairs(propShown ? propShown + npart : NULL, propLod + npart);
+}
+
+// MASTER BASKETBALL COURT FUNCTION: Draws the entire basketball court scene.
+// Standard version drawing full court with lines.  Everything is queued
+// first, then drawn opaque sorted by program, texture and material with
+// the see-through pieces (nets, backboards, center logo) back to front
+// last; with renderQueue off in the order queued (see-through still last).
+void drawCompleteBasketballCourt(double x, double y, double z, double scale)
+{
+   glPushMatrix();
+   glTranslated(x, y, z);
+   glScalef(scale, scale, scale);
+   queueBegin();
+
+   queueDraw(pixelLighting ? pixelShader : 0, texWood, 0, PROF_FLOOR, queuedFloor, 0);
+
+   // Cached static props (the ones in view), otherwise everything goes
+   // through immediate mode
+   int parts = SCENE_ALL;
+   if (staticScene && staticArena[0])
+   {
+      profBegin(PROF_STATIC);
+      propShown = cullProps();
+      pickPropLevels(propShown);
+      queueProps(propShown);
+      profEnd();
+      const int chairProg = chairInstancing ? instanceShader : 0;
+      queueDraw(chairProg, chairMesh[0]->nbatch ? chairMesh[0]->batch[0].tex : 0, 0, PROF_CHAIRS, queuedChairs, 0);
+      parts = SCENE_DYNAMIC;
+   }
+
+   // hoops and their nets (blended, at the rims)
+   if (parts & SCENE_STATIC) queueDraw(0, 0, 0, PROF_HOOPS, queuedHoops, parts);
+   for (int i = 0; i < 2; ++i)
+   {
+      float cx = 0, cz = 0;
+      for (int k = 0; k < NET_COLS; ++k)
+      {
+         cx += nets[i].ringX[k];
+         cz += nets[i].ringZ[k];
+      }
+      queueBlend(cx/NET_COLS, nets[i].ringY, cz/NET_COLS, PROF_HOOPS, drawNet, i);
+   }
+
+   // every fan in the bowl in one draw
+   if (crowdMode) queueDraw(crowdShader, crowd.tex, 0, PROF_CROWD, queuedCrowd, 0);
+
+   // every ball in the air in one draw (shiny)
+   queueDraw(ballShader, texBasketball, 1, PROF_BALLS, queuedBalls, 0);
+
+   // AROUND THE COURT ACCESSORIES (stages of their own)
+   queueDraw(0, 0, 0, -1, queuedCourtside, parts);
 
    // Adding center-hung score board
-   double sbX = 0.0;
-   double sbY = 7.5;
-   double sbZ = 0.0;
-   drawCompleteScoreboard(sbX, sbY, sbZ);
+   queueDraw(0, jumbotron.tex, 0, PROF_SCOREBOARD, queuedScoreboard, 0);
 
-   drawCenterLogo();
+   queueBlend(0, 0.11, 0, PROF_MARKINGS, queuedLogo, 0);
 
+   queueFlush(renderQueue);
    glPopMatrix();
 }
 
@@ -3107,11 +3910,87 @@ void killAllLights(void)
       glDisable(GL_LIGHT0 + i);
 }
 
+// Point on the rectangle hx by hz around the court, t = 0..1 going around
+void bowlPoint(double t, double hx, double hz, double* x, double* z)
+{
+   double d = fmod(t, 1.0) * 4*(hx + hz);
+   if (d < 2*hx)           { *x = -hx + d;  *z = -hz; }
+   else if ((d -= 2*hx) < 2*hz) { *x = hx;  *z = -hz + d; }
+   else if ((d -= 2*hz) < 2*hx) { *x = hx - d;  *z = hz; }
+   else                    { d -= 2*hx; *x = -hx; *z = hz - d; }
+}
+
+// The full arena rig as clustered lights (world units, court drawn at 1.5):
+// spots on the truss aimed into the stands all the way around, the LED
+// ribbon boards along the low rail chasing gold, and the scoreboard's
+// underside lights.  Binned and uploaded for the per-pixel shader.
+void arenaRig(void)
+{
+   const double s = 1.5;                                   // court scale in display()
+   const double hx = COURT_COLS * COURT_TILE * 0.5;        // court half length
+   const double hz = COURT_ROWS * COURT_TILE * 0.5;        // court half width
+   const double rail = 10.0 * UNITS_PER_FOOT;              // low rail from the court edge
+   const double railTop = 2.5 * UNITS_PER_FOOT;
+   const double shell = 40.0 * UNITS_PER_FOOT;             // outer shell
+   const double shellTop = 18.0 * UNITS_PER_FOOT;
+   const int nSpots = 192, nRibbon = 48, nBoard = 16;
+
+   // Truss spots over the aisle, each aimed at the middle of the crowd behind it
+   for (int k = 0; k < nSpots; ++k)
+   {
+      double x, z, tx, tz;
+      const double off = 0.5*(rail + shell);
+      bowlPoint((k + 0.5)/nSpots, hx + rail, hz + rail, &x, &z);
+      bowlPoint((k + 0.5)/nSpots, hx + off, hz + off, &tx, &tz);
+      const int gold = (k % 8 == 0);
+      Light l = {{x*s, 12.0, z*s}, {(tx - x)*s, 0.5*(railTop + shellTop)*s - 12.0, (tz - z)*s},
+                 {gold ? 0.8 : 0.45, gold ? 0.6 : 0.42, gold ? 0.2 : 0.35}, 12.0, 18.0, 2.0};
+      LightAdd(&l);
+   }
+   // Ribbon boards: short-range points along the rail, a gold wave running around
+   for (int k = 0; k < nRibbon; ++k)
+   {
+      double x, z;
+      bowlPoint((double)k/nRibbon, hx + rail, hz + rail, &x, &z);
+      const double pulse = 0.5 + 0.5*Sin(4*light_zh + 30*k);
+      Light l = {{x*s, (railTop + 0.05)*s, z*s}, {0, 0, 0},
+                 {pulse, 0.7*pulse, 0.15*pulse}, 2.0, 180.0, 0.0};
+      LightAdd(&l);
+   }
+   // Scoreboard underside, pointing down at center court
+   for (int k = 0; k < nBoard; ++k)
+   {
+      double x, z;
+      bowlPoint((double)k/nBoard, 1.0, 0.6, &x, &z);
+      Light l = {{x*s, 7.3*s, z*s}, {0, -1, 0}, {0.15, 0.16, 0.18}, 14.0, 40.0, 1.0};
+      LightAdd(&l);
+   }
+
+   float view[16];
+   glGetFloatv(GL_MODELVIEW_MATRIX, view);
+   LightsUpload(view);
+}
+
+// The per-pixel shader for drawing lit by the rig (0 if the rig is off)
+int rigProgram(void)
+{
+   if (!light || lightingMode != 2 || !pixelShader) return 0;
+   return pixelShader;
+}
+
+// Point the (current) per-pixel shader at this frame's lights
+void rigBind(void)
+{
+   SetLightUniforms(pixelShader);
+   LightsBind(pixelShader);
+}
+
 // Fuction to handle all lighitng
-// 0: standard for de-bugging, 1: game lighting, 2: pre-game spotlights
+// 0: pre-game spotlights, 1: game lighting, 2: game lighting plus the full rig
 void setupLighting(void)
 {
    glShadeModel(GL_SMOOTH);
+   LightsClear();
 
    // Global light toggle
    if (!light)
@@ -3189,11 +4068,17 @@ void setupLighting(void)
             glEnable(lid);
          }
 
-         drawBallRack(-6.0,0.0,-0.75);
-         drawBallRack(6.0, 0.0,0.75);
+         profBegin(PROF_BALLS);
+         drawBallRack(0, -6.0,0.0,-0.75);
+         drawBallRack(1, 6.0, 0.0,0.75);
+         profEnd();
 
          break;
       }
+      // Everything: the game lights below plus the clustered rig
+      case 2:
+         arenaRig();
+         // fall through
       // Game lighting, focus on court. Not much lighting into the stands
       case 1:
       {
@@ -3253,6 +4138,13 @@ void display(void)
    /* ================= FRAME SETUP =================
     * Clear buffers, reset transforms, and get the camera where it needs to be.
     */
+   profFrameBegin();
+   // Jumbotron screen first so the laptops and all four sides see this frame's
+   profBegin(PROF_SCOREBOARD);
+   updateJumbotron();
+   profEnd();
+   // The jumbotron and the clip (in idle) bind textures behind the state cache
+   stateInvalidate();
    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
    glEnable(GL_DEPTH_TEST);
    glLoadIdentity();
@@ -3281,8 +4173,15 @@ void display(void)
    }
 
    // Lighting handled on its own given the multiple lighting modes 
+   profBegin(PROF_LIGHTING);
    setupLighting();
+   profEnd();
    drawCompleteBasketballCourt(0, 0, 0, 1.5);
+
+   if (profOverlay)
+      profDraw();
+   profFrameEnd();
+   statsFrameEnd();
    
    ErrCheck("display");
    glFlush();
@@ -3328,6 +4227,7 @@ void special(int key,int x,int y)
    // Recompute projection + redraw
    Project();
    glutPostRedisplay();
+   scheduleFrames();
 }
 
 // Glut calls this when a key is pressed
@@ -3366,19 +4266,19 @@ void key(unsigned char ch,int x,int y)
    else if (ch == 'k' || ch == 'K')
    {
       // flip between lighting modes
-      lightingMode = (lightingMode + 1) % 2;
+      lightingMode = (lightingMode + 1) % 3;
    }
    else if (ch=='1') // shoot on home team hoop
    {
-      shotAnimating[1] = 1;
-      shotStartTime[1] = glutGet(GLUT_ELAPSED_TIME)/1000.0;
-      shotSwishTriggered[1] = 0;
+      shootBall(1);
    }
    else if (ch=='2') // shoot on away team hoop
    {
-      shotAnimating[0] = 1;
-      shotStartTime[0] = glutGet(GLUT_ELAPSED_TIME)/1000.0;
-      shotSwishTriggered[0] = 0;
+      shootBall(0);
+   }
+   else if (ch=='g'||ch=='G') // players warming up: none, a few, a crowd
+   {
+      cycleWarmup();
    }
    else if(ch=='`'||ch=='~')
    {
@@ -3387,7 +4287,82 @@ void key(unsigned char ch,int x,int y)
    }
    else if(ch=='j'||ch=='J')
    {
-      currentVideoFrame=(currentVideoFrame+1)%6;
+      if(video)
+      {
+         // play/pause the streamed clip; the clock restarts from now
+         videoPlaying = 1 - videoPlaying;
+         videoClock = glutGet(GLUT_ELAPSED_TIME)/1000.0;
+      }
+      else
+      {
+         currentVideoFrame=(currentVideoFrame+1)%6;
+         jumboDirty = 1;
+      }
+   }
+   else if(ch=='c'||ch=='C')
+   {
+      // retained GPU floor vs immediate-mode tiles
+      courtVbo = 1 - courtVbo;
+   }
+   else if(ch=='b'||ch=='B')
+   {
+      // cached static batches vs immediate-mode props
+      staticScene = 1 - staticScene;
+   }
+   else if(ch=='f'||ch=='F')
+   {
+      // frame cap while animating: 60 -> 30 -> uncapped
+      fpsCap = (fpsCap == 60) ? 30 : (fpsCap == 30) ? 0 : 60;
+   }
+   else if(ch=='t'||ch=='T')
+   {
+      // scoreboard text: stroke line segments <-> texture atlas quads
+      scoreFont = (scoreFont == TEXT_STROKE) ? TEXT_ATLAS : TEXT_STROKE;
+   }
+   else if(ch=='p')
+   {
+      // per-stage timing overlay
+      profOverlay = 1 - profOverlay;
+   }
+   else if(ch=='P')
+   {
+      profDumpCSV(PROFILE_CSV);
+   }
+   else if(ch=='i'||ch=='I')
+   {
+      // one instanced draw for all chairs vs one mesh replay per chair
+      chairInstancing = 1 - chairInstancing;
+   }
+   else if(ch=='u'||ch=='U')
+   {
+      // draw only the cached props in view vs all of them
+      frustumCull = 1 - frustumCull;
+   }
+   else if(ch=='o'||ch=='O')
+   {
+      // curved props at the detail their size on screen needs vs always full
+      lodOn = 1 - lodOn;
+   }
+   else if(ch=='q'||ch=='Q')
+   {
+      // court draws sorted by state with repeated state skipped vs in draw order
+      renderQueue = 1 - renderQueue;
+      stateCache = renderQueue;
+   }
+   else if(ch=='e'||ch=='E')
+   {
+      // crowd: fan impostors, fans doing the wave, the crowd photo
+      crowdMode = (crowdMode + 1) % 3;
+   }
+   else if(ch=='r'||ch=='R')
+   {
+      // per-function draw counts on stderr every STATS_PERIOD frames
+      statsPeriod = statsPeriod ? 0 : STATS_PERIOD;
+   }
+   else if(ch=='x'||ch=='X')
+   {
+      // floor lit per pixel (one quad) vs fixed-function lights on the tiles
+      pixelLighting = 1 - pixelLighting;
    }
 
    // Translate shininess power to actual OpenGL value
@@ -3424,6 +4399,8 @@ void key(unsigned char ch,int x,int y)
    /* Recompute projection + redraw */
    Project();
    glutPostRedisplay();
+   // a shot or the light switch may have started or stopped an animation
+   scheduleFrames();
 }
 
 /*
@@ -3490,77 +4467,159 @@ void motion(int x, int y)
       prev_mouse_x = x;
       prev_mouse_y = y;
       glutPostRedisplay();
+      scheduleFrames();
    }
 }
 
 /*
  *  GLUT calls this routine when there is nothing else to do
  */
-void idle()
+// Blend two angles in degrees the short way round
+static double lerpAngle(double a, double b, double f)
 {
-   double t = glutGet(GLUT_ELAPSED_TIME)/1000.0;
+   double d = b - a;
+   if (d > 180) d -= 360;
+   else if (d < -180) d += 360;
+   return fmod(a + f*d + 360, 360);
+}
+
+/*
+ *  One fixed simulation tick ending at time t: animation angles, shots,
+ *  nets, swishes and scoring.  Runs at SIM_HZ whatever the frame rate.
+ */
+void simStep(double t, double dt)
+{
+   simPrev = simCur;
    // Animate the plane
-   zh = fmod(90*t,360);
+   simCur.zh = fmod(90*t,360);
    // Animate the light if move is enabled
    if (move) {
-      light_zh = fmod(45*t,360);
+      simCur.lightZh = fmod(45*t,360);
    }
 
-   // Updating for net swish animations
-   const double swishDuration = 0.7;
+   // Players warming up take their next shots
+   for(int k=0; k<warmupShooters; ++k)
+      if(t>=warmupNext[k]) warmupShot(k, t);
+
+   // Every ball in play, then the nets they drop through; makes swish
+   // and score for the players
+   BallStep(&balls, dt);
    for(int i=0; i<2; ++i)
+      NetStep(&nets[i], dt, &balls);
+   for(int m=0; m<balls.nmake; ++m)
    {
-      if(netAnimating[i])
+      int i = balls.make[m].hoop;
+      if(balls.make[m].tag<2)
       {
-         double runningTime = t - netAnimStart[i];
-         if(runningTime>=swishDuration)
-         {
-            netAnimating[i] = 0;
-            netSwayPhase[i] = 0.0;
-         } else {
-            double swishProgress = runningTime / swishDuration; // 0 to 1 over duration of swish
-            // first back, slightly forward then back to rest
-            // exact function gotten from chatGPT since wasn't sure how to model back, slightly forward, back to rest
-            double swing = -sin(M_PI * swishProgress) * (swishProgress);
-            netSwayPhase[i] = swing; 
-         }
+         playSwish();
+         cheerTime = t;
+         if(score[i]>199) score[i] = 0;
+         else score[i]++;
       }
    }
-
-   // Updating shot animations w/ swish motion
-   const double rimHitTime = 0.80; // progress through shot which ball is going through hoop
-   for(int i=0; i<2; ++i)
+   // Balls done bouncing go back to their shooters; walk backwards since
+   // retiring moves the last ball into the gap
+   for(int b=balls.n-1; b>=0; --b)
    {
-      if(shotAnimating[i])
-      {
-         double timeProgress = t - shotStartTime[i];
-         double shotProgress = timeProgress / SHOT_DURATION;
+      if(balls.age[b]<balls.life[b]) continue;
+      if(balls.tag[b]<2) shotAnimating[balls.tag[b]]--;
+      BallRetire(&balls, b);
+   }
+}
 
-         if(shotProgress>1.0) shotProgress = 1.0;
-         
-         // swish movement / sound only play once
-         if(!shotSwishTriggered[i]&&shotProgress>=rimHitTime)
-         {
-            netAnimating[i] = 1;
-            netAnimStart[i] = t;
-            shotSwishTriggered[i] = 1;
-            playSwish();
-         }
-         
-         if(timeProgress>=SHOT_DURATION)
-         {
-            shotAnimating[i] = 0;
-            if(score[i]>199) score[i] = 0;
-            else score[i]++;
-         }
+// Run the simulation up to the wall clock; returns the time of its last tick
+double simNow(void)
+{
+   SimAdvance(glutGet(GLUT_ELAPSED_TIME)/1000.0, simStep);
+   return SimTime();
+}
+
+/*
+ *  GLUT calls this routine when there is nothing else to do
+ */
+void idle()
+{
+   double t = glutGet(GLUT_ELAPSED_TIME)/1000.0;
+   SimAdvance(t, simStep);
 
-         shotParamT[i] = timeProgress;
+   // Draw between the last two ticks
+   double f = SimAlpha();
+   zh = lerpAngle(simPrev.zh, simCur.zh, f);
+   light_zh = lerpAngle(simPrev.lightZh, simCur.lightZh, f);
+   ballBack = (1 - f)*SIM_DT;
+   netBlend = f;
 
-      } else {
-         shotParamT[i] = 0.0;
+   // Jumbotron clip follows the wall clock (frames are dropped if behind)
+   if(video && videoPlaying)
+   {
+      videoTime += t - videoClock;
+      videoClock = t;
+      if(VideoUpdate(video, videoTime))
+      {
+         videoHasFrame = 1;
+         jumboDirty = 1;
       }
    }
    glutPostRedisplay();
+   scheduleFrames();
+}
+
+// Anything changing on its own (without input)?
+int sceneAnimating(void)
+{
+   // sweeping warm-up spotlights, chasing ribbon boards
+   if (light && move && lightingMode != 1)
+      return 1;
+   // jumbotron clip playing
+   if (video && videoPlaying)
+      return 1;
+   // the wave going around, the crowd cheering a basket
+   if (crowdMode == 2 || SimTime() - cheerTime < CROWD_CHEER + CROWD_LAG)
+      return 1;
+   // players warming up, even between shots
+   if (warmupShooters)
+      return 1;
+   // ball in the air or net still swaying
+   if (balls.n)
+      return 1;
+   for (int i = 0; i < 2; ++i)
+      if (NetMoving(&nets[i]))
+         return 1;
+   return 0;
+}
+
+// Capped frame: advance the animation like the idle callback does
+void frameTick(int unused)
+{
+   frameTimerArmed = 0;
+   idle();
+}
+
+// Keep frames coming only while something animates so a still scene
+// sleeps in the event loop instead of redrawing flat out
+void scheduleFrames(void)
+{
+   if (!sceneAnimating())
+   {
+      glutIdleFunc(NULL);
+      return;
+   }
+   // Uncapped: redraw from idle, swaps (and vsync if on) set the pace
+   if (fpsCap <= 0)
+   {
+      glutIdleFunc(idle);
+      return;
+   }
+   // Capped: one timer per frame, aimed at a steady period
+   glutIdleFunc(NULL);
+   if (frameTimerArmed) return;
+   double now = glutGet(GLUT_ELAPSED_TIME)/1000.0;
+   double period = 1.0/fpsCap;
+   if (nextFrameTime < now - period) nextFrameTime = now;  // was asleep or fell behind
+   nextFrameTime += period;
+   int delayMs = (int)((nextFrameTime - now)*1000.0 + 0.5);
+   frameTimerArmed = 1;
+   glutTimerFunc(delayMs > 0 ? delayMs : 0, frameTick, 0);
 }
 
 /*
@@ -3580,54 +4639,88 @@ int main(int argc,char* argv[])
    // safe row alignment for reading bmp files
    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-   // Loading textures
-   texWood = LoadTexBMP("textures/WoodFloor2.bmp");
+#ifdef USEGLEW
+   //  Initialize GLEW (texture loading may need glGenerateMipmap)
+   if (glewInit()!=GLEW_OK) Fatal("Error initializing GLEW\n");
+#endif
+
+   // Loading textures: one batch so the files are read in parallel
+   // {texture, file, alpha, mipmap, anisotropy}: the tiled floor and the
+   // crowd and pole textures are minified a lot, so they get mip chains
+   TexRequest textures[] =
+   {
+      {&texWood,"textures/WoodFloor2.bmp",0,1,8},
+      {&texBasketball,"textures/basketballLeather.bmp",0,1,0},
+      {&texFuselage,"textures/airplane.bmp",0},
+      {&texCanopy,"textures/texCanopy.bmp",0},
+      {&texWings,"textures/airplane_wings.bmp",0},
+      {&texFire,"textures/fire.bmp",0},
+      {&texPole,"textures/HoopPoleTex.bmp",0,1,4},
+      {&texLebronDunk,"textures/lebronDunk.bmp",0},
+      {&texScorersTablePoster,"textures/scorersTablePoster.bmp",0},
+      {&texCuLogo,"textures/ColoradoLogo.bmp",0},
+      {&texSportsFans,"textures/SportsArenaFans.bmp",0,1,4},
+      {&texGatoradeLogo,"textures/gatoradeLogo.bmp",0},
+      {&texCoolerLid,"textures/whiteGatoradeLogo.bmp",0},
+      {&texScoreBoardLogo,"textures/cuChairLogo.bmp",0},
+      // Video board frames
+      {&texVideoFrames[0],"textures/videoBoard/CSCI5229_VideoBoard1.bmp",0},
+      {&texVideoFrames[1],"textures/videoBoard/CSCI5229_VideoBoard2.bmp",0},
+      {&texVideoFrames[2],"textures/videoBoard/CSCI5229_VideoBoard3.bmp",0},
+      {&texVideoFrames[3],"textures/videoBoard/CSCI5229_VideoBoard4.bmp",0},
+      {&texVideoFrames[4],"textures/videoBoard/CSCI5229_VideoBoard5.bmp",0},
+      {&texVideoFrames[5],"textures/videoBoard/CSCI5229_VideoBoard6.bmp",0},
+      // Loading net (32-bits)
+      {&texBasketballNet,"textures/basketballNet.bmp",1},
+      // Center logo is cirlce 
+      {&texCenterLogo,"textures/centerCourtLogo.bmp",1},
+      {&texBackboard,"textures/transparentBackboard.bmp",1},
+      {&texColoradoWordmark,"textures/coloradoWordmark.bmp",1},
+      {&texSidelineLogo,"textures/geometric_mountains.bmp",1},
+   };
+   LoadTexCache(TEXTURE_CACHE,textureS3TC);
+   LoadTexBatch(textures,sizeof(textures)/sizeof(textures[0]));
+
    // Make sure that the texture interacts w lighting (don't replace fragment color)
    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
-   // Wrap texture so it tiles instead of stretches
+   // Wrap the floor texture so it tiles instead of stretches
+   glBindTexture(GL_TEXTURE_2D, texWood);
    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-   // Use linear filter when image is smaller than texture
-   glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-   // Use linear filter when image is larger than texture
-   glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-   texBasketball = LoadTexBMP("textures/basketballLeather.bmp");
-   texFuselage = LoadTexBMP("textures/airplane.bmp");
-   texCanopy = LoadTexBMP("textures/texCanopy.bmp");
-   texWings = LoadTexBMP("textures/airplane_wings.bmp");
-   texFire = LoadTexBMP("textures/fire.bmp");
-   texPole = LoadTexBMP("textures/HoopPoleTex.bmp");
-   texLebronDunk = LoadTexBMP("textures/lebronDunk.bmp");
-   texScorersTablePoster = LoadTexBMP("textures/scorersTablePoster.bmp");
-   texCuLogo = LoadTexBMP("textures/ColoradoLogo.bmp");
-   texSportsFans = LoadTexBMP("textures/SportsArenaFans.bmp");
-   texGatoradeLogo = LoadTexBMP("textures/gatoradeLogo.bmp");
-   texCoolerLid = LoadTexBMP("textures/whiteGatoradeLogo.bmp");
-   texScoreBoardLogo = LoadTexBMP("textures/cuChairLogo.bmp");
-
-
-   // Video board frames
-   texVideoFrames[0] = LoadTexBMP("textures/videoBoard/CSCI5229_VideoBoard1.bmp");
-   texVideoFrames[1] = LoadTexBMP("textures/videoBoard/CSCI5229_VideoBoard2.bmp");
-   texVideoFrames[2] = LoadTexBMP("textures/videoBoard/CSCI5229_VideoBoard3.bmp");
-   texVideoFrames[3] = LoadTexBMP("textures/videoBoard/CSCI5229_VideoBoard4.bmp");
-   texVideoFrames[4] = LoadTexBMP("textures/videoBoard/CSCI5229_VideoBoard5.bmp");
-   texVideoFrames[5] = LoadTexBMP("textures/videoBoard/CSCI5229_VideoBoard6.bmp");
-
-   // Loading net (32-bits)
-   texBasketballNet = LoadTexBMP32("textures/basketballNet.bmp");
-   // Center logo is cirlce 
-   texCenterLogo = LoadTexBMP32("textures/centerCourtLogo.bmp");
-   texBackboard = LoadTexBMP32("textures/transparentBackboard.bmp");
-   texColoradoWordmark = LoadTexBMP32("textures/coloradoWordmark.bmp");
-   texSidelineLogo = LoadTexBMP32("textures/geometric_mountains.bmp");
 
-#ifdef USEGLEW
-   //  Initialize GLEW
-   if (glewInit()!=GLEW_OK) Fatal("Error initializing GLEW\n");
-#endif
+   // Ring tables for the tessellation loops
+   TrigInit();
+   // Swish decoded once and mixed on its own thread (AUDIO_SINK=alsa, null or wav:FILE)
+   if (AudioInit(getenv("AUDIO_SINK")))
+   {
+      swishSound = AudioLoad("basketballSwishSound.wav");
+      atexit(AudioShutdown);
+   }
+   // Record walls, crowd, furniture and hoop frames once (needs GL buffer entry points)
+   buildStaticScene();
+   // Jumbotron screen render target: the 6x3 face at ~170 pixels per unit
+   SurfaceInit(&jumbotron, 1024, 512, -3.0, -1.5, 3.0, 1.5);
+   // Streamed clip for the jumbotron, if one has been packed
+   video = VideoOpen(VIDEO_CLIP);
+   // Pool for every ball in the air (two held balls ride along when drawn)
+   BallInit(&balls, BALL_POOL, BALL_RADIUS_FEET*UNITS_PER_FOOT, shotGravity());
+   ballWorld();
+   ballInst = (MeshInstance*)malloc((BALL_POOL + 2)*sizeof(MeshInstance));
+   ballSorted = (MeshInstance*)malloc((BALL_POOL + 2)*sizeof(MeshInstance));
+   ballLod = (unsigned char*)calloc(BALL_POOL + 2, 1);
+   if (!ballInst || !ballSorted || !ballLod) Fatal("Cannot allocate ball placements\n");
+   // Cluster grid for the arena rig: the whole bowl up past the truss (world units)
+   {
+      const float hx = (COURT_COLS*COURT_TILE*0.5 + 40.0*UNITS_PER_FOOT)*1.5 + 1.0;
+      const float hz = (COURT_ROWS*COURT_TILE*0.5 + 40.0*UNITS_PER_FOOT)*1.5 + 1.0;
+      const float lo[3] = {-hx, 0.0, -hz};
+      const float hi[3] = { hx, 14.0,  hz};
+      LightsInit(lo, hi);
+   }
+   // Simulation clock starts now
+   SimReset(glutGet(GLUT_ELAPSED_TIME)/1000.0);
    //  Tell GLUT to call "idle" when there is nothing else to do
+   //  (the first call hands over to scheduleFrames)
    glutIdleFunc(idle);
    //  Tell GLUT to call "display" when the scene should be drawn
    glutDisplayFunc(display);
@@ -0,0 +1,333 @@
+//  Basketball nets as Verlet cloth
+//  Kevin McMahon
+#include "CSCIx229.h"
+#include "capture.h"
+#include "balls.h"
+#include "net.h"
+#include "profile.h"
+
+#define NET_ITERS  4       // constraint passes per tick
+#define NET_DAMP   0.985f  // velocity kept per tick
+#define NET_REST   0.01f   // slower than this (units/s) counts as still
+#define NET_SETTLE 60      // still ticks before the net sleeps
+#define NET_NEAR   64      // balls checked against one net per tick
+#define NET_DRAG   0.01f   // ball speed lost per net particle it drags
+#define NET_DRAG_MAX 0.15f // most speed lost in one tick
+#define NET_VCOLS  (NET_COLS+1)   // drawn columns (the seam is doubled for s=1)
+
+//  Texture coordinates and triangles are the same for every net
+static unsigned int netStatic = 0;
+static unsigned int netIndex = 0;
+static const int netIndices = (NET_ROWS-1)*NET_COLS*6;
+
+//
+//  Hang the net from a ring of radius topR at rim[1], tapering to bottomR
+//  height below, and let it settle under gravity
+//
+void NetInit(NetCloth* net,const float rim[3],float topR,float bottomR,float height,float gravity)
+{
+   for (int r=0;r<NET_ROWS;r++)
+   {
+      float f = (float)r/(NET_ROWS-1);
+      float R = topR + f*(bottomR-topR);
+      for (int c=0;c<NET_COLS;c++)
+      {
+         float a = 2*M_PI*c/NET_COLS;
+         int i = r*NET_COLS+c;
+         net->x[i] = net->ox[i] = rim[0] + R*cosf(a);
+         net->y[i] = net->oy[i] = rim[1] - f*height;
+         net->z[i] = net->oz[i] = rim[2] + R*sinf(a);
+      }
+      net->ring[r] = 2*R*sinf(M_PI/NET_COLS);
+   }
+   for (int c=0;c<NET_COLS;c++)
+   {
+      net->ringX[c] = net->x[c];
+      net->ringZ[c] = net->z[c];
+   }
+   net->ringY = rim[1];
+   float dR = (topR-bottomR)/(NET_ROWS-1);
+   float dy = height/(NET_ROWS-1);
+   net->vert = sqrtf(dR*dR+dy*dy);
+   net->gravity = gravity;
+   //  A swinging net stays inside the rim radius; a stretched one hangs lower
+   for (int k=0;k<3;k+=2)
+   {
+      net->lo[k] = rim[k] - topR;
+      net->hi[k] = rim[k] + topR;
+   }
+   net->lo[1] = rim[1] - 1.5f*height;
+   net->hi[1] = rim[1];
+   net->vbo = 0;
+
+   //  Take up the slack before the first frame
+   net->still = 0;
+   for (int k=0;k<240 && NetMoving(net);k++)
+      NetStep(net,1.0f/120,NULL);
+   for (int i=0;i<NET_N;i++)
+   {
+      net->ox[i] = net->x[i];
+      net->oy[i] = net->y[i];
+      net->oz[i] = net->z[i];
+   }
+   net->still = NET_SETTLE;
+}
+
+//
+//  One string between particles a and b: strings pull but do not push.
+//  The length correction uses d^2 instead of d (exact at the rest length),
+//  so there is no square root.  wa and wb are how much of the correction
+//  each end takes (0 for a particle tied to the rim).
+//
+static inline void Pull(float* x,float* y,float* z,int a,int b,float L2,float wa,float wb)
+{
+   float dx = x[b]-x[a];
+   float dy = y[b]-y[a];
+   float dz = z[b]-z[a];
+   float k = L2/(dx*dx+dy*dy+dz*dz+L2) - 0.5f;
+   k = k<0 ? k : 0;
+   x[a] -= wa*k*dx; y[a] -= wa*k*dy; z[a] -= wa*k*dz;
+   x[b] += wb*k*dx; y[b] += wb*k*dy; z[b] += wb*k*dz;
+}
+
+//
+//  Relax every string once, Gauss-Seidel in red/black order: every other
+//  row pair down the columns (each a whole ring at a time), then every
+//  other column pair around each ring.  No two strings in one loop share
+//  a particle, so the loops have no dependencies.
+//
+static void Strings(NetCloth* net)
+{
+   float* x = net->x;
+   float* y = net->y;
+   float* z = net->z;
+   const float V2 = net->vert*net->vert;
+   for (int pass=0;pass<2;pass++)
+      for (int r=pass;r<NET_ROWS-1;r+=2)
+      {
+         //  The top ring is tied on, so the ring below takes all of it
+         float wa = r==0 ? 0 : 1;
+         float wb = r==0 ? 2 : 1;
+         for (int c=r*NET_COLS;c<(r+1)*NET_COLS;c++)
+            Pull(x,y,z,c,c+NET_COLS,V2,wa,wb);
+      }
+   for (int r=1;r<NET_ROWS;r++)
+   {
+      const float R2 = net->ring[r]*net->ring[r];
+      const int i = r*NET_COLS;
+      for (int c=0;c<NET_COLS;c+=2)
+         Pull(x,y,z,i+c,i+c+1,R2,1,1);
+      for (int c=1;c<NET_COLS-1;c+=2)
+         Pull(x,y,z,i+c,i+c+1,R2,1,1);
+      Pull(x,y,z,i+NET_COLS-1,i,R2,1,1);
+   }
+}
+
+//
+//  Push the net out of a ball; returns the particles it touched
+//
+static int Push(NetCloth* net,float bx,float by,float bz,float R)
+{
+   int hits = 0;
+   for (int i=NET_COLS;i<NET_N;i++)
+   {
+      float dx = net->x[i]-bx;
+      float dy = net->y[i]-by;
+      float dz = net->z[i]-bz;
+      float dd = dx*dx+dy*dy+dz*dz;
+      if (dd<R*R)
+      {
+         float s = R/sqrtf(dd+1e-12f);
+         net->x[i] = bx + s*dx;
+         net->y[i] = by + s*dy;
+         net->z[i] = bz + s*dz;
+         hits++;
+      }
+   }
+   return hits;
+}
+
+//
+//  Advance one tick of dt seconds; balls (may be NULL) collide with it
+//
+void NetStep(NetCloth* net,float dt,BallPool* balls)
+{
+   //  Balls that can reach the net
+   int near[NET_NEAR];
+   int nnear = 0;
+   float R = 0;
+   if (balls)
+   {
+      R = balls->radius;
+      for (int i=0;i<balls->n && nnear<NET_NEAR;i++)
+         if (balls->px[i]>net->lo[0]-R && balls->px[i]<net->hi[0]+R &&
+             balls->py[i]>net->lo[1]-R && balls->py[i]<net->hi[1]+R &&
+             balls->pz[i]>net->lo[2]-R && balls->pz[i]<net->hi[2]+R)
+            near[nnear++] = i;
+   }
+   //  Asleep and nothing close
+   if (!nnear && !NetMoving(net)) return;
+
+   //  Verlet: the last move, damped, plus gravity (the tied ring never moves)
+   const float g = net->gravity*dt*dt;
+   for (int i=NET_COLS;i<NET_N;i++)
+   {
+      float x = net->x[i];
+      float y = net->y[i];
+      float z = net->z[i];
+      net->x[i] += NET_DAMP*(x-net->ox[i]);
+      net->y[i] += NET_DAMP*(y-net->oy[i]) + g;
+      net->z[i] += NET_DAMP*(z-net->oz[i]);
+      net->ox[i] = x;
+      net->oy[i] = y;
+      net->oz[i] = z;
+   }
+
+   //  Strings and balls, with the balls last so nothing ends up inside one
+   int hits[NET_NEAR];
+   for (int it=0;it<NET_ITERS;it++)
+   {
+      Strings(net);
+      for (int k=0;k<nnear;k++)
+      {
+         int j = near[k];
+         hits[k] = Push(net,balls->px[j],balls->py[j],balls->pz[j],R);
+      }
+   }
+
+   //  Every particle a ball drags along slows it down
+   for (int k=0;k<nnear;k++)
+   {
+      if (!hits[k]) continue;
+      int j = near[k];
+      float drag = NET_DRAG*hits[k];
+      if (drag>NET_DRAG_MAX) drag = NET_DRAG_MAX;
+      balls->vx[j] *= 1-drag;
+      balls->vy[j] *= 1-drag;
+      balls->vz[j] *= 1-drag;
+   }
+
+   //  Fastest particle this tick decides whether the net can sleep
+   float m = 0;
+   for (int i=NET_COLS;i<NET_N;i++)
+   {
+      float d = fabsf(net->x[i]-net->ox[i]) + fabsf(net->y[i]-net->oy[i]) + fabsf(net->z[i]-net->oz[i]);
+      if (d>m) m = d;
+   }
+   if (m<NET_REST*dt)
+      net->still++;
+   else
+      net->still = 0;
+   //  Falling asleep: stop exactly where it is
+   if (net->still==NET_SETTLE)
+      for (int i=0;i<NET_N;i++)
+      {
+         net->ox[i] = net->x[i];
+         net->oy[i] = net->y[i];
+         net->oz[i] = net->z[i];
+      }
+}
+
+//
+//  Still moving (or not yet settled)
+//
+int NetMoving(const NetCloth* net)
+{
+   return net->still<NET_SETTLE;
+}
+
+//
+//  Texture coordinates and triangles shared by every net: s goes once
+//  around, t is 1 at the rim and 0 at the bottom
+//
+static void NetBuffers(void)
+{
+   float st[NET_ROWS*NET_VCOLS][2];
+   for (int r=0;r<NET_ROWS;r++)
+      for (int c=0;c<NET_VCOLS;c++)
+      {
+         st[r*NET_VCOLS+c][0] = (float)c/NET_COLS;
+         st[r*NET_VCOLS+c][1] = 1 - (float)r/(NET_ROWS-1);
+      }
+   unsigned short tri[(NET_ROWS-1)*NET_COLS*6];
+   int n = 0;
+   for (int r=0;r<NET_ROWS-1;r++)
+      for (int c=0;c<NET_COLS;c++)
+      {
+         unsigned short a = r*NET_VCOLS+c;
+         unsigned short b = a+NET_VCOLS;
+         const unsigned short q[6] = {a,b,a+1, a+1,b,b+1};
+         for (int k=0;k<6;k++)
+            tri[n++] = q[k];
+      }
+   glGenBuffers(1,&netStatic);
+   glBindBuffer(GL_ARRAY_BUFFER,netStatic);
+   glBufferData(GL_ARRAY_BUFFER,sizeof(st),st,GL_STATIC_DRAW);
+   glGenBuffers(1,&netIndex);
+   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,netIndex);
+   glBufferData(GL_ELEMENT_ARRAY_BUFFER,sizeof(tri),tri,GL_STATIC_DRAW);
+   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,0);
+   glBindBuffer(GL_ARRAY_BUFFER,0);
+}
+
+//
+//  Draw f of the way from the last tick to this one with the current
+//  texture, color and blending.  Positions and normals are streamed into
+//  the net's buffer (orphaned each time so the GPU never waits on it).
+//
+void NetDraw(NetCloth* net,float f)
+{
+   if (!netStatic) NetBuffers();
+   if (!net->vbo) PROF_GL(glGenBuffers(1,&net->vbo));
+
+   //  Blend the two ticks
+   float px[NET_N],py[NET_N],pz[NET_N];
+   for (int i=0;i<NET_N;i++)
+   {
+      px[i] = net->ox[i] + f*(net->x[i]-net->ox[i]);
+      py[i] = net->oy[i] + f*(net->y[i]-net->oy[i]);
+      pz[i] = net->oz[i] + f*(net->z[i]-net->oz[i]);
+   }
+
+   //  Normal out of the cone: around the ring crossed with down the column
+   float v[NET_ROWS*NET_VCOLS][6];
+   for (int r=0;r<NET_ROWS;r++)
+      for (int c=0;c<NET_VCOLS;c++)
+      {
+         int i = r*NET_COLS + c%NET_COLS;
+         int e = r*NET_COLS + (c+1)%NET_COLS;
+         int w = r*NET_COLS + (c+NET_COLS-1)%NET_COLS;
+         int u = r>0 ? i-NET_COLS : i;
+         int d = r<NET_ROWS-1 ? i+NET_COLS : i;
+         float ax = px[e]-px[w], ay = py[e]-py[w], az = pz[e]-pz[w];
+         float bx = px[d]-px[u], by = py[d]-py[u], bz = pz[d]-pz[u];
+         float nx = ay*bz-az*by;
+         float ny = az*bx-ax*bz;
+         float nz = ax*by-ay*bx;
+         float len = sqrtf(nx*nx+ny*ny+nz*nz);
+         if (len==0) len = 1;
+         float* o = v[r*NET_VCOLS+c];
+         o[0] = px[i]; o[1] = py[i]; o[2] = pz[i];
+         o[3] = nx/len; o[4] = ny/len; o[5] = nz/len;
+      }
+   PROF_GL(glBindBuffer(GL_ARRAY_BUFFER,net->vbo));
+   PROF_GL(glBufferData(GL_ARRAY_BUFFER,sizeof(v),NULL,GL_STREAM_DRAW));
+   PROF_GL(glBufferSubData(GL_ARRAY_BUFFER,0,sizeof(v),v));
+
+   PROF_GL(glEnableClientState(GL_VERTEX_ARRAY));
+   PROF_GL(glEnableClientState(GL_NORMAL_ARRAY));
+   PROF_GL(glEnableClientState(GL_TEXTURE_COORD_ARRAY));
+   PROF_GL(glVertexPointer(3,GL_FLOAT,6*sizeof(float),(void*)0));
+   PROF_GL(glNormalPointer(GL_FLOAT,6*sizeof(float),(void*)(3*sizeof(float))));
+   PROF_GL(glBindBuffer(GL_ARRAY_BUFFER,netStatic));
+   PROF_GL(glTexCoordPointer(2,GL_FLOAT,0,(void*)0));
+   PROF_GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,netIndex));
+   glDrawElements(GL_TRIANGLES,netIndices,GL_UNSIGNED_SHORT,(void*)0);   // counted by the capture wrapper
+   PROF_GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,0));
+   PROF_GL(glBindBuffer(GL_ARRAY_BUFFER,0));
+   PROF_GL(glDisableClientState(GL_VERTEX_ARRAY));
+   PROF_GL(glDisableClientState(GL_NORMAL_ARRAY));
+   PROF_GL(glDisableClientState(GL_TEXTURE_COORD_ARRAY));
+   PROF_VERTS(NET_ROWS*NET_VCOLS);
+   PROF_TRIS(netIndices/3);
+}
@@ -0,0 +1,55 @@
+#ifndef NET_H
+#define NET_H
+
+//
+//  Basketball nets as Verlet cloth
+//  Kevin McMahon
+//
+//  Each net is NET_COLS x NET_ROWS particles hung from the rim as a
+//  truncated cone; the top ring is tied to the rim.  Particles are kept
+//  as separate x/y/z arrays (row by row) so NetStep() integrates them in
+//  one vectorized loop, and the stick constraints are relaxed a whole
+//  ring (or every second column) at a time with a square-root-free length
+//  correction so those loops vectorize too.  Balls closer than their
+//  radius push the particles out of the way and are slowed a little for
+//  every particle they drag.
+//
+//  A net that has stopped moving with no ball near it sleeps: NetStep()
+//  costs nothing until a ball comes close again.  NetDraw() blends the
+//  last two ticks and streams the vertices into the net's own vertex
+//  buffer, so the draw is one glDrawElements.
+//
+//  Needs capture.h and balls.h included first.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NET_COLS 24
+#define NET_ROWS 8
+#define NET_N    (NET_COLS*NET_ROWS)
+
+typedef struct
+{
+   float x[NET_N],y[NET_N],z[NET_N];      // this tick
+   float ox[NET_N],oy[NET_N],oz[NET_N];   // last tick
+   float ringX[NET_COLS],ringZ[NET_COLS]; // where the top ring is tied on
+   float ringY;
+   float vert,ring[NET_ROWS];             // rest length down a column and around each ring
+   float lo[3],hi[3];                     // where a ball can reach it
+   float gravity;
+   int still;                             // ticks without movement
+   unsigned int vbo;                      // streamed positions and normals
+} NetCloth;
+
+void NetInit(NetCloth* net,const float rim[3],float topR,float bottomR,float height,float gravity);
+void NetStep(NetCloth* net,float dt,BallPool* balls);
+int  NetMoving(const NetCloth* net);
+void NetDraw(NetCloth* net,float f);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
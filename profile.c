@@ -0,0 +1,334 @@
+//  Frame profiler
+//  Kevin McMahon
+#include "CSCIx229.h"
+#include "profile.h"
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#define PROF_LAG     4     // frames of timestamp queries in flight
+#define PROF_MAXMARK 128   // stage switches timed on the GPU per frame
+#define PROF_DEPTH   16    // nesting depth of profBegin
+
+static const char* stageName[PROF_NSTAGE] =
+   {"other","lighting","floor","markings","static","hoops","balls",
+    "chairs","table","bowl","crowd","coolers","scoreboard"};
+
+// One frame worth of numbers
+typedef struct
+{
+   long   frame;
+   double cpu[PROF_NSTAGE];   // ms
+   double gpu[PROF_NSTAGE];   // ms, valid once gpuReady
+   unsigned long verts[PROF_NSTAGE];
+   unsigned long calls[PROF_NSTAGE];
+   unsigned long saved[PROF_NSTAGE];   // state changes skipped
+   int    gpuReady;
+} ProfFrame;
+
+unsigned long profVerts = 0;
+unsigned long profCalls = 0;
+unsigned long profTris = 0;
+unsigned long profSaved = 0;
+
+static ProfFrame hist[PROF_WINDOW];
+static long   frameNo = -1;
+static int    cur = PROF_OTHER;
+static int    stack[PROF_DEPTH];
+static int    depth = 0;
+static double tLast;
+static int    sync = 0;             // finish the GL at every switch
+static unsigned long vLast,cLast,sLast;
+
+// GPU timestamps: one set per frame in flight
+static int    gpuTimers = -1;       // -1 = not checked yet
+static GLuint query[PROF_LAG][PROF_MAXMARK];
+static int    markStage[PROF_LAG][PROF_MAXMARK];
+static int    nmark[PROF_LAG];
+static long   markFrame[PROF_LAG];
+
+//
+//  Monotonic clock in ms
+//
+static double Now(void)
+{
+#ifdef _WIN32
+   LARGE_INTEGER f,t;
+   QueryPerformanceFrequency(&f);
+   QueryPerformanceCounter(&t);
+   return 1e3*t.QuadPart/f.QuadPart;
+#else
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC,&ts);
+   return 1e3*ts.tv_sec + 1e-6*ts.tv_nsec;
+#endif
+}
+
+//
+//  Timestamp queries need GL 3.3 or ARB_timer_query
+//
+static int HaveTimers(void)
+{
+   int major=0,minor=0;
+   const char* ver = (const char*)glGetString(GL_VERSION);
+   if (ver && sscanf(ver,"%d.%d",&major,&minor)==2 && (major>3 || (major==3 && minor>=3)))
+      return 1;
+   const char* ext = (const char*)glGetString(GL_EXTENSIONS);
+   return ext && strstr(ext,"GL_ARB_timer_query");
+}
+
+//
+//  Charge everything since the last switch to the current stage, then
+//  make next current
+//
+static void Switch(int next)
+{
+   ProfFrame* F = hist + frameNo%PROF_WINDOW;
+   if (sync) glFinish();
+   double t = Now();
+   F->cpu[cur] += t - tLast;
+   F->verts[cur] += profVerts - vLast;
+   F->calls[cur] += profCalls - cLast;
+   F->saved[cur] += profSaved - sLast;
+   tLast = t;
+   vLast = profVerts;
+   cLast = profCalls;
+   sLast = profSaved;
+
+   int slot = frameNo%PROF_LAG;
+   if (gpuTimers && nmark[slot]<PROF_MAXMARK)
+   {
+      glQueryCounter(query[slot][nmark[slot]],GL_TIMESTAMP);
+      markStage[slot][nmark[slot]++] = next;
+   }
+   cur = next;
+}
+
+//
+//  Turn a finished set of timestamps into per-stage GPU ms
+//
+static void ReadGPU(int slot)
+{
+   long f = markFrame[slot];
+   if (nmark[slot]<2 || f<0 || frameNo-f>=PROF_WINDOW) return;
+   ProfFrame* F = hist + f%PROF_WINDOW;
+   GLuint64 t0,t1;
+   glGetQueryObjectui64v(query[slot][0],GL_QUERY_RESULT,&t0);
+   for (int k=1;k<nmark[slot];k++)
+   {
+      glGetQueryObjectui64v(query[slot][k],GL_QUERY_RESULT,&t1);
+      F->gpu[markStage[slot][k-1]] += 1e-6*(t1-t0);
+      t0 = t1;
+   }
+   F->gpuReady = 1;
+}
+
+void profFrameBegin(void)
+{
+   if (gpuTimers<0)
+   {
+      gpuTimers = HaveTimers();
+      if (gpuTimers) glGenQueries(PROF_LAG*PROF_MAXMARK,query[0]);
+      for (int k=0;k<PROF_LAG;k++) markFrame[k] = -1;
+   }
+   frameNo++;
+   ProfFrame* F = hist + frameNo%PROF_WINDOW;
+   memset(F,0,sizeof(ProfFrame));
+   F->frame = frameNo;
+
+   //  Collect the frame that used this query slot last time round
+   int slot = frameNo%PROF_LAG;
+   if (gpuTimers) ReadGPU(slot);
+   nmark[slot] = 0;
+   markFrame[slot] = frameNo;
+
+   depth = 0;
+   cur = PROF_OTHER;
+   tLast = Now();
+   vLast = profVerts;
+   cLast = profCalls;
+   sLast = profSaved;
+   if (gpuTimers)
+   {
+      glQueryCounter(query[slot][0],GL_TIMESTAMP);
+      markStage[slot][0] = PROF_OTHER;
+      nmark[slot] = 1;
+   }
+}
+
+void profFrameEnd(void)
+{
+   if (frameNo<0) return;
+   depth = 0;
+   Switch(PROF_OTHER);
+}
+
+void profBegin(int stage)
+{
+   if (frameNo<0) return;
+   if (depth<PROF_DEPTH) stack[depth] = cur;
+   depth++;
+   Switch(stage);
+}
+
+void profEnd(void)
+{
+   if (frameNo<0 || depth<1) return;
+   depth--;
+   Switch(depth<PROF_DEPTH ? stack[depth] : PROF_OTHER);
+}
+
+//
+//  Wait for the GL at every stage switch, so a renderer that defers the
+//  drawing (llvmpipe bins a whole frame) charges it to the stage that
+//  queued it rather than to whichever stage flushes
+//
+void profSync(int on)
+{
+   sync = on;
+}
+
+//
+//  Frame being drawn, or the last one finished between frames
+//
+long profFrame(void)
+{
+   return frameNo;
+}
+
+//
+//  CPU and GPU ms of one stage in frame; gpu is negative until the frame's
+//  timestamps come back.  0 once the frame is no longer kept.
+//
+int profStage(long frame,int stage,double* cpu,double* gpu)
+{
+   if (frame<0 || frame>frameNo || frameNo-frame>=PROF_WINDOW || stage<0 || stage>=PROF_NSTAGE) return 0;
+   const ProfFrame* F = hist + frame%PROF_WINDOW;
+   *cpu = F->cpu[stage];
+   *gpu = F->gpuReady ? F->gpu[stage] : -1;
+   return 1;
+}
+
+//
+//  Bitmap text at window position (x,y)
+//
+static void Text(int x,int y,const char* format,...)
+{
+   char buf[256];
+   va_list args;
+   va_start(args,format);
+   vsnprintf(buf,sizeof(buf),format,args);
+   va_end(args);
+   glWindowPos2i(x,y);
+   for (char* ch=buf;*ch;ch++)
+      glutBitmapCharacter(GLUT_BITMAP_8_BY_13,*ch);
+}
+
+//
+//  Rolling averages over the kept frames in the lower left corner
+//
+void profDraw(void)
+{
+   double cpu[PROF_NSTAGE]={0},gpu[PROF_NSTAGE]={0},verts[PROF_NSTAGE]={0},calls[PROF_NSTAGE]={0},saved[PROF_NSTAGE]={0};
+   int n=0,ng=0;
+   //  The frame being drawn is still open, so average the finished ones
+   for (long f=frameNo-1;f>=0 && f>frameNo-PROF_WINDOW;f--)
+   {
+      ProfFrame* F = hist + f%PROF_WINDOW;
+      for (int s=0;s<PROF_NSTAGE;s++)
+      {
+         cpu[s] += F->cpu[s];
+         verts[s] += F->verts[s];
+         calls[s] += F->calls[s];
+         saved[s] += F->saved[s];
+         if (F->gpuReady) gpu[s] += F->gpu[s];
+      }
+      n++;
+      if (F->gpuReady) ng++;
+   }
+   if (!n) return;
+
+   int vp[4];
+   glGetIntegerv(GL_VIEWPORT,vp);
+   const int lh = 15;
+   const int h = (PROF_NSTAGE+3)*lh + 8;
+
+   glPushAttrib(GL_ENABLE_BIT|GL_CURRENT_BIT|GL_COLOR_BUFFER_BIT);
+   //  Color material off too, otherwise the text colors stick to the material
+   glDisable(GL_LIGHTING);
+   glDisable(GL_COLOR_MATERIAL);
+   glDisable(GL_DEPTH_TEST);
+   glDisable(GL_TEXTURE_2D);
+   glEnable(GL_BLEND);
+   glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA);
+
+   //  Dark panel behind the text
+   glMatrixMode(GL_PROJECTION);
+   glPushMatrix();
+   glLoadIdentity();
+   glOrtho(0,vp[2],0,vp[3],-1,1);
+   glMatrixMode(GL_MODELVIEW);
+   glPushMatrix();
+   glLoadIdentity();
+   glColor4f(0,0,0,0.6);
+   glRecti(0,0,56*8+10,h);
+   glPopMatrix();
+   glMatrixMode(GL_PROJECTION);
+   glPopMatrix();
+   glMatrixMode(GL_MODELVIEW);
+
+   double tc=0,tg=0,tv=0,tn=0,ts=0;
+   int y = h - lh;
+   glColor3f(1,1,0);
+   Text(5,y,"%-11s %8s %8s %9s %7s %7s","stage","cpu ms","gpu ms","verts","calls","saved");
+   glColor3f(1,1,1);
+   for (int s=0;s<PROF_NSTAGE;s++)
+   {
+      y -= lh;
+      if (ng)
+         Text(5,y,"%-11s %8.2f %8.2f %9.0f %7.0f %7.0f",stageName[s],cpu[s]/n,gpu[s]/ng,verts[s]/n,calls[s]/n,saved[s]/n);
+      else
+         Text(5,y,"%-11s %8.2f %8s %9.0f %7.0f %7.0f",stageName[s],cpu[s]/n,"-",verts[s]/n,calls[s]/n,saved[s]/n);
+      tc += cpu[s]; tg += gpu[s]; tv += verts[s]; tn += calls[s]; ts += saved[s];
+   }
+   y -= lh;
+   glColor3f(1,1,0);
+   if (ng)
+      Text(5,y,"%-11s %8.2f %8.2f %9.0f %7.0f %7.0f","total",tc/n,tg/ng,tv/n,tn/n,ts/n);
+   else
+      Text(5,y,"%-11s %8.2f %8s %9.0f %7.0f %7.0f","total",tc/n,"-",tv/n,tn/n,ts/n);
+   y -= lh;
+   Text(5,y,"avg of %d frames, %.1f fps (cpu)",n,tc>0 ? 1e3*n/tc : 0.0);
+
+   glPopAttrib();
+}
+
+//
+//  Write every kept frame, one row per stage
+//
+void profDumpCSV(const char* file)
+{
+   FILE* f = fopen(file,"w");
+   if (!f)
+   {
+      fprintf(stderr,"Cannot write profile %s\n",file);
+      return;
+   }
+   fprintf(f,"frame,stage,cpu_ms,gpu_ms,vertices,gl_calls,state_saved\n");
+   long first = frameNo-PROF_WINDOW+1;
+   if (first<0) first = 0;
+   for (long fr=first;fr<frameNo;fr++)
+   {
+      ProfFrame* F = hist + fr%PROF_WINDOW;
+      for (int s=0;s<PROF_NSTAGE;s++)
+      {
+         if (F->gpuReady)
+            fprintf(f,"%ld,%s,%.4f,%.4f,%lu,%lu,%lu\n",F->frame,stageName[s],F->cpu[s],F->gpu[s],F->verts[s],F->calls[s],F->saved[s]);
+         else
+            fprintf(f,"%ld,%s,%.4f,,%lu,%lu,%lu\n",F->frame,stageName[s],F->cpu[s],F->verts[s],F->calls[s],F->saved[s]);
+      }
+   }
+   fclose(f);
+   fprintf(stderr,"Wrote %s\n",file);
+}
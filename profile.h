@@ -0,0 +1,70 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+//
+//  Frame profiler
+//  Kevin McMahon
+//
+//  display() brackets the frame with profFrameBegin/End and each draw stage
+//  with profBegin/profEnd.  Time is charged to the innermost open stage, so
+//  a stage started inside another one pauses the outer one.  Each stage
+//  gets CPU time, GPU time (GL timestamp queries, read back a few frames
+//  later), vertices and GL calls, plus the state changes the render-state
+//  cache (capture.c) skipped.  The last PROF_WINDOW frames are kept for the
+//  overlay averages, the CSV dump and profStage().
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Draw stages (PROF_OTHER is everything outside a named stage)
+enum
+{
+   PROF_OTHER,
+   PROF_LIGHTING,
+   PROF_FLOOR,
+   PROF_MARKINGS,
+   PROF_STATIC,
+   PROF_HOOPS,
+   PROF_BALLS,
+   PROF_CHAIRS,
+   PROF_TABLE,
+   PROF_BOWL,
+   PROF_CROWD,
+   PROF_COOLERS,
+   PROF_SCOREBOARD,
+   PROF_NSTAGE
+};
+
+#define PROF_WINDOW 120   // frames kept for averages and CSV
+
+// Bumped by the capture layer for every vertex / GL call it forwards
+// (triangles are counted as rasterized, lines and points excluded) and
+// every state change it found already set; PROF_GL counts a call made
+// straight to OpenGL where it is made
+extern unsigned long profVerts;
+extern unsigned long profCalls;
+extern unsigned long profTris;
+extern unsigned long profSaved;
+#define PROF_VERTS(n) (profVerts += (n))
+#define PROF_CALLS(n) (profCalls += (n))
+#define PROF_TRIS(n)  (profTris  += (n))
+#define PROF_SAVED(n) (profSaved += (n))
+#define PROF_GL(call) (profCalls++, (call))   // evaluates to the call's result
+
+void profFrameBegin(void);
+void profFrameEnd(void);
+void profBegin(int stage);
+void profEnd(void);
+void profDraw(void);
+void profDumpCSV(const char* file);
+void profSync(int on);
+long profFrame(void);
+int  profStage(long frame,int stage,double* cpu,double* gpu);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
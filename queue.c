@@ -0,0 +1,202 @@
+//  Render queue
+//  Kevin McMahon
+#include "CSCIx229.h"
+#include "capture.h"
+#include "profile.h"
+#include "queue.h"
+
+typedef struct
+{
+   int blend;                 // drawn in the blended pass
+   int prog;                  // opaque sort key: program, texture, material
+   unsigned int tex;
+   int mat;
+   float depth;               // blended sort key: distance from the eye
+   int stage;                 // profiler stage, -1 = none
+   int order;                 // when it was queued
+   QueueDraw draw;            // a callback ...
+   int arg;
+   const Mesh* mesh;          // ... or one batch of a mesh
+   int batch,part;
+   const unsigned char* show;
+   void (*bind)(void);        // uniforms for prog, run after switching to it
+} QueueItem;
+
+static QueueItem* item = NULL;
+static int nitem = 0,maxitem = 0;
+static float eye[4];          // row 2 of the modelview (eye z)
+
+static QueueItem* Add(int blend,int stage)
+{
+   if (nitem==maxitem)
+   {
+      maxitem = maxitem ? 2*maxitem : 64;
+      item = (QueueItem*)realloc(item,maxitem*sizeof(QueueItem));
+      if (!item) Fatal("Cannot grow render queue to %d items\n",maxitem);
+   }
+   QueueItem* it = item+nitem;
+   memset(it,0,sizeof(QueueItem));
+   it->blend = blend;
+   it->stage = stage;
+   it->order = nitem++;
+   return it;
+}
+
+//
+//  Distance in front of the eye of a point in the queue's space
+//
+static float Depth(float x,float y,float z)
+{
+   return -(eye[0]*x + eye[1]*y + eye[2]*z + eye[3]);
+}
+
+//
+//  Start an empty queue; items are given (and drawn) in the space of the
+//  current modelview
+//
+void queueBegin(void)
+{
+   float M[16];
+   glGetFloatv(GL_MODELVIEW_MATRIX,M);
+   for (int c=0;c<4;c++)
+      eye[c] = M[4*c+2];
+   nitem = 0;
+}
+
+//
+//  Opaque draw function and the state it mostly uses
+//
+void queueDraw(int prog,unsigned int tex,int mat,int stage,QueueDraw draw,int arg)
+{
+   QueueItem* it = Add(0,stage);
+   it->prog = prog;
+   it->tex = tex;
+   it->mat = mat;
+   it->draw = draw;
+   it->arg = arg;
+}
+
+//
+//  See-through draw function centered on x,y,z
+//
+void queueBlend(float x,float y,float z,int stage,QueueDraw draw,int arg)
+{
+   QueueItem* it = Add(1,stage);
+   it->depth = Depth(x,y,z);
+   it->draw = draw;
+   it->arg = arg;
+}
+
+//
+//  The batches of a cached mesh, only the parts with show[p] set (all when
+//  NULL; show has to last until the flush).  Opaque batches sort on their
+//  texture, blended ones go part by part at the middle of the part's box.
+//
+void queueMesh(const Mesh* mesh,const unsigned char* show,int prog,void (*bind)(void),int stage)
+{
+   if (!mesh || !mesh->nvert) return;
+   for (int b=0;b<mesh->nbatch;b++)
+   {
+      const MeshBatch* mb = mesh->batch+b;
+      for (int p=0;p<mesh->npart;p++)
+      {
+         if ((show && !show[p]) || mb->part[p+1]==mb->part[p]) continue;
+         QueueItem* it = Add(mb->blend,stage);
+         it->prog = prog;
+         it->tex = mb->tex;
+         it->mesh = mesh;
+         it->batch = b;
+         it->bind = bind;
+         if (mb->blend)
+         {
+            const float* box = mesh->box+6*p;
+            it->depth = Depth(0.5*(box[0]+box[3]),0.5*(box[1]+box[4]),0.5*(box[2]+box[5]));
+            it->part = p;
+         }
+         else
+         {
+            //  One item draws every shown part of an opaque batch
+            it->part = -1;
+            it->show = show;
+            break;
+         }
+      }
+   }
+}
+
+//
+//  Opaque before blended; opaque by state, blended far to near
+//
+static int ByState(const void* a,const void* b)
+{
+   const QueueItem* A = (const QueueItem*)a;
+   const QueueItem* B = (const QueueItem*)b;
+   if (A->blend!=B->blend) return A->blend-B->blend;
+   if (A->blend)
+   {
+      if (A->depth!=B->depth) return A->depth<B->depth ? 1 : -1;
+   }
+   else
+   {
+      if (A->prog!=B->prog) return A->prog<B->prog ? -1 : 1;
+      if (A->tex!=B->tex) return A->tex<B->tex ? -1 : 1;
+      if (A->mat!=B->mat) return A->mat<B->mat ? -1 : 1;
+   }
+   return A->order-B->order;
+}
+
+//
+//  Opaque before blended, otherwise as queued
+//
+static int ByOrder(const void* a,const void* b)
+{
+   const QueueItem* A = (const QueueItem*)a;
+   const QueueItem* B = (const QueueItem*)b;
+   if (A->blend!=B->blend) return A->blend-B->blend;
+   return A->order-B->order;
+}
+
+//
+//  Draw everything queued, sorted or in the order queued
+//
+void queueFlush(int sorted)
+{
+   qsort(item,nitem,sizeof(QueueItem),sorted ? ByState : ByOrder);
+   //  What every callback starts from and leaves behind
+   int lit = glIsEnabled(GL_LIGHTING);
+   int prog = -1;
+   int stage = -1;
+   for (int k=0;k<nitem;k++)
+   {
+      const QueueItem* it = item+k;
+      if (it->stage!=stage)
+      {
+         if (stage>=0) profEnd();
+         if (it->stage>=0) profBegin(it->stage);
+         stage = it->stage;
+      }
+      if (it->mesh)
+      {
+         if (it->prog!=prog)
+         {
+            glUseProgram(it->prog);
+            if (it->bind) it->bind();
+            prog = it->prog;
+         }
+         drawMeshBatch(it->mesh,it->batch,it->part,it->show);
+         continue;
+      }
+      drawMeshDone();
+      glUseProgram(0);
+      it->draw(it->arg);
+      prog = -1;
+      if (lit) glEnable(GL_LIGHTING); else glDisable(GL_LIGHTING);
+      glEnable(GL_TEXTURE_2D);
+      glDisable(GL_BLEND);
+      glColor3f(1,1,1);
+   }
+   drawMeshDone();
+   glUseProgram(0);
+   if (stage>=0) profEnd();
+   nitem = 0;
+}
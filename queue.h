@@ -0,0 +1,37 @@
+#ifndef QUEUE_H
+#define QUEUE_H
+
+//
+//  Render queue
+//  Kevin McMahon
+//
+//  The court's draws are queued for the frame instead of drawn on the
+//  spot, then queueFlush() plays them: opaque items sorted by program,
+//  texture and material so neighbors share state (the render-state cache
+//  in capture.c then skips the repeats), and blended items last, farthest
+//  from the eye first.  An item is either a callback (an immediate-mode
+//  draw function) or one batch of a cached Mesh.  Callbacks are entered
+//  with no program and the mesh arrays released, and leave lighting,
+//  texturing and blending as the queue found them, so the order they run
+//  in does not matter.  Items carry the profiler stage they are charged to
+//  (-1 to leave it to the callback).  Unsorted, the queue plays in the
+//  order it was filled, blended items still last.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*QueueDraw)(int arg);
+
+void queueBegin(void);
+void queueDraw(int prog,unsigned int tex,int mat,int stage,QueueDraw draw,int arg);
+void queueBlend(float x,float y,float z,int stage,QueueDraw draw,int arg);
+void queueMesh(const Mesh* mesh,const unsigned char* show,int prog,void (*bind)(void),int stage);
+void queueFlush(int sorted);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
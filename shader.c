@@ -0,0 +1,113 @@
+//  GLSL program loading
+//  Kevin McMahon
+#include "CSCIx229.h"
+#include "shader.h"
+
+#define SHADER_COMMON "shaders/common.glsl"
+
+//
+//  Read text file
+//
+static char* ReadText(const char* file)
+{
+   FILE* f = fopen(file,"rb");
+   if (!f) Fatal("Cannot open text file %s\n",file);
+   fseek(f,0,SEEK_END);
+   long n = ftell(f);
+   rewind(f);
+   char* buffer = (char*)malloc(n+1);
+   if (!buffer) Fatal("Cannot allocate %ld bytes for text file %s\n",n+1,file);
+   if (fread(buffer,n,1,f)!=1 && n>0) Fatal("Cannot read %ld bytes for text file %s\n",n,file);
+   buffer[n] = 0;
+   fclose(f);
+   return buffer;
+}
+
+//
+//  Print Shader Log
+//
+static void PrintShaderLog(int obj,const char* file)
+{
+   int len=0;
+   glGetShaderiv(obj,GL_INFO_LOG_LENGTH,&len);
+   if (len>1)
+   {
+      int n=0;
+      char* buffer = (char*)malloc(len);
+      if (!buffer) Fatal("Cannot allocate %d bytes of text for shader log\n",len);
+      glGetShaderInfoLog(obj,len,&n,buffer);
+      fprintf(stderr,"%s:\n%s\n",file,buffer);
+      free(buffer);
+   }
+   glGetShaderiv(obj,GL_COMPILE_STATUS,&len);
+   if (!len) Fatal("Error compiling %s\n",file);
+}
+
+//
+//  Print Program Log
+//
+static void PrintProgramLog(int obj)
+{
+   int len=0;
+   glGetProgramiv(obj,GL_INFO_LOG_LENGTH,&len);
+   if (len>1)
+   {
+      int n=0;
+      char* buffer = (char*)malloc(len);
+      if (!buffer) Fatal("Cannot allocate %d bytes of text for program log\n",len);
+      glGetProgramInfoLog(obj,len,&n,buffer);
+      fprintf(stderr,"%s\n",buffer);
+      free(buffer);
+   }
+   glGetProgramiv(obj,GL_LINK_STATUS,&len);
+   if (!len) Fatal("Error linking program\n");
+}
+
+//
+//  Create Shader (common prelude + file)
+//
+static int CreateShader(GLenum type,const char* file)
+{
+   int shader = glCreateShader(type);
+   const char* source[2];
+   source[0] = ReadText(SHADER_COMMON);
+   source[1] = ReadText(file);
+   glShaderSource(shader,2,source,NULL);
+   free((char*)source[0]);
+   free((char*)source[1]);
+   fprintf(stderr,"Compile %s\n",file);
+   glCompileShader(shader);
+   PrintShaderLog(shader,file);
+   return shader;
+}
+
+//
+//  Create Shader Program
+//
+int CreateShaderProg(const char* VertFile,const char* FragFile)
+{
+   int prog = glCreateProgram();
+   int vert = CreateShader(GL_VERTEX_SHADER,VertFile);
+   int frag = CreateShader(GL_FRAGMENT_SHADER,FragFile);
+   glAttachShader(prog,vert);
+   glAttachShader(prog,frag);
+   glLinkProgram(prog);
+   PrintProgramLog(prog);
+   //  The program keeps them alive
+   glDeleteShader(vert);
+   glDeleteShader(frag);
+   return prog;
+}
+
+//
+//  Copy the fixed-function light switches into the common.glsl uniforms
+//  (prog must be current)
+//
+void SetLightUniforms(int prog)
+{
+   int lights[8];
+   for (int i=0;i<8;i++)
+      lights[i] = glIsEnabled(GL_LIGHT0+i);
+   glUniform1i(glGetUniformLocation(prog,"Lighting"),glIsEnabled(GL_LIGHTING));
+   glUniform1iv(glGetUniformLocation(prog,"LightOn"),8,lights);
+}
@@ -0,0 +1,24 @@
+#ifndef SHADER_H
+#define SHADER_H
+
+//
+//  GLSL program loading
+//  Kevin McMahon
+//
+//  Shader sources live in shaders/.  Every stage is compiled with
+//  shaders/common.glsl in front of it, which carries the #version line and
+//  the fixed-function lighting helper shared by all programs.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int  CreateShaderProg(const char* VertFile,const char* FragFile);
+void SetLightUniforms(int prog);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
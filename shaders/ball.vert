@@ -0,0 +1,21 @@
+//
+//  Basketball drawn once per instance: backspin about its local Z axis,
+//  turned to the heading of its flight, scaled to the ball radius
+//
+attribute vec4  Inst;       // x,y,z and heading in degrees
+attribute float InstScale;  // backspin angle in degrees (every ball is Radius)
+uniform   float Radius;
+
+void main()
+{
+   float c = cos(radians(Inst.w));
+   float s = sin(radians(Inst.w));
+   float cs = cos(radians(InstScale));
+   float ss = sin(radians(InstScale));
+   mat3  R = mat3(c,0.0,-s, 0.0,1.0,0.0, s,0.0,c)*mat3(cs,ss,0.0, -ss,cs,0.0, 0.0,0.0,1.0);
+   vec4  P = gl_ModelViewMatrix*vec4(Inst.xyz + Radius*(R*gl_Vertex.xyz),1.0);
+   vec3  N = normalize(gl_NormalMatrix*(R*gl_Normal));
+   gl_FrontColor = FixedLight(P.xyz/P.w,N,gl_Color);
+   gl_TexCoord[0] = gl_MultiTexCoord0;
+   gl_Position = gl_ProjectionMatrix*P;
+}
@@ -0,0 +1,122 @@
+#version 120
+//
+//  Prepended to every shader by CreateShaderProg
+//
+//  FixedLight() reproduces the fixed-function per-vertex lighting the rest of
+//  the scene uses (GL_COLOR_MATERIAL on ambient and diffuse, infinite viewer,
+//  spot cutoff/exponent and distance attenuation) so shader-drawn objects
+//  match their immediate-mode neighbours.  FixedDiffuse() is the same
+//  without emission and specular, for lighting that is kept across frames.
+//
+
+//  Mirrors glIsEnabled(GL_LIGHTING) and glIsEnabled(GL_LIGHT0+i)
+uniform bool Lighting;
+uniform bool LightOn[8];
+
+//  P = eye position, N = unit eye normal, color = material ambient/diffuse,
+//  surface 0 leaves out the material's emission and specular (the terms
+//  that depend on the material state or on where the viewer is)
+vec4 FixedLighting(vec3 P,vec3 N,vec4 color,float surface)
+{
+   if (!Lighting) return color;
+   vec3 c = surface*gl_FrontMaterial.emission.rgb + gl_LightModel.ambient.rgb*color.rgb;
+   for (int i=0;i<8;i++)
+   {
+      if (!LightOn[i]) continue;
+      vec3  L;
+      float att = 1.0;
+      if (gl_LightSource[i].position.w==0.0)
+         L = normalize(gl_LightSource[i].position.xyz);
+      else
+      {
+         vec3  D = gl_LightSource[i].position.xyz/gl_LightSource[i].position.w - P;
+         float d = length(D);
+         L = D/d;
+         att = 1.0/(gl_LightSource[i].constantAttenuation +
+                    d*(gl_LightSource[i].linearAttenuation + d*gl_LightSource[i].quadraticAttenuation));
+         //  Spot cone (cutoff 180 means a point light)
+         if (gl_LightSource[i].spotCutoff<=90.0)
+         {
+            float s = dot(-L,normalize(gl_LightSource[i].spotDirection));
+            att *= (s<gl_LightSource[i].spotCosCutoff) ? 0.0 : pow(s,gl_LightSource[i].spotExponent);
+         }
+      }
+      float Id = max(dot(N,L),0.0);
+      vec3  lc = gl_LightSource[i].ambient.rgb*color.rgb + Id*gl_LightSource[i].diffuse.rgb*color.rgb;
+      if (Id>0.0 && surface>0.0)
+      {
+         float Is = max(dot(N,normalize(L+vec3(0,0,1))),0.0);
+         float sh = gl_FrontMaterial.shininess;
+         lc += (sh>0.0 ? pow(Is,sh) : 1.0)*gl_LightSource[i].specular.rgb*gl_FrontMaterial.specular.rgb;
+      }
+      c += att*lc;
+   }
+   return vec4(clamp(c,0.0,1.0),color.a);
+}
+
+vec4 FixedLight(vec3 P,vec3 N,vec4 color)
+{
+   return FixedLighting(P,N,color,1.0);
+}
+
+//  Ambient and diffuse only, the same from any viewpoint
+vec4 FixedDiffuse(vec3 P,vec3 N,vec4 color)
+{
+   return FixedLighting(P,N,color,0.0);
+}
+
+//
+//  ClusterLight() adds the clustered lights (lights.c) binned into the
+//  fragment's cell of the world-space grid.  Sizes match lights.h.
+//
+#define LIGHT_MAX     256.0
+#define LIGHT_GX      32.0
+#define LIGHT_GY      4.0
+#define LIGHT_GZ      16.0
+#define LIGHT_INDEX_W 256.0
+#define LIGHT_INDEX_H 256.0
+#define LIGHT_CLUSTER_MAX 64
+
+uniform bool      Clustered;
+uniform sampler2D LightData;    // eye position+range, axis+cos cutoff, color+exponent
+uniform sampler2D LightGrid;    // first index and count per cluster
+uniform sampler2D LightIndex;   // light numbers
+uniform mat4      ViewInverse;  // eye -> world
+uniform vec3      GridLo;       // world -> cluster
+uniform vec3      GridScale;
+
+//  P = eye position, N = unit eye normal, color = material diffuse
+vec3 ClusterLight(vec3 P,vec3 N,vec3 color)
+{
+   if (!Lighting || !Clustered) return vec3(0.0);
+   vec3 g = floor((ViewInverse*vec4(P,1.0)).xyz*GridScale - GridLo*GridScale);
+   if (any(lessThan(g,vec3(0.0))) || any(greaterThanEqual(g,vec3(LIGHT_GX,LIGHT_GY,LIGHT_GZ))))
+      return vec3(0.0);
+   vec2 run = texture2D(LightGrid,(vec2(g.z*LIGHT_GX+g.x,g.y)+0.5)/vec2(LIGHT_GX*LIGHT_GZ,LIGHT_GY)).rg;
+   vec3 c = vec3(0.0);
+   for (int k=0;k<LIGHT_CLUSTER_MAX;k++)
+   {
+      if (float(k)>=run.y) break;
+      float r = run.x + float(k);
+      float i = texture2D(LightIndex,(vec2(mod(r,LIGHT_INDEX_W),floor(r/LIGHT_INDEX_W))+0.5)/vec2(LIGHT_INDEX_W,LIGHT_INDEX_H)).r;
+      float s = (i+0.5)/LIGHT_MAX;
+      vec4 pos = texture2D(LightData,vec2(s,0.5/3.0));
+      vec3 D = pos.xyz - P;
+      float d2 = dot(D,D);
+      if (d2>=pos.w*pos.w) continue;
+      vec3 L = D*inversesqrt(d2);
+      //  Smooth falloff to nothing at the range
+      float att = 1.0 - d2/(pos.w*pos.w);
+      att *= att;
+      vec4 axis = texture2D(LightData,vec2(s,1.5/3.0));
+      vec4 col  = texture2D(LightData,vec2(s,2.5/3.0));
+      if (axis.w>-1.5)
+      {
+         float cs = dot(-L,axis.xyz);
+         if (cs<axis.w) continue;
+         att *= pow(cs,col.w);
+      }
+      c += att*max(dot(N,L),0.0)*col.rgb;
+   }
+   return c*color;
+}
@@ -0,0 +1,12 @@
+//
+//  Crowd impostor: the fan's atlas cell tinted by the lighting, with the
+//  texels around the figure dropped (no blending, so no sorting)
+//
+uniform sampler2D Tex;
+
+void main()
+{
+   vec4 t = texture2D(Tex,gl_TexCoord[0].st);
+   if (t.a<0.5) discard;
+   gl_FragColor = vec4(gl_Color.rgb*t.rgb,1.0);
+}
@@ -0,0 +1,53 @@
+//
+//  Crowd impostor: one card per fan, turned to face the viewer about the
+//  vertical and colored by the light at its seat.  Fans sit still
+//  (the scene stops redrawing when nothing moves), stand with their arms
+//  up as the wave passes and stand cheering for a while after a basket.
+//
+attribute vec3 Inst;   // x,y,z of the feet
+attribute vec3 Fan;    // atlas variant, phase, shade
+attribute float Seat;  // position around the bowl, 0..1
+attribute vec3 Light;  // light at the seat, read from the light map (crowd.c)
+uniform float Time;    // seconds
+uniform float Cheer;   // seconds since the last basket
+uniform float Wave;    // 1 while the wave goes around
+uniform vec3  Right;   // the card's width across the view, eye coordinates
+uniform vec3  Up;      // ... and its height up the world vertical
+uniform vec2  Atlas;   // variants across, poses down
+uniform vec4  Fill;    // share of the card the figures take: seated xy, arms up zw
+uniform float Sunk;    // share of the card always under the bleachers while seated
+uniform float WavePeriod;     // seconds for the wave to go around (CROWD_WAVE)
+uniform float CheerTime;      // seconds the crowd stands after a basket (CROWD_CHEER)
+uniform float CheerLag;       // seconds the cheer takes to reach the last fan (CROWD_LAG)
+
+void main()
+{
+   //  Standing: the wave crest where it is around the bowl, or a cheer
+   //  that reaches each fan a little late (nothing to work out while
+   //  neither is on)
+   float stand = 0.0;
+   float up = 0.0;
+   if (Wave>0.0 || Cheer<CheerTime+CheerLag)
+   {
+      float crest = Wave*pow(max(cos(6.2832*(Seat - Time/WavePeriod)),0.0),40.0);
+      float since = Cheer - CheerLag*Fan.y;
+      float cheer = smoothstep(0.0,0.3,since)*(1.0 - smoothstep(CheerTime-0.5,CheerTime,since));
+      stand = max(crest,cheer);
+      //  Cheering fans pump their arms
+      float pump = sin(7.0*Time + 6.2832*Fan.y);
+      up = (crest>0.5 || (cheer>0.5 && pump>-0.3)) ? 1.0 : 0.0;
+   }
+   float lift = 0.25*stand;
+
+   //  Only the part of the card the figure can show: as wide and tall as
+   //  the pose needs, from where the bleachers stop hiding it
+   vec2 fill = up>0.5 ? Fill.zw : Fill.xy;
+   vec2 c = vec2(fill.x*gl_Vertex.x,mix(max(Sunk - lift,0.0),fill.y,gl_Vertex.y));
+   //  Card corners across the view and up the world vertical
+   vec4 P = gl_ModelViewMatrix*vec4(Inst,1.0);
+   P.xyz += c.x*Right + (c.y + lift)*Up;
+
+   gl_FrontColor = vec4(Fan.z*Light,1.0);
+   gl_TexCoord[0] = vec4((Fan.x + c.x + 0.5)/Atlas.x,(up + c.y)/Atlas.y,0.0,1.0);
+   gl_Position = gl_ProjectionMatrix*P;
+}
@@ -0,0 +1,17 @@
+//
+//  Crowd light map: one point per texel, lit where the fans' upper bodies
+//  sit at that spot of the band (gl_Vertex), facing the court and tilted up
+//  like the bleachers (gl_Normal), and drawn into the texel (gl_MultiTexCoord0).
+//  Ambient and diffuse only, so the map holds from any viewpoint until the
+//  lights change.
+//
+void main()
+{
+   vec4 P = gl_ModelViewMatrix*gl_Vertex;
+   vec3 N = normalize(gl_NormalMatrix*gl_Normal);
+   vec4 c = FixedDiffuse(P.xyz/P.w,N,vec4(1.0));
+   c.rgb = min(c.rgb + ClusterLight(P.xyz/P.w,N,vec3(1.0)),1.0);
+   gl_FrontColor = vec4(c.rgb,1.0);
+   gl_Position = vec4(gl_MultiTexCoord0.xy,0.0,1.0);
+   gl_PointSize = 1.0;
+}
@@ -0,0 +1,10 @@
+//
+//  Vertex-lit color, modulated by the texture when the batch has one
+//
+uniform bool      Textured;
+uniform sampler2D Tex;
+
+void main()
+{
+   gl_FragColor = Textured ? gl_Color*texture2D(Tex,gl_TexCoord[0].st) : gl_Color;
+}
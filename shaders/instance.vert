@@ -0,0 +1,18 @@
+//
+//  Mesh drawn once per instance: rotate about Y, scale, then translate
+//  (same order as glTranslated/glRotated/glScaled in the draw functions)
+//
+attribute vec4  Inst;       // x,y,z and yaw in degrees
+attribute float InstScale;
+
+void main()
+{
+   float c = cos(radians(Inst.w));
+   float s = sin(radians(Inst.w));
+   mat3  R = mat3(c,0.0,-s, 0.0,1.0,0.0, s,0.0,c);
+   vec4  P = gl_ModelViewMatrix*vec4(Inst.xyz + InstScale*(R*gl_Vertex.xyz),1.0);
+   vec3  N = normalize(gl_NormalMatrix*(R*gl_Normal));
+   gl_FrontColor = FixedLight(P.xyz/P.w,N,gl_Color);
+   gl_TexCoord[0] = gl_MultiTexCoord0;
+   gl_Position = gl_ProjectionMatrix*P;
+}
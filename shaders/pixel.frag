@@ -0,0 +1,16 @@
+//
+//  Fixed-function lights (spot cones included) plus the clustered lights
+//  evaluated per fragment, modulated by the texture when there is one
+//
+uniform bool      Textured;
+uniform sampler2D Tex;
+varying vec3 Pos;
+varying vec3 Norm;
+
+void main()
+{
+   vec3 N = normalize(Norm);
+   vec4 c = FixedLight(Pos,N,gl_Color);
+   c.rgb = min(c.rgb + ClusterLight(Pos,N,gl_Color.rgb),1.0);
+   gl_FragColor = Textured ? c*texture2D(Tex,gl_TexCoord[0].st) : c;
+}
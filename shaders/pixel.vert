@@ -0,0 +1,16 @@
+//
+//  Per-pixel lighting: pass the eye-space position and normal on instead
+//  of lighting the vertex
+//
+varying vec3 Pos;
+varying vec3 Norm;
+
+void main()
+{
+   vec4 P = gl_ModelViewMatrix*gl_Vertex;
+   Pos = P.xyz/P.w;
+   Norm = gl_NormalMatrix*gl_Normal;
+   gl_FrontColor = gl_Color;
+   gl_TexCoord[0] = gl_MultiTexCoord0;
+   gl_Position = gl_ProjectionMatrix*P;
+}
@@ -0,0 +1,58 @@
+//  Fixed-timestep simulation clock
+//  Kevin McMahon
+#include "sim.h"
+
+static double wallLast = 0;   // wall time at the last SimAdvance
+static double accum = 0;      // wall time not yet simulated
+static long   ticks = 0;      // ticks run since SimReset
+static double simStart = 0;   // simulation time of tick 0
+
+//
+//  Start the clock at wall time now
+//
+void SimReset(double now)
+{
+   wallLast = now;
+   simStart = now;
+   accum = 0;
+   ticks = 0;
+}
+
+//
+//  Run step(t,dt) for every whole tick up to wall time now.  After a long
+//  pause (nothing animating, a stall) at most SIM_MAX_STEPS are run and
+//  the rest of the gap is dropped.  Returns the number of ticks run.
+//
+int SimAdvance(double now,void (*step)(double t,double dt))
+{
+   accum += now - wallLast;
+   wallLast = now;
+   if (accum<0) accum = 0;
+   //  Simulation time simply pauses over the dropped part
+   if (accum>SIM_MAX_STEPS*SIM_DT) accum = SIM_MAX_STEPS*SIM_DT;
+   int steps = 0;
+   while (accum>=SIM_DT)
+   {
+      ticks++;
+      step(SimTime(),SIM_DT);
+      accum -= SIM_DT;
+      steps++;
+   }
+   return steps;
+}
+
+//
+//  Fraction of a tick since the last one (0 to 1)
+//
+double SimAlpha(void)
+{
+   return accum/SIM_DT;
+}
+
+//
+//  Simulation time of the last tick (seconds, same origin as the wall clock)
+//
+double SimTime(void)
+{
+   return simStart + ticks*SIM_DT;
+}
@@ -0,0 +1,33 @@
+#ifndef SIM_H
+#define SIM_H
+
+//
+//  Fixed-timestep simulation clock
+//  Kevin McMahon
+//
+//  Animation and game state advance in fixed SIM_HZ ticks no matter how
+//  fast frames are drawn.  SimAdvance() runs however many ticks fit into
+//  the wall time since the last call (accumulator); the leftover fraction
+//  of a tick is SimAlpha(), which the renderer uses to blend the previous
+//  and current tick's state.  Results only depend on the tick count, so a
+//  run driven by a fixed clock (the bench) is reproducible.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SIM_HZ        120
+#define SIM_DT        (1.0/SIM_HZ)
+#define SIM_MAX_STEPS 30      // ticks per call before the clock gives up catching up
+
+void   SimReset(double now);
+int    SimAdvance(double now,void (*step)(double t,double dt));
+double SimAlpha(void);
+double SimTime(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
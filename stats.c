@@ -0,0 +1,174 @@
+//  Render statistics
+//  Kevin McMahon
+#include "CSCIx229.h"
+#include "stats.h"
+
+#define STATS_HASH 1024   // name lookup slots (power of 2, well over STATS_FUNCS)
+
+int statsPeriod = 0;
+
+//  This frame: one entry per draw function, kept from frame to frame
+//  (the last entry collects the functions past STATS_FUNCS-1)
+static RenderStats cur[STATS_FUNCS];
+static int ncur = 0;
+static short slot[STATS_HASH];        // index into cur plus one, 0 = empty
+static const char* lastName = NULL;   // lookups come in runs (a vertex at a time)
+static RenderStats* lastStats = NULL;
+
+//  Last finished frame, most vertices first
+static RenderStats done[STATS_FUNCS];
+static int ndone = 0;
+static RenderStats total;
+static long frameNo = 0;
+
+static const char* modeName[STATS_NMODE] =
+   {"points","lines","line loops","line strips","triangles",
+    "triangle strips","triangle fans","quads","quad strips","polygons"};
+
+//
+//  Counters for draw function fn (a __func__, so one address per function)
+//
+static RenderStats* Func(const char* fn)
+{
+   if (fn==lastName) return lastStats;
+   unsigned int h = (unsigned int)((size_t)fn>>3) & (STATS_HASH-1);
+   while (slot[h] && cur[slot[h]-1].name!=fn)
+      h = (h+1) & (STATS_HASH-1);
+   RenderStats* s;
+   if (slot[h])
+      s = cur+slot[h]-1;
+   else if (ncur<STATS_FUNCS-1)
+   {
+      slot[h] = ++ncur;
+      s = cur+ncur-1;
+      s->name = fn;
+   }
+   else
+   {
+      s = cur+STATS_FUNCS-1;
+      s->name = "other";
+   }
+   lastName = fn;
+   lastStats = s;
+   return s;
+}
+
+void statsDraw(const char* fn,GLenum mode,unsigned long verts)
+{
+   RenderStats* s = Func(fn);
+   s->draws++;
+   if (mode<STATS_NMODE) s->prims[mode]++;
+   s->verts += verts;
+}
+
+void statsVerts(const char* fn,unsigned long verts)
+{
+   Func(fn)->verts += verts;
+}
+
+void statsBind(const char* fn,int redundant)
+{
+   RenderStats* s = Func(fn);
+   s->binds++;
+   if (redundant) s->redundant++;
+}
+
+void statsEnable(const char* fn,int redundant)
+{
+   RenderStats* s = Func(fn);
+   s->enables++;
+   if (redundant) s->redundant++;
+}
+
+void statsPush(const char* fn)
+{
+   Func(fn)->pushes++;
+}
+
+static int ByVerts(const void* a,const void* b)
+{
+   const RenderStats* A = (const RenderStats*)a;
+   const RenderStats* B = (const RenderStats*)b;
+   if (A->verts!=B->verts) return A->verts<B->verts ? 1 : -1;
+   if (A->draws!=B->draws) return A->draws<B->draws ? 1 : -1;
+   return strcmp(A->name,B->name);
+}
+
+//
+//  Keep this frame's counts for the queries and start the next frame
+//
+void statsFrameEnd(void)
+{
+   memset(&total,0,sizeof(total));
+   total.name = "total";
+   ndone = 0;
+   for (int k=0;k<STATS_FUNCS;k++)
+   {
+      RenderStats* s = cur+k;
+      if (!s->name) continue;
+      if (s->draws || s->verts || s->binds || s->enables || s->pushes)
+      {
+         done[ndone++] = *s;
+         total.draws += s->draws;
+         for (int m=0;m<STATS_NMODE;m++)
+            total.prims[m] += s->prims[m];
+         total.verts += s->verts;
+         total.binds += s->binds;
+         total.enables += s->enables;
+         total.redundant += s->redundant;
+         total.pushes += s->pushes;
+      }
+      const char* name = s->name;
+      memset(s,0,sizeof(RenderStats));
+      s->name = name;
+   }
+   qsort(done,ndone,sizeof(RenderStats),ByVerts);
+   frameNo++;
+   if (statsPeriod>0 && frameNo%statsPeriod==0) statsPrint(stderr,5);
+}
+
+//
+//  Draw functions that did anything last frame; statsGet(0) did the most
+//
+int statsCount(void)
+{
+   return ndone;
+}
+
+const RenderStats* statsGet(int k)
+{
+   return (k>=0 && k<ndone) ? done+k : NULL;
+}
+
+//  NULL when fn drew nothing last frame
+const RenderStats* statsFind(const char* fn)
+{
+   for (int k=0;k<ndone;k++)
+      if (!strcmp(done[k].name,fn)) return done+k;
+   return NULL;
+}
+
+const RenderStats* statsTotal(void)
+{
+   return &total;
+}
+
+//
+//  Last frame on one line: totals, then the top draw functions by vertices
+//
+void statsPrint(FILE* f,int top)
+{
+   fprintf(f,"stats frame %ld: %lu verts in %lu draws (",frameNo,total.verts,total.draws);
+   const char* sep = "";
+   for (int m=0;m<STATS_NMODE;m++)
+      if (total.prims[m])
+      {
+         fprintf(f,"%s%lu %s",sep,total.prims[m],modeName[m]);
+         sep = ", ";
+      }
+   fprintf(f,"), %lu binds, %lu enables (%lu redundant), %lu pushes; most vertices:",
+      total.binds,total.enables,total.redundant,total.pushes);
+   for (int k=0;k<top && k<ndone;k++)
+      fprintf(f," %s %lu",done[k].name,done[k].verts);
+   fprintf(f,"\n");
+}
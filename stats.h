@@ -0,0 +1,61 @@
+#ifndef STATS_H
+#define STATS_H
+
+//
+//  Render statistics
+//  Kevin McMahon
+//
+//  Per-frame counts of the drawing work, by the draw function that asked
+//  for it.  The capture wrappers (capture.h) pass their caller's __func__
+//  along, so every glBegin block, vertex, texture bind, enable/disable and
+//  matrix push in main.c lands on chair(), drawCheckerboard(),
+//  basketballHoop() and so on without any code in them.  Cached batches
+//  remember which function recorded each run of their vertices (MeshRun in
+//  capture.h), so drawMeshBatch and drawMeshInstanced count their vertices
+//  under those functions too.  statsFrameEnd() closes
+//  the frame; the query functions then report that frame, busiest first,
+//  and every statsPeriod frames one line of it goes to stderr.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STATS_FUNCS  256   // draw functions tracked (the rest count as "other")
+#define STATS_NMODE  10    // GL_POINTS .. GL_POLYGON
+#define STATS_PERIOD 120   // frames between log lines when logging
+
+typedef struct
+{
+   const char* name;               // draw function
+   unsigned long draws;            // glBegin blocks and array draws
+   unsigned long prims[STATS_NMODE];  // draws by primitive type
+   unsigned long verts;
+   unsigned long binds;            // texture binds asked for
+   unsigned long enables;          // glEnable/glDisable calls
+   unsigned long redundant;        // binds and enables already in effect
+   unsigned long pushes;           // glPushMatrix calls
+} RenderStats;
+
+extern int statsPeriod;            // frames between log lines, 0 = quiet
+
+// Counting (called by the capture layer)
+void statsDraw(const char* fn,GLenum mode,unsigned long verts);
+void statsVerts(const char* fn,unsigned long verts);
+void statsBind(const char* fn,int redundant);
+void statsEnable(const char* fn,int redundant);
+void statsPush(const char* fn);
+
+// Last finished frame
+void statsFrameEnd(void);
+int  statsCount(void);
+const RenderStats* statsGet(int k);
+const RenderStats* statsFind(const char* fn);
+const RenderStats* statsTotal(void);
+void statsPrint(FILE* f,int top);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
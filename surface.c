@@ -0,0 +1,112 @@
+//  Dynamic display surfaces
+//  Kevin McMahon
+#include "CSCIx229.h"
+#include "surface.h"
+#include "profile.h"
+
+//
+//  Create the render target (1 on success)
+//
+int SurfaceInit(Surface* s,int w,int h,double x0,double y0,double x1,double y1)
+{
+   s->w = w;
+   s->h = h;
+   s->x0 = x0;
+   s->y0 = y0;
+   s->x1 = x1;
+   s->y1 = y1;
+   s->tex = s->fbo = 0;
+
+   int prev;
+   glGetIntegerv(GL_FRAMEBUFFER_BINDING,&prev);
+   glGenTextures(1,&s->tex);
+   glBindTexture(GL_TEXTURE_2D,s->tex);
+   glTexImage2D(GL_TEXTURE_2D,0,GL_RGBA,w,h,0,GL_RGBA,GL_UNSIGNED_BYTE,NULL);
+   //  Screens are mostly seen from a distance, so keep a mip chain
+   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR_MIPMAP_LINEAR);
+   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);
+   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
+   glGenerateMipmap(GL_TEXTURE_2D);
+   glGenFramebuffers(1,&s->fbo);
+   glBindFramebuffer(GL_FRAMEBUFFER,s->fbo);
+   glFramebufferTexture2D(GL_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_TEXTURE_2D,s->tex,0);
+   int ok = glCheckFramebufferStatus(GL_FRAMEBUFFER)==GL_FRAMEBUFFER_COMPLETE;
+   glBindFramebuffer(GL_FRAMEBUFFER,prev);
+   glBindTexture(GL_TEXTURE_2D,0);
+   if (!ok)
+   {
+      glDeleteFramebuffers(1,&s->fbo);
+      glDeleteTextures(1,&s->tex);
+      s->tex = s->fbo = 0;
+   }
+   ErrCheck("SurfaceInit");
+   return ok;
+}
+
+//
+//  Redirect drawing into the surface (transparent, unlit, no depth test)
+//
+void SurfaceBegin(Surface* s)
+{
+   glGetIntegerv(GL_FRAMEBUFFER_BINDING,&s->prevFbo);
+   glPushAttrib(GL_ALL_ATTRIB_BITS);
+   glBindFramebuffer(GL_FRAMEBUFFER,s->fbo);
+   glViewport(0,0,s->w,s->h);
+   glMatrixMode(GL_PROJECTION);
+   glPushMatrix();
+   glLoadIdentity();
+   glOrtho(s->x0,s->x1,s->y0,s->y1,-1,1);
+   glMatrixMode(GL_MODELVIEW);
+   glPushMatrix();
+   glLoadIdentity();
+   glDisable(GL_DEPTH_TEST);
+   glDisable(GL_LIGHTING);
+   glDisable(GL_BLEND);
+   glClearColor(0,0,0,0);
+   glClear(GL_COLOR_BUFFER_BIT);
+}
+
+//
+//  Back to the previous target; rebuild the mip chain
+//
+void SurfaceEnd(Surface* s)
+{
+   glMatrixMode(GL_PROJECTION);
+   glPopMatrix();
+   glMatrixMode(GL_MODELVIEW);
+   glPopMatrix();
+   glBindFramebuffer(GL_FRAMEBUFFER,s->prevFbo);
+   glBindTexture(GL_TEXTURE_2D,s->tex);
+   glGenerateMipmap(GL_TEXTURE_2D);
+   glPopAttrib();
+   ErrCheck("SurfaceEnd");
+}
+
+//
+//  Show the surface as one quad covering its content rectangle at depth z
+//  (current transform, unlit, blended over what is behind it).  The
+//  content is opaque on a cleared (0,0,0,0) background, so the texture is
+//  effectively premultiplied, which keeps mipmapped edges from darkening.
+//
+void SurfaceDraw(const Surface* s,double z)
+{
+   PROF_GL(glPushAttrib(GL_ENABLE_BIT|GL_COLOR_BUFFER_BIT|GL_TEXTURE_BIT|GL_CURRENT_BIT));
+   PROF_GL(glDisable(GL_LIGHTING));
+   PROF_GL(glEnable(GL_TEXTURE_2D));
+   PROF_GL(glBindTexture(GL_TEXTURE_2D,s->tex));
+   PROF_GL(glTexEnvi(GL_TEXTURE_ENV,GL_TEXTURE_ENV_MODE,GL_MODULATE));
+   PROF_GL(glEnable(GL_BLEND));
+   PROF_GL(glBlendFunc(GL_ONE,GL_ONE_MINUS_SRC_ALPHA));
+   PROF_GL(glColor3f(1,1,1));
+   PROF_GL(glBegin(GL_QUADS));
+   PROF_GL(glNormal3f(0,0,1));
+   PROF_GL(glTexCoord2f(0,0)); PROF_GL(glVertex3d(s->x0,s->y0,z));
+   PROF_GL(glTexCoord2f(1,0)); PROF_GL(glVertex3d(s->x1,s->y0,z));
+   PROF_GL(glTexCoord2f(1,1)); PROF_GL(glVertex3d(s->x1,s->y1,z));
+   PROF_GL(glTexCoord2f(0,1)); PROF_GL(glVertex3d(s->x0,s->y1,z));
+   PROF_GL(glEnd());
+   PROF_GL(glPopAttrib());
+   PROF_VERTS(4);
+   PROF_TRIS(2);
+}
@@ -0,0 +1,41 @@
+#ifndef SURFACE_H
+#define SURFACE_H
+
+//
+//  Dynamic display surfaces
+//  Kevin McMahon
+//
+//  A Surface is an off-screen render target (FBO + mipmapped RGBA texture)
+//  for in-arena screens: the content is drawn once between SurfaceBegin()
+//  and SurfaceEnd() whenever it changes, and every screen showing it is a
+//  single textured quad from then on.  The content is drawn unlit in the
+//  surface's own 2D coordinates (x0,y0)-(x1,y1) onto a transparent
+//  background, so it can be blended over a lit bezel.
+//
+//  SurfaceInit() returns 0 (and tex stays 0) without framebuffer objects;
+//  callers then draw the content directly as before.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+   int w,h;                 // texture size in pixels
+   double x0,y0,x1,y1;      // content coordinates covering the texture
+   unsigned int tex;        // color texture (0 when unavailable)
+   unsigned int fbo;
+   int prevFbo;             // framebuffer bound at SurfaceBegin
+} Surface;
+
+int  SurfaceInit(Surface* s,int w,int h,double x0,double y0,double x1,double y1);
+void SurfaceBegin(Surface* s);
+void SurfaceEnd(Surface* s);
+void SurfaceDraw(const Surface* s,double z);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
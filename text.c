@@ -0,0 +1,267 @@
+//  Cached scene text
+//  Kevin McMahon
+#include "CSCIx229.h"
+#include "text.h"
+#include "profile.h"
+
+#define TEXT_ORIGIN  64     // baseline height while capturing (clears the descenders)
+#define ATLAS_W      1024   // atlas texture, 16x6 cells for ' '..'~'
+#define ATLAS_H      512
+#define ATLAS_COLS   16
+#define ATLAS_CELLW  64     // cell in pixels
+#define ATLAS_CELLH  84
+#define ATLAS_BASE   18     // baseline above the bottom of the cell
+#define ATLAS_SCALE  0.5    // pixels per font unit
+#define ATLAS_LINE   4.0    // stroke width in pixels
+
+static unsigned int atlasTex = 0;
+static int atlasFailed = 0;
+
+//
+//  Capture the stroke segments of a string through feedback mode: with an
+//  ortho projection the size of the largest viewport, window coordinates
+//  are the font units themselves.  Returns the number of vertices (pairs
+//  of x,y in *xy, GL_LINES order).
+//
+static int StrokeSegments(const char* str,float** xy)
+{
+   int dims[2];
+   glGetIntegerv(GL_MAX_VIEWPORT_DIMS,dims);
+   glPushAttrib(GL_VIEWPORT_BIT|GL_TRANSFORM_BIT);
+   glViewport(0,0,dims[0],dims[1]);
+   glMatrixMode(GL_PROJECTION);
+   glPushMatrix();
+   glLoadIdentity();
+   glOrtho(0,dims[0],0,dims[1],-1,1);
+   glMatrixMode(GL_MODELVIEW);
+   glPushMatrix();
+   glLoadIdentity();
+
+   //  Grow the feedback buffer until the whole string fits
+   int size = 8192;
+   float* fb = NULL;
+   int n = -1;
+   while (n<0)
+   {
+      size *= 2;
+      fb = (float*)realloc(fb,size*sizeof(float));
+      if (!fb) Fatal("Cannot allocate text feedback buffer\n");
+      glFeedbackBuffer(size,GL_2D,fb);
+      glRenderMode(GL_FEEDBACK);
+      glLoadIdentity();
+      glTranslatef(0,TEXT_ORIGIN,0);
+      for (const char* p=str;*p;p++)
+         glutStrokeCharacter(GLUT_STROKE_ROMAN,*p);
+      n = glRenderMode(GL_RENDER);
+   }
+
+   glPopMatrix();
+   glMatrixMode(GL_PROJECTION);
+   glPopMatrix();
+   glPopAttrib();
+
+   //  Keep only the line segments
+   float* out = (float*)malloc((n+1)*sizeof(float));
+   if (!out) Fatal("Cannot allocate %d text vertices\n",n);
+   int nv = 0;
+   for (int i=0;i<n;)
+   {
+      int token = (int)fb[i++];
+      if (token==GL_LINE_TOKEN || token==GL_LINE_RESET_TOKEN)
+      {
+         for (int k=0;k<2;k++)
+         {
+            out[2*nv]   = fb[i++];
+            out[2*nv+1] = fb[i++] - TEXT_ORIGIN;
+            nv++;
+         }
+      }
+      else if (token==GL_POLYGON_TOKEN)
+         i += 1 + 2*(int)fb[i];
+      else if (token==GL_PASS_THROUGH_TOKEN)
+         i += 1;
+      else
+         i += 2;   // point, bitmap and pixel tokens carry one vertex
+   }
+   free(fb);
+   *xy = out;
+   return nv;
+}
+
+//
+//  Render the printable characters into the atlas once (0 if no FBO)
+//
+static int BuildAtlas(void)
+{
+   if (atlasTex) return 1;
+   if (atlasFailed) return 0;
+   int prev;
+   glGetIntegerv(GL_FRAMEBUFFER_BINDING,&prev);
+   glPushAttrib(GL_ALL_ATTRIB_BITS);
+   glGenTextures(1,&atlasTex);
+   glBindTexture(GL_TEXTURE_2D,atlasTex);
+   glTexImage2D(GL_TEXTURE_2D,0,GL_RGBA,ATLAS_W,ATLAS_H,0,GL_RGBA,GL_UNSIGNED_BYTE,NULL);
+   unsigned int fbo;
+   glGenFramebuffers(1,&fbo);
+   glBindFramebuffer(GL_FRAMEBUFFER,fbo);
+   glFramebufferTexture2D(GL_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_TEXTURE_2D,atlasTex,0);
+   if (glCheckFramebufferStatus(GL_FRAMEBUFFER)!=GL_FRAMEBUFFER_COMPLETE)
+   {
+      glBindFramebuffer(GL_FRAMEBUFFER,prev);
+      glDeleteFramebuffers(1,&fbo);
+      glDeleteTextures(1,&atlasTex);
+      glPopAttrib();
+      atlasTex = 0;
+      atlasFailed = 1;
+      return 0;
+   }
+
+   //  White glyphs on transparent white, so the draw color tints them
+   glViewport(0,0,ATLAS_W,ATLAS_H);
+   glMatrixMode(GL_PROJECTION);
+   glPushMatrix();
+   glLoadIdentity();
+   glOrtho(0,ATLAS_W,0,ATLAS_H,-1,1);
+   glMatrixMode(GL_MODELVIEW);
+   glPushMatrix();
+   glDisable(GL_LIGHTING);
+   glDisable(GL_TEXTURE_2D);
+   glDisable(GL_DEPTH_TEST);
+   glDisable(GL_BLEND);
+   glClearColor(1,1,1,0);
+   glClear(GL_COLOR_BUFFER_BIT);
+   glColor4f(1,1,1,1);
+   glLineWidth(ATLAS_LINE);
+   for (int ch=' ';ch<='~';ch++)
+   {
+      int cell = ch-' ';
+      glLoadIdentity();
+      glTranslated((cell%ATLAS_COLS)*ATLAS_CELLW,(cell/ATLAS_COLS)*ATLAS_CELLH+ATLAS_BASE,0);
+      glScaled(ATLAS_SCALE,ATLAS_SCALE,1);
+      glutStrokeCharacter(GLUT_STROKE_ROMAN,ch);
+   }
+   glPopMatrix();
+   glMatrixMode(GL_PROJECTION);
+   glPopMatrix();
+   glMatrixMode(GL_MODELVIEW);
+   glBindFramebuffer(GL_FRAMEBUFFER,prev);
+   glDeleteFramebuffers(1,&fbo);
+
+   //  Mipmapped so small, distant text stays readable
+   glBindTexture(GL_TEXTURE_2D,atlasTex);
+   glGenerateMipmap(GL_TEXTURE_2D);
+   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR_MIPMAP_LINEAR);
+   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+   glPopAttrib();
+   ErrCheck("BuildAtlas");
+   return 1;
+}
+
+//
+//  One textured quad (two triangles) per character: x,y,s,t
+//
+static int AtlasQuads(const char* str,float** xyst)
+{
+   float* out = (float*)malloc(6*4*strlen(str)*sizeof(float)+1);
+   if (!out) Fatal("Cannot allocate text quads\n");
+   const double y0 = -ATLAS_BASE/ATLAS_SCALE;
+   const double y1 = (ATLAS_CELLH-ATLAS_BASE)/ATLAS_SCALE;
+   double x = 0;
+   int nv = 0;
+   for (const char* p=str;*p;p++)
+   {
+      double w = glutStrokeWidth(GLUT_STROKE_ROMAN,*p);
+      if (*p>' ' && *p<='~')
+      {
+         int cell = *p-' ';
+         double s0 = (double)(cell%ATLAS_COLS)*ATLAS_CELLW/ATLAS_W;
+         double s1 = s0 + w*ATLAS_SCALE/ATLAS_W;
+         double t0 = (double)(cell/ATLAS_COLS)*ATLAS_CELLH/ATLAS_H;
+         double t1 = t0 + (double)ATLAS_CELLH/ATLAS_H;
+         const double v[6][4] = {{x,y0,s0,t0},{x+w,y0,s1,t0},{x+w,y1,s1,t1},
+                                 {x,y0,s0,t0},{x+w,y1,s1,t1},{x,y1,s0,t1}};
+         for (int k=0;k<6;k++,nv++)
+            for (int i=0;i<4;i++)
+               out[4*nv+i] = v[k][i];
+      }
+      x += w;
+   }
+   *xyst = out;
+   return nv;
+}
+
+//
+//  Lay out str in the requested font; no work if nothing changed.
+//  Returns 1 when the buffer was rebuilt.
+//
+int TextSet(TextMesh* text,int font,const char* str)
+{
+   if (text->vbo && text->font==font && !strncmp(text->str,str,TEXT_MAX-1)) return 0;
+   strncpy(text->str,str,TEXT_MAX-1);
+   text->str[TEXT_MAX-1] = 0;
+   //  Fall back to strokes when there is no framebuffer for the atlas
+   if (font==TEXT_ATLAS && !BuildAtlas()) font = TEXT_STROKE;
+   text->font = font;
+
+   text->width = 0;
+   for (const char* p=text->str;*p;p++)
+      text->width += glutStrokeWidth(GLUT_STROKE_ROMAN,*p);
+
+   float* v;
+   int stride = font==TEXT_ATLAS ? 4 : 2;
+   text->nverts = font==TEXT_ATLAS ? AtlasQuads(text->str,&v) : StrokeSegments(text->str,&v);
+   if (!text->vbo) glGenBuffers(1,&text->vbo);
+   glBindBuffer(GL_ARRAY_BUFFER,text->vbo);
+   glBufferData(GL_ARRAY_BUFFER,text->nverts*stride*sizeof(float),v,GL_STATIC_DRAW);
+   glBindBuffer(GL_ARRAY_BUFFER,0);
+   free(v);
+   return 1;
+}
+
+//
+//  Draw with the current color and transform (font units)
+//
+void TextDraw(const TextMesh* text)
+{
+   if (!text->nverts) return;
+   PROF_GL(glBindBuffer(GL_ARRAY_BUFFER,text->vbo));
+   PROF_GL(glEnableClientState(GL_VERTEX_ARRAY));
+   if (text->font==TEXT_ATLAS)
+   {
+      //  Blend the glyph edges; the empty part of each cell writes no depth
+      PROF_GL(glPushAttrib(GL_ENABLE_BIT|GL_COLOR_BUFFER_BIT|GL_TEXTURE_BIT));
+      PROF_GL(glEnable(GL_TEXTURE_2D));
+      PROF_GL(glBindTexture(GL_TEXTURE_2D,atlasTex));
+      PROF_GL(glTexEnvi(GL_TEXTURE_ENV,GL_TEXTURE_ENV_MODE,GL_MODULATE));
+      PROF_GL(glEnable(GL_BLEND));
+      PROF_GL(glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA));
+      PROF_GL(glEnable(GL_ALPHA_TEST));
+      PROF_GL(glAlphaFunc(GL_GREATER,0.05));
+      PROF_GL(glEnableClientState(GL_TEXTURE_COORD_ARRAY));
+      PROF_GL(glVertexPointer(2,GL_FLOAT,4*sizeof(float),(void*)0));
+      PROF_GL(glTexCoordPointer(2,GL_FLOAT,4*sizeof(float),(void*)(2*sizeof(float))));
+      PROF_GL(glDrawArrays(GL_TRIANGLES,0,text->nverts));
+      PROF_GL(glDisableClientState(GL_TEXTURE_COORD_ARRAY));
+      PROF_GL(glPopAttrib());
+      PROF_TRIS(text->nverts/3);
+   }
+   else
+   {
+      PROF_GL(glVertexPointer(2,GL_FLOAT,0,(void*)0));
+      PROF_GL(glDrawArrays(GL_LINES,0,text->nverts));
+   }
+   PROF_GL(glDisableClientState(GL_VERTEX_ARRAY));
+   PROF_GL(glBindBuffer(GL_ARRAY_BUFFER,0));
+   PROF_VERTS(text->nverts);
+}
+
+//
+//  Release the buffer
+//
+void TextFree(TextMesh* text)
+{
+   if (text->vbo) glDeleteBuffers(1,&text->vbo);
+   text->vbo = 0;
+   text->nverts = 0;
+   text->str[0] = 0;
+}
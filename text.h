@@ -0,0 +1,47 @@
+#ifndef TEXT_H
+#define TEXT_H
+
+//
+//  Cached scene text
+//  Kevin McMahon
+//
+//  A TextMesh holds one string already laid out in a vertex buffer, so
+//  drawing it is a single glDrawArrays no matter how often it is shown.
+//  TextSet() only rebuilds the buffer when the string actually changes.
+//
+//  TEXT_STROKE  GLUT Roman stroke font.  The glyph line segments are
+//               captured once per string through GL feedback mode.
+//  TEXT_ATLAS   The same glyphs pre-rendered into a texture atlas (thick,
+//               mipmapped) and drawn as one textured quad per character,
+//               so long strings cost two triangles per character.
+//
+//  Coordinates are stroke font units: the baseline is y=0, capitals are
+//  about 119 units tall and width is the sum of glutStrokeWidth.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TEXT_STROKE 0
+#define TEXT_ATLAS  1
+#define TEXT_MAX    64     // longest cached string
+
+typedef struct
+{
+   int font;              // TEXT_STROKE or TEXT_ATLAS
+   char str[TEXT_MAX];    // string in the buffer
+   float width;           // advance of the whole string
+   unsigned int vbo;
+   int nverts;            // GL_LINES (stroke) or GL_TRIANGLES (atlas)
+} TextMesh;
+
+int  TextSet(TextMesh* text,int font,const char* str);
+void TextDraw(const TextMesh* text);
+void TextFree(TextMesh* text);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,51 @@
+//  Sin/cos lookup tables
+//  Kevin McMahon
+#include "CSCIx229.h"
+#include "trig.h"
+
+//  One table per segment count, built on first use
+static TrigTable* trigCache[TRIG_MAX_SEGS+1];
+
+//
+//  Fill a table for n segments
+//
+static TrigTable* TrigBuild(int n)
+{
+   TrigTable* t = (TrigTable*)malloc(sizeof(TrigTable));
+   double* buf = (double*)malloc(2*(n+1)*sizeof(double));
+   if (!t || !buf) Fatal("Cannot allocate trig table for %d segments\n",n);
+   t->n = n;
+   t->c = buf;
+   t->s = buf + n+1;
+   const double step = 2*M_PI/n;
+   for (int k=0;k<n;k++)
+   {
+      t->c[k] = cos(k*step);
+      t->s[k] = sin(k*step);
+   }
+   t->c[n] = t->c[0];
+   t->s[n] = t->s[0];
+   return t;
+}
+
+//
+//  Table for n segments
+//
+const TrigTable* TrigTab(int n)
+{
+   if (n<1 || n>TRIG_MAX_SEGS) Fatal("Trig table with %d segments out of range\n",n);
+   if (!trigCache[n]) trigCache[n] = TrigBuild(n);
+   return trigCache[n];
+}
+
+//
+//  Build the tables the scene generators use before the first frame
+//
+void TrigInit(void)
+{
+   //  rods and legs, poles, spheres/nets/rim tube, chair-back arcs,
+   //  coolers, rim, ball seams, three-point arc, free-throw arc
+   const int counts[] = {6,10,12,20,24,32,40,60,64,128,256,360};
+   for (int k=0;k<(int)(sizeof(counts)/sizeof(counts[0]));k++)
+      TrigTab(counts[k]);
+}
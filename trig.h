@@ -0,0 +1,38 @@
+#ifndef TRIG_H
+#define TRIG_H
+
+//
+//  Sin/cos lookup tables
+//  Kevin McMahon
+//
+//  The ring generators (spheres, cylinders, cones, torus, seams) all step
+//  around a circle in equal segments, so the cosines and sines for a given
+//  segment count are computed once and shared.  Entry k is the angle
+//  360*k/n degrees; entry n repeats entry 0 exactly so closed rings meet.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TRIG_MAX_SEGS 1024
+
+typedef struct
+{
+   int n;        // segments around the circle
+   double* c;    // cos, n+1 entries
+   double* s;    // sin, n+1 entries
+} TrigTable;
+
+void TrigInit(void);
+const TrigTable* TrigTab(int n);
+
+//  Lookup for any whole multiple of the segment angle (wraps negative k)
+#define TrigCos(t,k) ((t)->c[(((k)%(t)->n)+(t)->n)%(t)->n])
+#define TrigSin(t,k) ((t)->s[(((k)%(t)->n)+(t)->n)%(t)->n])
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
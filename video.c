@@ -0,0 +1,228 @@
+//  Streaming video clips
+//  Kevin McMahon
+#include "CSCIx229.h"
+#include "video.h"
+#ifndef _WIN32
+#include <pthread.h>
+#include <sys/types.h>
+#endif
+
+#ifdef _WIN32
+//  No reader thread on Windows: callers keep their still frames
+VideoStream* VideoOpen(const char* file) {return NULL;}
+int  VideoUpdate(VideoStream* v,double t) {return 0;}
+unsigned int VideoTexture(const VideoStream* v) {return 0;}
+void VideoClose(VideoStream* v) {}
+#else
+
+//  One buffered frame
+typedef struct
+{
+   long frame;               // clip frame number (not wrapped), -1 if empty
+   unsigned char* pixels;
+} VideoSlot;
+
+struct VideoStream
+{
+   FILE* f;
+   unsigned int w,h;
+   unsigned int frames;       // frames in the clip
+   double fps;
+   long offset;               // file offset of frame 0
+   size_t bytes;              // bytes per frame
+   VideoSlot slot[VIDEO_RING];
+   //  Reader thread (everything below guarded by lock)
+   pthread_t reader;
+   pthread_mutex_t lock;
+   pthread_cond_t cond;
+   int running;
+   long want;                 // newest frame playback asked for
+   long done;                 // frames before this may be overwritten
+   //  GL side
+   long shown;                // frame in the texture
+   unsigned int tex;
+   unsigned int pbo[2];
+   int next;                  // PBO to fill next
+};
+
+//
+//  Little endian field
+//
+static unsigned int Get32(const unsigned char* p)
+{
+   return p[0] | (p[1]<<8) | (p[2]<<16) | ((unsigned int)p[3]<<24);
+}
+
+//
+//  Reader thread: fill the ring ahead of playback, jumping forward when
+//  playback has already moved past the next frame.  Frame r may only go
+//  into its slot once every frame that slot held before r is done with.
+//
+static void* VideoReader(void* arg)
+{
+   VideoStream* v = (VideoStream*)arg;
+   long r = 0;
+   pthread_mutex_lock(&v->lock);
+   while (1)
+   {
+      while (v->running)
+      {
+         if (r<v->want) r = v->want;
+         if (r-v->done<VIDEO_RING) break;
+         pthread_cond_wait(&v->cond,&v->lock);
+      }
+      if (!v->running) break;
+      //  Empty while it fills, so VideoUpdate cannot pick it
+      VideoSlot* s = v->slot + r%VIDEO_RING;
+      s->frame = -1;
+      pthread_mutex_unlock(&v->lock);
+
+      //  Read outside the lock; nobody else touches this slot now
+      off_t pos = v->offset + (off_t)(r%v->frames)*v->bytes;
+      int ok = !fseeko(v->f,pos,SEEK_SET) && fread(s->pixels,v->bytes,1,v->f)==1;
+
+      pthread_mutex_lock(&v->lock);
+      if (!ok)
+      {
+         fprintf(stderr,"Error reading video frame %ld\n",r%v->frames);
+         break;
+      }
+      s->frame = r++;
+      pthread_cond_broadcast(&v->cond);
+   }
+   pthread_mutex_unlock(&v->lock);
+   return NULL;
+}
+
+//
+//  Open a packed clip and start reading (NULL if it cannot be opened)
+//
+VideoStream* VideoOpen(const char* file)
+{
+   FILE* f = fopen(file,"rb");
+   if (!f) return NULL;
+   unsigned char h[24];
+   if (fread(h,sizeof(h),1,f)!=1 || memcmp(h,"VID1",4)) Fatal("%s is not a packed video clip\n",file);
+
+   VideoStream* v = (VideoStream*)calloc(1,sizeof(VideoStream));
+   if (!v) Fatal("Cannot allocate video stream\n");
+   v->f = f;
+   v->w = Get32(h+4);
+   v->h = Get32(h+8);
+   v->fps = Get32(h+12)/1000.0;
+   v->frames = Get32(h+16);
+   v->offset = Get32(h+20);
+   if (v->w<1 || v->h<1 || v->w>8192 || v->h>8192 || v->fps<=0 || v->frames<1)
+      Fatal("%s: bad clip header %ux%u %.3f fps %u frames\n",file,v->w,v->h,v->fps,v->frames);
+   v->bytes = (size_t)((3*v->w+3)&~3u)*v->h;
+   for (int k=0;k<VIDEO_RING;k++)
+   {
+      v->slot[k].frame = -1;
+      v->slot[k].pixels = (unsigned char*)malloc(v->bytes);
+      if (!v->slot[k].pixels) Fatal("Cannot allocate video ring for %s\n",file);
+   }
+
+   //  Texture the frames are streamed into, and the two upload buffers
+   glGenTextures(1,&v->tex);
+   glBindTexture(GL_TEXTURE_2D,v->tex);
+   glTexImage2D(GL_TEXTURE_2D,0,GL_RGB,v->w,v->h,0,GL_BGR,GL_UNSIGNED_BYTE,NULL);
+   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
+   glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+   glBindTexture(GL_TEXTURE_2D,0);
+   glGenBuffers(2,v->pbo);
+   v->shown = -1;
+   ErrCheck("VideoOpen");
+
+   pthread_mutex_init(&v->lock,NULL);
+   pthread_cond_init(&v->cond,NULL);
+   v->running = 1;
+   if (pthread_create(&v->reader,NULL,VideoReader,v)) Fatal("Cannot start video reader thread\n");
+   return v;
+}
+
+//
+//  Show the frame for clip time t (seconds).  Uses the newest buffered
+//  frame that is due, so a slow frame drops video frames instead of
+//  waiting on the disk.  Returns 1 if the texture changed.
+//
+int VideoUpdate(VideoStream* v,double t)
+{
+   long f = (long)(t*v->fps);
+   if (f<0) f = 0;
+   if (f==v->shown) return 0;
+
+   //  Pick the newest ready frame not past f
+   pthread_mutex_lock(&v->lock);
+   if (f>v->want) v->want = f;
+   VideoSlot* best = NULL;
+   for (int k=0;k<VIDEO_RING;k++)
+   {
+      VideoSlot* s = v->slot + k;
+      if (s->frame>v->shown && s->frame<=f && s->frame>=v->done && (!best || s->frame>best->frame))
+         best = s;
+   }
+   //  Nothing due is buffered yet: keep the current picture
+   if (!best)
+   {
+      //  Frames already behind playback can go
+      if (v->done<f) v->done = f;
+      pthread_cond_broadcast(&v->cond);
+      pthread_mutex_unlock(&v->lock);
+      return 0;
+   }
+   long frame = best->frame;
+   pthread_mutex_unlock(&v->lock);
+
+   //  Copy into a freshly orphaned PBO; the texture update reads from it
+   //  asynchronously while the other PBO is filled next time
+   glBindBuffer(GL_PIXEL_UNPACK_BUFFER,v->pbo[v->next]);
+   glBufferData(GL_PIXEL_UNPACK_BUFFER,v->bytes,NULL,GL_STREAM_DRAW);
+   void* dst = glMapBuffer(GL_PIXEL_UNPACK_BUFFER,GL_WRITE_ONLY);
+   if (dst)
+   {
+      memcpy(dst,best->pixels,v->bytes);
+      glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+      glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+      glPixelStorei(GL_UNPACK_ALIGNMENT,4);
+      glBindTexture(GL_TEXTURE_2D,v->tex);
+      glTexSubImage2D(GL_TEXTURE_2D,0,0,0,v->w,v->h,GL_BGR,GL_UNSIGNED_BYTE,(void*)0);
+      glPopClientAttrib();
+   }
+   glBindBuffer(GL_PIXEL_UNPACK_BUFFER,0);
+   v->next = 1-v->next;
+
+   //  Release this frame and everything before it to the reader
+   pthread_mutex_lock(&v->lock);
+   v->shown = frame;
+   v->done = frame+1;
+   pthread_cond_broadcast(&v->cond);
+   pthread_mutex_unlock(&v->lock);
+   return dst!=NULL;
+}
+
+unsigned int VideoTexture(const VideoStream* v)
+{
+   return v ? v->tex : 0;
+}
+
+//
+//  Stop the reader and free everything
+//
+void VideoClose(VideoStream* v)
+{
+   if (!v) return;
+   pthread_mutex_lock(&v->lock);
+   v->running = 0;
+   pthread_cond_broadcast(&v->cond);
+   pthread_mutex_unlock(&v->lock);
+   pthread_join(v->reader,NULL);
+   pthread_mutex_destroy(&v->lock);
+   pthread_cond_destroy(&v->cond);
+   glDeleteBuffers(2,v->pbo);
+   glDeleteTextures(1,&v->tex);
+   for (int k=0;k<VIDEO_RING;k++)
+      free(v->slot[k].pixels);
+   fclose(v->f);
+   free(v);
+}
+#endif
@@ -0,0 +1,38 @@
+#ifndef VIDEO_H
+#define VIDEO_H
+
+//
+//  Streaming video clips
+//  Kevin McMahon
+//
+//  A clip is one packed file (made by vidpack from BMP frames): a small
+//  header followed by every frame as raw 24-bit BGR rows, bottom row first
+//  and padded to 4 bytes, exactly like a BMP pixel array.  A reader thread
+//  keeps the next VIDEO_RING frames in a ring buffer.  VideoUpdate() picks
+//  the frame for the given clip time and uploads it through two PBOs used
+//  alternately (orphaned on every write).  When the player falls behind it
+//  skips frames rather than stalling, and memory stays at VIDEO_RING
+//  frames however long the clip is.  Clips loop.
+//
+//  Packed file layout (little endian, 24 byte header):
+//    "VID1", width, height, fps*1000, frame count, offset of frame 0
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VIDEO_RING 4      // frames buffered ahead of playback
+
+typedef struct VideoStream VideoStream;
+
+VideoStream* VideoOpen(const char* file);
+int  VideoUpdate(VideoStream* v,double t);
+unsigned int VideoTexture(const VideoStream* v);
+void VideoClose(VideoStream* v);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
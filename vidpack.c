@@ -0,0 +1,88 @@
+//
+//  vidpack - pack BMP frames into a streaming video clip (see video.h)
+//  Kevin McMahon
+//
+//  Usage: vidpack OUT.vid FPS FRAME.bmp...
+//
+//  Every frame must be an uncompressed 24-bit BMP of the same size.  The
+//  pixel arrays are copied as they are (BGR, bottom row first, rows padded
+//  to 4 bytes), so the player can hand them to OpenGL without conversion.
+//  Frames can come from any video with e.g.
+//     ffmpeg -i clip.mp4 -vf scale=512:256 frames/%05d.bmp
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void Fatal(const char* msg,const char* file)
+{
+   fprintf(stderr,"vidpack: %s %s\n",msg,file);
+   exit(1);
+}
+
+static unsigned int Get16(const unsigned char* p)
+{
+   return p[0] | (p[1]<<8);
+}
+static unsigned int Get32(const unsigned char* p)
+{
+   return p[0] | (p[1]<<8) | (p[2]<<16) | ((unsigned int)p[3]<<24);
+}
+static void Put32(unsigned char* p,unsigned int v)
+{
+   for (int k=0;k<4;k++)
+      p[k] = v>>(8*k);
+}
+
+int main(int argc,char* argv[])
+{
+   if (argc<4)
+   {
+      fprintf(stderr,"Usage: vidpack OUT.vid FPS FRAME.bmp...\n");
+      return 1;
+   }
+   double fps = atof(argv[2]);
+   if (fps<=0) Fatal("bad frame rate",argv[2]);
+   FILE* out = fopen(argv[1],"wb");
+   if (!out) Fatal("cannot create",argv[1]);
+
+   unsigned int w=0,h=0,frames=argc-3;
+   size_t bytes = 0;
+   unsigned char* pixels = NULL;
+   for (int k=3;k<argc;k++)
+   {
+      FILE* f = fopen(argv[k],"rb");
+      unsigned char hdr[54];
+      if (!f || fread(hdr,sizeof(hdr),1,f)!=1) Fatal("cannot read",argv[k]);
+      if (hdr[0]!='B' || hdr[1]!='M') Fatal("not a BMP:",argv[k]);
+      if (Get16(hdr+28)!=24 || Get32(hdr+30)!=0) Fatal("not an uncompressed 24-bit BMP:",argv[k]);
+      unsigned int fw = Get32(hdr+18);
+      unsigned int fh = Get32(hdr+22);
+      if (fh>=0x80000000u) Fatal("top-down BMPs are not supported:",argv[k]);
+      if (k==3)
+      {
+         //  First frame fixes the size; write the header
+         w = fw;
+         h = fh;
+         bytes = (size_t)((3*w+3)&~3u)*h;
+         pixels = (unsigned char*)malloc(bytes);
+         if (!pixels) Fatal("out of memory for",argv[k]);
+         unsigned char vh[24] = {'V','I','D','1'};
+         Put32(vh+4,w);
+         Put32(vh+8,h);
+         Put32(vh+12,(unsigned int)(1000*fps+0.5));
+         Put32(vh+16,frames);
+         Put32(vh+20,sizeof(vh));
+         if (fwrite(vh,sizeof(vh),1,out)!=1) Fatal("cannot write",argv[1]);
+      }
+      else if (fw!=w || fh!=h)
+         Fatal("frame size differs from the first frame:",argv[k]);
+      if (fseek(f,Get32(hdr+10),SEEK_SET) || fread(pixels,bytes,1,f)!=1) Fatal("short pixel data in",argv[k]);
+      if (fwrite(pixels,bytes,1,out)!=1) Fatal("cannot write",argv[1]);
+      fclose(f);
+   }
+   if (fclose(out)) Fatal("cannot write",argv[1]);
+   printf("%s: %u frames %ux%u at %g fps\n",argv[1],frames,w,h,fps);
+   free(pixels);
+   return 0;
+}